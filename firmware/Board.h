@@ -19,7 +19,10 @@
 
 /* ADC Channels */
 #define Board_ADC_CH2       0   /* MQ-7 CO sensor */
-#define Board_ADC_CH3       1   /* MEMS microphone */
+
+/* ADCBuf (continuous uDMA capture) and its channel indices */
+#define Board_ADCBUF0       0
+#define Board_ADCBUF0_MIC   0   /* CH3 - MEMS microphone */
 
 /* GPIO — indices 0,1 are used by LaunchPad LEDs (D10, D9) in SDK */
 #define Board_GPIO_BUZZER   2   /* P64 - buzzer via transistor */
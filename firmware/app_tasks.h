@@ -0,0 +1,47 @@
+#ifndef APP_TASKS_H
+#define APP_TASKS_H
+
+/*
+ * Application tasks, created by main_freertos.c
+ *
+ * The CO task owns the MQ-7 ADC and the alarm buzzer and runs at
+ * CO_SAMPLE_HZ. The sensing task drives the I2C engine (i2c_bus.h),
+ * which then runs from interrupts. The mic task owns the microphone
+ * and folds in each 10 ms DMA buffer the ADCBuf interrupt hands it,
+ * so no signal processing runs in interrupt context; it ranks below
+ * the sensing task, whose work is short, and above the network task.
+ * The CO and sensing tasks hand messages to the network task through
+ * one queue without ever blocking on it. The network task owns Wi-Fi, MQTT, the sample
+ * ring and the flash queue, so a broker stall only ever delays
+ * publishing.
+ * Priorities are FreeRTOS priorities (higher preempts lower); stack
+ * sizes are bytes.
+ */
+
+#define CO_TASK_PRIORITY        5
+#define CO_TASK_STACK           1536
+
+#define SENSOR_TASK_PRIORITY    4
+#define SENSOR_TASK_STACK       2048
+
+#define MIC_TASK_PRIORITY       3
+#define MIC_TASK_STACK          1024
+
+#define NET_TASK_PRIORITY       2
+#define NET_TASK_STACK          4096
+
+/* Messages in flight to the network task. Covers the longest network
+ * task stall (one broker connect attempt, a few seconds; backoff
+ * delays are spent receiving) with room for CO alarm changes, which go
+ * to the front, and connection events. */
+#define NET_QUEUE_DEPTH         8
+
+/* Create the inter-task queue. Call once before starting the tasks. */
+void App_init(void);
+
+void *coThread(void *arg0);
+void *sensorThread(void *arg0);
+void *micThread(void *arg0);
+void *netThread(void *arg0);
+
+#endif
@@ -0,0 +1,25 @@
+#include "boot_time.h"
+#include <ti/drivers/dpl/HwiP.h>
+#include <time.h>
+
+static uint32_t phase_ms[BOOT_PHASES];
+static volatile uint32_t reached;   /* Bit per phase */
+
+void BootTime_mark(BootPhase_t phase)
+{
+    if (reached & (1U << phase)) return;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    phase_ms[phase] = (uint32_t)ts.tv_sec * 1000U + (uint32_t)(ts.tv_nsec / 1000000);
+
+    /* Phases belong to different tasks but share the bit mask */
+    uintptr_t key = HwiP_disable();
+    reached |= 1U << phase;
+    HwiP_restore(key);
+}
+
+uint32_t BootTime_get(BootPhase_t phase)
+{
+    return (reached & (1U << phase)) ? phase_ms[phase] : BOOT_NOT_REACHED;
+}
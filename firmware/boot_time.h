@@ -0,0 +1,31 @@
+#ifndef BOOT_TIME_H
+#define BOOT_TIME_H
+
+#include <stdint.h>
+
+/*
+ * Boot-phase timestamps
+ *
+ * Milliseconds of uptime at which each start-up milestone was first
+ * reached. Each phase is marked by one task and read by any; later
+ * marks of a phase are ignored.
+ */
+
+typedef enum {
+    BOOT_WIFI_UP,           /* Station has an IP address */
+    BOOT_MQTT_UP,           /* Broker connected */
+    BOOT_FIRST_SAMPLE,      /* First sample taken */
+    BOOT_FIRST_VALID,       /* First sample with every sensor warmed up */
+    BOOT_FIRST_PUBLISH,     /* First sample accepted by the broker */
+    BOOT_PHASES
+} BootPhase_t;
+
+#define BOOT_NOT_REACHED    UINT32_MAX
+
+/* Record the current uptime for `phase` unless it is already set. */
+void BootTime_mark(BootPhase_t phase);
+
+/* Uptime in ms when `phase` was reached, or BOOT_NOT_REACHED. */
+uint32_t BootTime_get(BootPhase_t phase);
+
+#endif
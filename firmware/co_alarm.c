@@ -1,23 +1,42 @@
 #include "co_alarm.h"
+#include "config.h"
 #include "Board.h"
 #include <ti/drivers/GPIO.h>
 
-static float threshold_on;
-static float threshold_off;
+/* CO_FILTER_ALPHA in Q16, folded at compile time */
+#define CO_ALPHA_Q16    ((int32_t)(CO_FILTER_ALPHA * 65536.0f + 0.5f))
+
+/* Concentrations are in 0.001 ppm throughout */
+static int32_t threshold_on;
+static int32_t threshold_off;
 static bool alarm_active;
 
-void COAlarm_init(float alarm_ppm, float clear_ppm)
+/* Filter state and instrumentation, owned by the CO task. Other tasks
+ * only read `filtered` and `alarm_active`, single aligned words. */
+static int32_t window[3];
+static uint8_t window_len;
+static int32_t filtered = -1;
+static uint32_t last_ms;
+static uint32_t over_since_ms;
+static bool over;
+static COAlarmStats_t stats;
+
+void COAlarm_init(int32_t alarm_mppm, int32_t clear_mppm)
 {
     /* Validate thresholds: alarm must be above clear for hysteresis */
-    if (alarm_ppm <= clear_ppm) {
+    if (alarm_mppm <= clear_mppm) {
         /* Swap to safe defaults if misconfigured */
-        threshold_on = clear_ppm;
-        threshold_off = alarm_ppm;
+        threshold_on = clear_mppm;
+        threshold_off = alarm_mppm;
     } else {
-        threshold_on = alarm_ppm;
-        threshold_off = clear_ppm;
+        threshold_on = alarm_mppm;
+        threshold_off = clear_mppm;
     }
     alarm_active = false;
+    window_len = 0;
+    filtered = -1;
+    over = false;
+    stats = (COAlarmStats_t){0};
 
     GPIO_setConfig(Board_GPIO_BUZZER,
                    GPIO_CFG_OUT_STD | GPIO_CFG_OUT_LOW);
@@ -25,18 +44,87 @@ void COAlarm_init(float alarm_ppm, float clear_ppm)
     GPIO_write(Board_GPIO_BUZZER, 0);
 }
 
-bool COAlarm_check(float co_ppm)
+bool COAlarm_check(int32_t co_mppm)
 {
-    /* Guard against NaN from upstream sensor errors */
-    if (!(co_ppm == co_ppm)) return alarm_active;  /* NaN != NaN */
+    /* Guard against upstream sensor errors */
+    if (co_mppm < 0) return alarm_active;
 
-    if (!alarm_active && co_ppm >= threshold_on) {
+    if (!alarm_active && co_mppm >= threshold_on) {
         alarm_active = true;
         GPIO_write(Board_GPIO_BUZZER, 1);
-    } else if (alarm_active && co_ppm < threshold_off) {
+    } else if (alarm_active && co_mppm < threshold_off) {
         alarm_active = false;
         GPIO_write(Board_GPIO_BUZZER, 0);
     }
 
     return alarm_active;
 }
+
+static int32_t median3(int32_t a, int32_t b, int32_t c)
+{
+    if (a > b) { int32_t t = a; a = b; b = t; }
+    if (b > c) b = c;
+    return a > b ? a : b;
+}
+
+bool COAlarm_update(int32_t raw_mppm, uint32_t now_ms)
+{
+    if (raw_mppm < 0) return alarm_active;  /* ADC error */
+
+    if (stats.samples > 0 && now_ms - last_ms > stats.max_period_ms) {
+        stats.max_period_ms = now_ms - last_ms;
+    }
+    last_ms = now_ms;
+    stats.samples++;
+
+    /* Start of the current run of raw readings at or above the alarm
+     * level, for the latency measurement */
+    if (raw_mppm < threshold_on) {
+        over = false;
+    } else if (!over) {
+        over = true;
+        over_since_ms = now_ms;
+    }
+
+    window[0] = window[1];
+    window[1] = window[2];
+    window[2] = raw_mppm;
+    if (window_len < 3) window_len++;
+
+    int32_t m = window_len < 3 ? raw_mppm : median3(window[0], window[1], window[2]);
+    if (filtered < 0) {
+        filtered = m;
+    } else {
+        /* Round half away from zero so the average settles on m */
+        int64_t step = (int64_t)(m - filtered) * CO_ALPHA_Q16;
+        filtered += (int32_t)((step + (step < 0 ? -32768 : 32768)) / 65536);
+    }
+
+    bool was_active = alarm_active;
+    COAlarm_check(filtered);
+
+    if (alarm_active && !was_active) {
+        stats.alarms++;
+        stats.last_latency_ms = over ? now_ms - over_since_ms : 0;
+        if (stats.last_latency_ms > stats.max_latency_ms) {
+            stats.max_latency_ms = stats.last_latency_ms;
+        }
+    }
+
+    return alarm_active;
+}
+
+int32_t COAlarm_filtered(void)
+{
+    return filtered;
+}
+
+bool COAlarm_active(void)
+{
+    return alarm_active;
+}
+
+void COAlarm_getStats(COAlarmStats_t *out)
+{
+    *out = stats;
+}
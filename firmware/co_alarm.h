@@ -1,15 +1,39 @@
 #ifndef CO_ALARM_H
 #define CO_ALARM_H
 
+#include <stdint.h>
 #include <stdbool.h>
 
-/* Initialize CO alarm with threshold and clear levels (ppm).
- * Configures the buzzer GPIO pin. */
-void COAlarm_init(float alarm_ppm, float clear_ppm);
+typedef struct {
+    uint32_t samples;           /* Readings fed to COAlarm_update() */
+    uint32_t alarms;            /* Times the buzzer was switched on */
+    uint32_t max_period_ms;     /* Longest gap between readings */
+    uint32_t last_latency_ms;   /* Raw readings >= alarm level to buzzer on */
+    uint32_t max_latency_ms;
+} COAlarmStats_t;
+
+/* Initialize CO alarm with threshold and clear levels (0.001 ppm, as
+ * all concentrations here). Configures the buzzer GPIO pin. */
+void COAlarm_init(int32_t alarm_mppm, int32_t clear_mppm);
 
 /* Check CO level and control buzzer.
  * Returns true if alarm is active.
  * Uses hysteresis: activates at alarm_ppm, clears at clear_ppm. */
-bool COAlarm_check(float co_ppm);
+bool COAlarm_check(int32_t co_mppm);
+
+/* Feed one raw reading taken at now_ms through a median-of-3 spike
+ * filter and an exponential average (CO_FILTER_ALPHA), then into
+ * COAlarm_check(). Negative readings are ignored. Returns true
+ * if the alarm is active. Worst-case threshold-to-buzzer latency is
+ * max_period_ms + max_latency_ms from the statistics. */
+bool COAlarm_update(int32_t raw_mppm, uint32_t now_ms);
+
+/* Latest filtered concentration (-1 before the first reading) and
+ * alarm state; safe to call from other tasks. */
+int32_t COAlarm_filtered(void);
+bool COAlarm_active(void);
+
+/* Copy the latency statistics. */
+void COAlarm_getStats(COAlarmStats_t *stats);
 
 #endif
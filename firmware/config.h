@@ -5,8 +5,32 @@
 #define WIFI_SSID         "YourNetworkName"
 #define WIFI_PASS         "YourPassword"
 
+/* Fast connect: the credentials are kept in the NWP as a profile with
+ * the auto + fast connection policy, so after a reset it rejoins the
+ * last AP by itself without scanning. 0 joins explicitly every time. */
+#ifndef WIFI_FAST_CONNECT
+#define WIFI_FAST_CONNECT 1
+#endif
+
+/* Static IPv4 address instead of DHCP, e.g.
+ * #define WIFI_STATIC_IP SL_IPV4_VAL(192, 168, 1, 50)
+ * (reserve it on the router). Mask, gateway and DNS default to a /24
+ * behind 192.168.1.1. Undefined: DHCP. */
+#ifdef WIFI_STATIC_IP
+#ifndef WIFI_STATIC_MASK
+#define WIFI_STATIC_MASK      SL_IPV4_VAL(255, 255, 255, 0)
+#endif
+#ifndef WIFI_STATIC_GATEWAY
+#define WIFI_STATIC_GATEWAY   SL_IPV4_VAL(192, 168, 1, 1)
+#endif
+#ifndef WIFI_STATIC_DNS
+#define WIFI_STATIC_DNS       WIFI_STATIC_GATEWAY
+#endif
+#endif
+
 /* MQTT Broker (Mosquitto on Raspberry Pi) */
-#define MQTT_BROKER       "192.168.1.100"   /* Pi's static IP */
+#define MQTT_BROKER       "192.168.1.100"   /* Pi's static IP; a host name is
+                                               resolved once and cached */
 #define MQTT_PORT         1883              /* Local, no TLS needed on LAN */
 #define MQTT_CLIENT_ID    "env_monitor_01"
 #define MQTT_USER         "monitor"         /* Optional auth */
@@ -14,12 +38,251 @@
 
 /* MQTT Topic */
 #define MQTT_TOPIC        "home/env"
+#define MQTT_TOPIC_BIN    "home/env/bin"    /* Binary frames, see payload.h */
+#define MQTT_TOPIC_ALERT  "home/env/alert"  /* CO alarm on/off, sent at once */
+#define MQTT_TOPIC_DIAG   "home/env/diag"   /* Timing diagnostics, see payload.h */
+#define MQTT_TOPIC_RATE   "home/env/rate"   /* Sampling interval changes */
+#define MQTT_TOPIC_PROF   "home/env/prof"   /* Cycle profile, see profile.h */
+
+/* Reconnection (wifi_mqtt.h): after each failed join or broker connect
+ * the next try waits a random 50-100% of a delay that doubles from
+ * CONN_BACKOFF_MIN_MS up to CONN_BACKOFF_MAX_MS. The first try after a
+ * drop is immediate. A join with no address after CONN_JOIN_TIMEOUT_MS
+ * counts as failed and restarts the NWP. */
+#ifndef CONN_BACKOFF_MIN_MS
+#define CONN_BACKOFF_MIN_MS   1000
+#endif
+#ifndef CONN_BACKOFF_MAX_MS
+#define CONN_BACKOFF_MAX_MS   30000
+#endif
+#ifndef CONN_JOIN_TIMEOUT_MS
+#define CONN_JOIN_TIMEOUT_MS  20000
+#endif
+
+/* Payload encoding: JSON is read directly by Telegraf; BINARY is a
+ * packed fixed-point frame (~100 bytes vs ~520) that the Pi turns back
+ * into Influx line protocol with pi/envdecode. */
+#define PAYLOAD_JSON      0
+#define PAYLOAD_BINARY    1
+#ifndef PAYLOAD_FORMAT
+#define PAYLOAD_FORMAT    PAYLOAD_JSON
+#endif
 
 /* Timing */
-#define READ_INTERVAL_MS  30000
+#ifndef READ_INTERVAL_MS
+#define READ_INTERVAL_MS  30000             /* Sensor sampling period; the
+                                               initial one if adaptive */
+#endif
+#ifndef DIAG_INTERVAL_MS
+#define DIAG_INTERVAL_MS  600000            /* MQTT_TOPIC_DIAG period */
+#endif
+
+/* Polling periods of the slower I2C sensors; each sample carries the
+ * mean and spread of their readings since the last. No faster than
+ * the sensor produces new data: BME280 ~0.55 s in normal mode with
+ * 500 ms standby, BH1750 120-180 ms. The SGP30 is always ticked at
+ * 1 Hz. */
+#ifndef BME280_PERIOD_MS
+#define BME280_PERIOD_MS  1000
+#endif
+#ifndef BH1750_PERIOD_MS
+#define BH1750_PERIOD_MS  1000
+#endif
+#ifndef BMV080_PERIOD_MS
+#define BMV080_PERIOD_MS  1000              /* Bosch SDK: serve >= 1 Hz */
+#endif
+
+/* Batching: samples queue in a RAM ring buffer and are published
+ * BATCH_SIZE at a time, or sooner once the oldest queued sample is
+ * BATCH_FLUSH_MS old. BATCH_SIZE 1 publishes each sample as before;
+ * e.g. READ_INTERVAL_MS 10000 with BATCH_SIZE 6 gives 10 s resolution
+ * at one message per minute. While the broker is unreachable the ring
+ * holds up to SAMPLE_RING_DEPTH samples, then overwrites the oldest. */
+#ifndef BATCH_SIZE
+#define BATCH_SIZE        1
+#endif
+#ifndef BATCH_FLUSH_MS
+#define BATCH_FLUSH_MS    60000
+#endif
+#ifndef SAMPLE_RING_DEPTH
+#define SAMPLE_RING_DEPTH 64
+#endif
+
+/* Adaptive sampling (sample_rate.h): every RATE_EVAL_MS the sampling
+ * interval is shortened when a watched reading moves faster than its
+ * threshold per minute, and lengthened again once all are quiet for
+ * RATE_HOLD_MS, within RATE_MIN/MAX_INTERVAL_MS. Each change is
+ * published to MQTT_TOPIC_RATE. A threshold of 0 does not watch the
+ * reading. RATE_ADAPTIVE 0 samples every READ_INTERVAL_MS. */
+#ifndef RATE_ADAPTIVE
+#define RATE_ADAPTIVE         1
+#endif
+#ifndef RATE_MIN_INTERVAL_MS
+#define RATE_MIN_INTERVAL_MS  5000
+#endif
+#ifndef RATE_MAX_INTERVAL_MS
+#define RATE_MAX_INTERVAL_MS  120000
+#endif
+#ifndef RATE_EVAL_MS
+#define RATE_EVAL_MS          10000
+#endif
+#define RATE_SLEW_FASTER      4       /* Shortest step: 1/4 of the interval */
+#define RATE_SLOWER_PCT       25      /* Step up after each quiet hold */
+#define RATE_HOLD_MS          60000
+#define RATE_QUIET_PCT        50      /* Of the thresholds */
+#define RATE_THR_TEMP_CC      50      /* 0.5 C/min */
+#define RATE_THR_HUM_MRH      2000    /* 2 %RH/min */
+#define RATE_THR_PRESS_PA     30      /* 0.3 hPa/min */
+#define RATE_THR_ECO2         100     /* ppm/min */
+#define RATE_THR_CO_MPPM      2000    /* 2 ppm/min */
+#define RATE_THR_PM_DUG       50      /* 5 ug/m3/min, PM2.5 */
+
+/* Report by exception (report.h): a field is published only once it
+ * has moved more than its deadband from the value last published, and
+ * a sample with no such field is dropped. Every REPORT_HEARTBEAT_MS a
+ * complete sample goes out regardless. Deadbands are in the units of
+ * env_data.h. REPORT_BY_EXCEPTION 0 publishes every sample whole. */
+#ifndef REPORT_BY_EXCEPTION
+#define REPORT_BY_EXCEPTION   1
+#endif
+#ifndef REPORT_HEARTBEAT_MS
+#define REPORT_HEARTBEAT_MS   600000
+#endif
+#define REPORT_DB_TEMP_CC     20      /* 0.2 C */
+#define REPORT_DB_HUM_MRH     1000    /* 1 %RH */
+#define REPORT_DB_PRESS_PA    50      /* 0.5 hPa */
+#define REPORT_DB_ECO2        25      /* ppm */
+#define REPORT_DB_TVOC        10      /* ppb */
+#define REPORT_DB_CO_MPPM     1000    /* 1 ppm */
+#define REPORT_DB_LUX         10      /* lux */
+#define REPORT_DB_PM_DUG      10      /* 1 ug/m3, each of PM1/2.5/10 */
+#define REPORT_DB_NOISE_DDB   20      /* 2 dB, each noise level */
+
+/* Store-and-forward: when the ring fills during an outage its oldest
+ * FLASH_QUEUE_SEG_RECORDS samples are written to one serial-flash file
+ * (see flash_queue.c). At most FLASH_QUEUE_SEGMENTS files are kept,
+ * one 4 KB flash block each (96 KB, ~6.4 h at 30 s); beyond that the
+ * oldest is dropped. Once the broker is back the backlog is replayed
+ * FLASH_REPLAY_BATCH samples per message, no more than one message per
+ * FLASH_REPLAY_INTERVAL_MS and only while live samples are not waiting.
+ * Replayed JSON is always an array with "age" fields. */
+#ifndef FLASH_QUEUE_SEGMENTS
+#define FLASH_QUEUE_SEGMENTS      24
+#endif
+#ifndef FLASH_QUEUE_SEG_RECORDS
+#define FLASH_QUEUE_SEG_RECORDS   32      /* 108-byte samples */
+#endif
+#ifndef FLASH_REPLAY_BATCH
+#define FLASH_REPLAY_BATCH        8
+#endif
+#ifndef FLASH_REPLAY_INTERVAL_MS
+#define FLASH_REPLAY_INTERVAL_MS  5000
+#endif
+
+/* Low power: whenever every task is waiting, the MCU enters LPDS (low
+ * power deep sleep) if no driver holds it awake and the next wake-up
+ * is more than POWER_LPDS_LATENCY_US away; otherwise it waits in WFI
+ * sleep. The latency is reserved for leaving LPDS, so the SGP30 tick
+ * and the CO samples still run on time. Busy peripherals (I2C
+ * transfers, the mic's ADC capture) keep the MCU out of LPDS, so
+ * continuous mic capture rules it out: with POWER_LPDS the mic is
+ * duty-cycled (MIC_CAPTURE_PERIOD_MS). While connected, the NWP uses
+ * its low-power policy. 0 never enters LPDS. */
+#ifndef POWER_LPDS
+#define POWER_LPDS            1
+#endif
+#ifndef POWER_LPDS_LATENCY_US
+#define POWER_LPDS_LATENCY_US 20000
+#endif
+
+/* Microphone: 0 captures continuously, which keeps the MCU out of
+ * LPDS altogether (a DMA interrupt every 10 ms), so it needs
+ * POWER_LPDS 0. Otherwise the ADC runs for one 1 s window every
+ * MIC_CAPTURE_PERIOD_MS and stops in between; the noise levels then
+ * describe those windows only. Keep it within READ_INTERVAL_MS
+ * (RATE_MIN_INTERVAL_MS if adaptive), or some samples get no levels
+ * at all. */
+#ifndef MIC_CAPTURE_PERIOD_MS
+#if POWER_LPDS
+#define MIC_CAPTURE_PERIOD_MS 5000
+#else
+#define MIC_CAPTURE_PERIOD_MS 0
+#endif
+#endif
+
+/* Radio duty cycling, for battery builds: 1 stops the NWP between
+ * flushes while sampling and the CO alarm carry on, the samples
+ * queueing in the ring. Every RADIO_FLUSH_PERIOD_MS the NWP starts,
+ * rejoins from its profile (WIFI_FAST_CONNECT; WIFI_STATIC_IP also
+ * skips DHCP), sends everything queued and stops again. A CO alarm
+ * change wakes it at once, and it stays up while the alarm is on. A
+ * wake that has not reached the broker within RADIO_WAKE_MAX_MS gives
+ * up until the next period. Keep the period within SAMPLE_RING_DEPTH
+ * samples: a full ring wakes the NWP to spill to flash. A larger
+ * BATCH_SIZE sends each flush in fewer messages. */
+#ifndef RADIO_DUTY_CYCLE
+#define RADIO_DUTY_CYCLE      0
+#endif
+#ifndef RADIO_FLUSH_PERIOD_MS
+#define RADIO_FLUSH_PERIOD_MS 600000
+#endif
+#ifndef RADIO_WAKE_MAX_MS
+#define RADIO_WAKE_MAX_MS     30000
+#endif
+
+/* Cycle profiling (profile.h): 1 times the sensor drivers, payload
+ * building and MQTT_publish on the DWT cycle counter and publishes
+ * each scope's statistics to MQTT_TOPIC_PROF after every
+ * PROFILE_REPORT_SAMPLES samples. 0 compiles it out. */
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE          0
+#endif
+#ifndef PROFILE_REPORT_SAMPLES
+#define PROFILE_REPORT_SAMPLES  20
+#endif
+
+/* Static allocation: 1 gives every task a static stack and the network
+ * queue static storage, and keeps the MQTT client across reconnects,
+ * so nothing is taken from the FreeRTOS heap after the first broker
+ * connect. Needs configSUPPORT_STATIC_ALLOCATION in FreeRTOSConfig.h.
+ * The diagnostics report stack and heap high-water marks either way
+ * (mem_stats.h). */
+#ifndef STATIC_ALLOCATION
+#define STATIC_ALLOCATION       0
+#endif
+
+/* Energy model (energy.h): typical power of each component in each
+ * state, in uW, from the datasheets at 3.3 V (the MQ-7 heater from
+ * 5 V). Calibrate against a meter. The runtime estimate assumes a
+ * battery or UPS of ENERGY_BATTERY_MWH, e.g. 10 Ah at 3.7 V. */
+#define ENERGY_MCU_AWAKE_UW     40000   /* 12.2 mA, running or in WFI */
+#define ENERGY_MCU_LPDS_UW      400     /* 120 uA, SRAM retained */
+#define ENERGY_NWP_AWAKE_UW     175000  /* 53 mA receiving */
+#define ENERGY_NWP_SLEEP_UW     2000    /* Connected idle, low-power policy */
+#define ENERGY_NWP_OFF_UW       15      /* Hibernate */
+#define ENERGY_SGP30_MEASURE_UW 159000  /* 48.2 mA for the 12 ms measurement */
+#define ENERGY_SGP30_IDLE_UW    8600    /* 2.6 mA */
+#define ENERGY_MQ7_HEATER_UW    350000
+#define ENERGY_MIC_CAPTURE_UW   4000    /* ADC and uDMA, plus the bias below */
+#define ENERGY_MIC_BIAS_UW      700     /* Mic and op-amp */
+#ifndef ENERGY_BATTERY_MWH
+#define ENERGY_BATTERY_MWH      37000
+#endif
 
 /* CO Alarm Thresholds */
 #define CO_ALARM_PPM      50
 #define CO_CLEAR_PPM      25
 
+/* CO is sampled CO_SAMPLE_HZ times a second (1..10) by its own task,
+ * independent of READ_INTERVAL_MS. Readings pass a median-of-3 spike
+ * filter and an exponential average with weight CO_FILTER_ALPHA
+ * before the alarm thresholds; a lower alpha rejects more noise but
+ * adds latency near the threshold. */
+#ifndef CO_SAMPLE_HZ
+#define CO_SAMPLE_HZ      4
+#endif
+#ifndef CO_FILTER_ALPHA
+#define CO_FILTER_ALPHA   0.5f
+#endif
+
 #endif
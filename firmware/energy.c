@@ -0,0 +1,117 @@
+#include "energy.h"
+#include "config.h"
+
+#include <ti/drivers/Power.h>
+#include <ti/drivers/power/PowerCC32XX.h>
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/devices/cc32xx/inc/hw_types.h>
+#include <ti/devices/cc32xx/driverlib/prcm.h>
+
+#define SLOW_CLK_HZ     32768U
+
+/* Typical power per state, in uW */
+static const uint32_t power_uw[ENERGY_COMPONENTS][ENERGY_STATES] = {
+    [ENERGY_MCU]   = { 0, ENERGY_MCU_LPDS_UW, ENERGY_MCU_AWAKE_UW },
+    [ENERGY_NWP]   = { ENERGY_NWP_OFF_UW, ENERGY_NWP_SLEEP_UW, ENERGY_NWP_AWAKE_UW },
+    [ENERGY_SGP30] = { 0, ENERGY_SGP30_IDLE_UW, ENERGY_SGP30_MEASURE_UW },
+    [ENERGY_MQ7]   = { 0, 0, ENERGY_MQ7_HEATER_UW },
+    [ENERGY_MIC]   = { 0, ENERGY_MIC_BIAS_UW, ENERGY_MIC_CAPTURE_UW },
+};
+
+static const uint8_t initial[ENERGY_COMPONENTS] = {
+    [ENERGY_MCU]   = ENERGY_AWAKE,
+    [ENERGY_NWP]   = ENERGY_OFF,
+    [ENERGY_SGP30] = ENERGY_SLEEP,
+    [ENERGY_MQ7]   = ENERGY_AWAKE,
+    [ENERGY_MIC]   = ENERGY_SLEEP,
+};
+
+typedef struct {
+    uint8_t  state;
+    uint64_t since;                 /* Slow clock at the last change */
+    uint64_t ticks[ENERGY_STATES];  /* Closed time in each state */
+} Account;
+
+static Account accounts[ENERGY_COMPONENTS];
+static uint64_t start;
+static uint32_t lpds_entries;
+static Power_NotifyObj lpds_notify;
+
+/* Close the time in the current state up to `now`. Interrupts masked. */
+static void close_state(Account *a, uint64_t now)
+{
+    a->ticks[a->state] += now - a->since;
+    a->since = now;
+}
+
+void Energy_set(EnergyComp_t comp, EnergyState_t state)
+{
+    uintptr_t key = HwiP_disable();
+    Account *a = &accounts[comp];
+    if (a->state != state) {
+        close_state(a, PRCMSlowClkCtrGet());
+        a->state = (uint8_t)state;
+    }
+    HwiP_restore(key);
+}
+
+/* Runs with interrupts disabled, just before LPDS and after it */
+static int_fast16_t lpds_event(uint_fast16_t eventType, uintptr_t eventArg,
+                               uintptr_t clientArg)
+{
+    (void)eventArg;
+    (void)clientArg;
+    if (eventType == PowerCC32XX_ENTERING_LPDS) {
+        lpds_entries++;
+        Energy_set(ENERGY_MCU, ENERGY_SLEEP);
+    } else {
+        Energy_set(ENERGY_MCU, ENERGY_AWAKE);
+    }
+    return Power_NOTIFYDONE;
+}
+
+void Energy_init(void)
+{
+    start = PRCMSlowClkCtrGet();
+    for (int i = 0; i < ENERGY_COMPONENTS; i++) {
+        accounts[i].state = initial[i];
+        accounts[i].since = start;
+    }
+    Power_registerNotify(&lpds_notify,
+                         PowerCC32XX_ENTERING_LPDS | PowerCC32XX_AWAKE_LPDS,
+                         lpds_event, 0);
+}
+
+void Energy_getStats(EnergyStats_t *out)
+{
+    Account snap[ENERGY_COMPONENTS];
+
+    uintptr_t key = HwiP_disable();
+    uint64_t now = PRCMSlowClkCtrGet();
+    for (int i = 0; i < ENERGY_COMPONENTS; i++) {
+        close_state(&accounts[i], now);
+        snap[i] = accounts[i];
+    }
+    out->lpds_entries = lpds_entries;
+    HwiP_restore(key);
+
+    /* uW x slow-clock ticks stays within 64 bits for decades at the
+     * MQ-7 heater's power */
+    uint64_t total_uj = 0;
+    for (int i = 0; i < ENERGY_COMPONENTS; i++) {
+        uint64_t uj = 0;
+        for (int s = 0; s < ENERGY_STATES; s++) {
+            out->comp[i].ms[s] = snap[i].ticks[s] * 1000U / SLOW_CLK_HZ;
+            uj += snap[i].ticks[s] * power_uw[i][s] / SLOW_CLK_HZ;
+        }
+        out->comp[i].energy_mj = uj / 1000U;
+        total_uj += uj;
+    }
+
+    uint64_t elapsed = now - start;
+    out->elapsed_ms = elapsed * 1000U / SLOW_CLK_HZ;
+    out->energy_mj = total_uj / 1000U;
+    out->mean_uw = elapsed ? (uint32_t)(total_uj * SLOW_CLK_HZ / elapsed) : 0;
+    out->runtime_h = out->mean_uw ? (uint32_t)((uint64_t)ENERGY_BATTERY_MWH * 1000U / out->mean_uw)
+                                  : UINT32_MAX;
+}
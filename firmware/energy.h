@@ -0,0 +1,63 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stdint.h>
+
+/*
+ * Energy accounting
+ *
+ * Time spent by each power-hungry component in each of its power
+ * states, and the energy that works out to at the typical power
+ * figures in config.h (ENERGY_*_UW). Drivers report their own state
+ * changes; the MCU's come from the Power driver's LPDS notifications.
+ * Time is kept on the 32.768 kHz slow clock, which keeps running
+ * through LPDS.
+ *
+ * The figures are datasheet typicals, not measurements, so the
+ * result is for comparing builds and spotting regressions; calibrate
+ * them against a meter on the real board before trusting a runtime.
+ */
+
+typedef enum {
+    ENERGY_MCU,             /* Awake (running or WFI) or in LPDS */
+    ENERGY_NWP,             /* Awake: starting, joining, connecting, sending;
+                             * asleep: connected, between beacons */
+    ENERGY_SGP30,           /* Awake while measuring, idle between */
+    ENERGY_MQ7,             /* Heater */
+    ENERGY_MIC,             /* Awake while the ADC captures; the mic and
+                             * op-amp bias otherwise */
+    ENERGY_COMPONENTS
+} EnergyComp_t;
+
+typedef enum {
+    ENERGY_OFF,
+    ENERGY_SLEEP,
+    ENERGY_AWAKE,
+    ENERGY_STATES
+} EnergyState_t;
+
+typedef struct {
+    uint64_t ms[ENERGY_STATES];     /* Time in each state */
+    uint64_t energy_mj;
+} EnergyCompStats_t;
+
+typedef struct {
+    uint64_t elapsed_ms;            /* Since Energy_init */
+    EnergyCompStats_t comp[ENERGY_COMPONENTS];
+    uint64_t energy_mj;             /* All components */
+    uint32_t mean_uw;
+    uint32_t runtime_h;             /* On ENERGY_BATTERY_MWH at mean_uw */
+    uint32_t lpds_entries;
+} EnergyStats_t;
+
+/* Start accounting from the power-on states: MCU awake, NWP off, the
+ * MQ-7 heater on, the SGP30 and the mic idle. Call once, after
+ * Power_init() and before the tasks start. */
+void Energy_init(void);
+
+/* Record that `comp` is now in `state`. Safe from interrupts. */
+void Energy_set(EnergyComp_t comp, EnergyState_t state);
+
+void Energy_getStats(EnergyStats_t *stats);
+
+#endif
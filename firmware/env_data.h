@@ -0,0 +1,84 @@
+#ifndef ENV_DATA_H
+#define ENV_DATA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Fields averaged over the sampling window (window_stat.h), in
+ * ENV_FIELD_* bit order */
+enum {
+    ENV_AGG_TEMP, ENV_AGG_HUM, ENV_AGG_PRESS, ENV_AGG_ECO2, ENV_AGG_TVOC,
+    ENV_AGG_CO, ENV_AGG_LUX, ENV_AGG_PM1, ENV_AGG_PM25, ENV_AGG_PM10,
+    ENV_AGG_COUNT
+};
+
+/* Spread of one field's readings over the window, packed as the
+ * binary record carries it (payload.h): in the field's binary scale,
+ * temp as i16. sd is ENV_NO_READING if the window had no readings. */
+typedef struct {
+    uint16_t min;
+    uint16_t max;
+    uint16_t sd;            /* Standard deviation */
+} EnvSpread_t;
+
+#define ENV_SPREAD_NONE ((EnvSpread_t){ 0, 0, ENV_NO_READING })
+
+/* One complete set of sensor readings, as published to MQTT, in
+ * integer fixed point so nothing between the drivers and the
+ * serializer needs soft-float. The ENV_AGG_* fields are window means;
+ * the noise levels describe the window themselves. Fields are ordered
+ * by size, so the struct has no interior padding (100 bytes). */
+typedef struct {
+    uint32_t press_pa;      /* Pa */
+    uint32_t hum_mrh;       /* 0.001 %RH */
+    int32_t  co_mppm;       /* 0.001 ppm (MQ-7); negative: no reading or
+                             * heater warming up */
+    int16_t  temp_cc;       /* 0.01 C */
+    uint16_t eco2;          /* ppm (SGP30); ENV_NO_READING while warming up */
+    uint16_t tvoc;          /* ppb */
+    uint16_t lux;           /* lux */
+    uint16_t pm1_dug;       /* 0.1 ug/m3 (BMV080); ENV_NO_READING if none */
+    uint16_t pm25_dug;
+    uint16_t pm10_dug;
+    uint16_t noise_ddb;     /* 0.1 dB (MEMS mic) */
+    uint16_t laeq_ddb;      /* 0.1 dB(A) over the sampling interval (MEMS mic) */
+    uint16_t lamax_ddb;     /* 0.1 dB(A), loudest 100 ms */
+    uint16_t lamin_ddb;     /* 0.1 dB(A), quietest 100 ms */
+    uint16_t la10_ddb;      /* 0.1 dB(A), exceeded 10% of the interval */
+    uint16_t la90_ddb;      /* 0.1 dB(A), exceeded 90% of the interval */
+    EnvSpread_t spread[ENV_AGG_COUNT];  /* Indexed by ENV_AGG_* */
+    bool     co_alarm;      /* true if CO above threshold */
+} EnvData_t;
+
+#define ENV_NO_READING  0xFFFF  /* For the optional 16-bit fields */
+
+/* Published fields, as bits of EnvSample_t.fields (report.h) */
+#define ENV_FIELD_TEMP      (1UL << 0)
+#define ENV_FIELD_HUM       (1UL << 1)
+#define ENV_FIELD_PRESS     (1UL << 2)
+#define ENV_FIELD_ECO2      (1UL << 3)
+#define ENV_FIELD_TVOC      (1UL << 4)
+#define ENV_FIELD_CO        (1UL << 5)
+#define ENV_FIELD_LUX       (1UL << 6)
+#define ENV_FIELD_PM1       (1UL << 7)
+#define ENV_FIELD_PM25      (1UL << 8)
+#define ENV_FIELD_PM10      (1UL << 9)
+#define ENV_FIELD_NOISE     (1UL << 10)
+#define ENV_FIELD_LAEQ      (1UL << 11)
+#define ENV_FIELD_LAMAX     (1UL << 12)
+#define ENV_FIELD_LAMIN     (1UL << 13)
+#define ENV_FIELD_LA10      (1UL << 14)
+#define ENV_FIELD_LA90      (1UL << 15)
+#define ENV_FIELD_CO_ALARM  (1UL << 16)
+#define ENV_FIELD_COUNT     17
+#define ENV_FIELDS_ALL      ((1UL << ENV_FIELD_COUNT) - 1)
+
+/* A sample stamped with the uptime (s) at which it was taken, and the
+ * fields that changed enough to publish. */
+typedef struct {
+    uint32_t  t_s;
+    EnvData_t data;
+    uint32_t  fields;       /* ENV_FIELD_* bits; never 0 once queued */
+} EnvSample_t;
+
+#endif
@@ -0,0 +1,358 @@
+#include "flash_queue.h"
+#include "sample_ring.h"
+#include "config.h"
+
+#include <ti/drivers/net/wifi/simplelink.h>
+#include <stddef.h>
+
+/*
+ * Log-structured segment files
+ *
+ * Each segment is written once, in a single open/write/close, and
+ * deleted once replayed; nothing is ever rewritten in place. Slots
+ * /envq/seg00.. are used round-robin in sequence order so the NWP file
+ * system spreads allocations, and flash is touched at most once per
+ * FLASH_QUEUE_SEG_RECORDS samples and only during an outage.
+ *
+ * File layout: SegHeader followed by `count` raw EnvSample_t records.
+ * The header carries the record size (a firmware with a different
+ * EnvSample_t discards old segments rather than misreading them) and a
+ * CRC-32 over the records. The file is committed by the NWP only on
+ * close, so a reset mid-write leaves no file; the CRC catches the rest.
+ *
+ * Replay is at-least-once: a segment is deleted only after its last
+ * sample is published, so a reset during replay resends that segment.
+ */
+
+#define SEG_MAGIC       0x31514E45UL        /* "ENQ1" */
+
+#if FLASH_QUEUE_SEGMENTS < 2 || FLASH_QUEUE_SEGMENTS > 100
+#error "FLASH_QUEUE_SEGMENTS must be 2..100"
+#endif
+#if FLASH_QUEUE_SEG_RECORDS < 1 || FLASH_QUEUE_SEG_RECORDS > SAMPLE_RING_DEPTH
+#error "FLASH_QUEUE_SEG_RECORDS must be 1..SAMPLE_RING_DEPTH"
+#endif
+
+typedef struct {
+    uint32_t magic;
+    uint16_t rec_size;
+    uint16_t count;
+    uint32_t seq;           /* Write order across boots */
+    uint32_t boot;          /* Boot that wrote the segment */
+    uint32_t last_t_s;      /* Newest sample's uptime in that boot */
+    uint32_t crc;           /* CRC-32 of the records */
+} SegHeader;
+
+#define SEG_FILE_MAX    (sizeof(SegHeader) + \
+                         FLASH_QUEUE_SEG_RECORDS * sizeof(EnvSample_t))
+
+/* A segment must fit one 4 KB flash block (fails to compile if not) */
+typedef char seg_fits_block[SEG_FILE_MAX <= 4096 ? 1 : -1];
+
+typedef struct {
+    bool     used;
+    bool     unusable;      /* Unreadable at boot: never written this boot */
+    uint16_t count;
+    uint16_t pos;           /* Samples already consumed */
+    uint32_t seq;
+    uint32_t shift_s;       /* Subtract from stored t_s to get this boot's uptime */
+} Segment;
+
+static Segment segs[FLASH_QUEUE_SEGMENTS];
+static uint16_t oldest;     /* Slot to replay next (valid when queued > 0) */
+static uint16_t next_slot;  /* Slot the next spill writes */
+static uint32_t next_seq;
+static uint32_t boot_id;
+static FlashQueueStats_t stats;
+
+static void seg_name(uint8_t name[16], uint16_t slot)
+{
+    static const char prefix[] = "/envq/seg";
+    uint16_t i = 0;
+    while (prefix[i] != '\0') {
+        name[i] = (uint8_t)prefix[i];
+        i++;
+    }
+    name[i++] = (uint8_t)('0' + slot / 10);
+    name[i++] = (uint8_t)('0' + slot % 10);
+    name[i] = '\0';
+}
+
+static uint32_t crc32_update(uint32_t crc, const void *buf, uint32_t len)
+{
+    const uint8_t *p = buf;
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+static void delete_slot(uint16_t slot)
+{
+    uint8_t name[16];
+    seg_name(name, slot);
+    if (sl_FsDel(name, 0) < 0) stats.errors++;
+
+    Segment *s = &segs[slot];
+    stats.queued = (uint16_t)(stats.queued - (s->count - s->pos));
+    stats.segments--;
+    s->used = false;
+}
+
+/* Point `oldest` at the used slot with the lowest sequence number */
+static void find_oldest(void)
+{
+    for (uint16_t i = 0; i < FLASH_QUEUE_SEGMENTS; i++) {
+        if (segs[i].used &&
+            (!segs[oldest].used || (int32_t)(segs[i].seq - segs[oldest].seq) < 0)) {
+            oldest = i;
+        }
+    }
+}
+
+typedef enum {
+    SLOT_EMPTY,             /* No file, or an invalid one (deleted) */
+    SLOT_LOADED,
+    SLOT_UNUSABLE           /* File system error: contents unknown */
+} SlotState;
+
+/* Read and validate one segment, filling hdr if loaded. Only a missing
+ * file is empty: after any other error the slot may still hold queued
+ * samples, so it must not be overwritten. */
+static SlotState load_slot(uint16_t slot, SegHeader *hdr)
+{
+    uint8_t name[16];
+    seg_name(name, slot);
+
+    int32_t fd = sl_FsOpen(name, SL_FS_READ, NULL);
+    if (fd == SL_ERROR_FS_FILE_NOT_EXISTS) return SLOT_EMPTY;
+    if (fd < 0) {
+        stats.errors++;
+        return SLOT_UNUSABLE;
+    }
+
+    bool read = sl_FsRead(fd, 0, (uint8_t *)hdr, sizeof(*hdr)) == (int32_t)sizeof(*hdr);
+    bool ok = read &&
+              hdr->magic == SEG_MAGIC &&
+              hdr->rec_size == sizeof(EnvSample_t) &&
+              hdr->count >= 1 && hdr->count <= FLASH_QUEUE_SEG_RECORDS;
+
+    uint32_t crc = 0;
+    for (uint16_t i = 0; ok && i < hdr->count; i++) {
+        EnvSample_t rec;
+        uint32_t off = sizeof(*hdr) + (uint32_t)i * sizeof(rec);
+        read = sl_FsRead(fd, off, (uint8_t *)&rec, sizeof(rec)) == (int32_t)sizeof(rec);
+        ok = read;
+        crc = crc32_update(crc, &rec, sizeof(rec));
+    }
+    ok = ok && crc == hdr->crc;
+    sl_FsClose(fd, NULL, NULL, 0);
+
+    if (ok) return SLOT_LOADED;
+    stats.errors++;
+    if (!read) return SLOT_UNUSABLE;
+    sl_FsDel(name, 0);      /* Corrupt or from another firmware */
+    return SLOT_EMPTY;
+}
+
+void FlashQueue_init(void)
+{
+    static SegHeader hdrs[FLASH_QUEUE_SEGMENTS];
+
+    stats = (FlashQueueStats_t){0};
+    oldest = 0;
+    next_slot = 0;
+    next_seq = 0;
+    boot_id = 0;
+
+    uint32_t newest_seq = 0;
+    for (uint16_t i = 0; i < FLASH_QUEUE_SEGMENTS; i++) {
+        Segment *s = &segs[i];
+        *s = (Segment){0};
+        SlotState state = load_slot(i, &hdrs[i]);
+        if (state == SLOT_UNUSABLE) s->unusable = true;
+        if (state != SLOT_LOADED) continue;
+
+        s->used = true;
+        s->count = hdrs[i].count;
+        s->seq = hdrs[i].seq;
+        if (stats.segments == 0 || (int32_t)(s->seq - newest_seq) > 0) {
+            newest_seq = s->seq;
+            next_slot = (uint16_t)((i + 1) % FLASH_QUEUE_SEGMENTS);
+        }
+        if (hdrs[i].boot >= boot_id) boot_id = hdrs[i].boot + 1;
+        stats.segments++;
+        stats.queued = (uint16_t)(stats.queued + s->count);
+    }
+    stats.recovered = stats.queued;
+    next_seq = newest_seq + 1;
+
+    /* Rebase earlier boots, newest first: each one is taken to have
+     * ended one second before the next began, at its last sample. */
+    uint32_t shift = 0;
+    uint32_t below = boot_id;
+    while (1) {
+        bool found = false;
+        uint32_t b = 0;
+        for (uint16_t i = 0; i < FLASH_QUEUE_SEGMENTS; i++) {
+            if (segs[i].used && hdrs[i].boot < below && (!found || hdrs[i].boot > b)) {
+                b = hdrs[i].boot;
+                found = true;
+            }
+        }
+        if (!found) break;
+
+        uint32_t end_s = 0;
+        for (uint16_t i = 0; i < FLASH_QUEUE_SEGMENTS; i++) {
+            if (segs[i].used && hdrs[i].boot == b && hdrs[i].last_t_s > end_s) {
+                end_s = hdrs[i].last_t_s;
+            }
+        }
+        shift += end_s + 1;
+        for (uint16_t i = 0; i < FLASH_QUEUE_SEGMENTS; i++) {
+            if (segs[i].used && hdrs[i].boot == b) segs[i].shift_s = shift;
+        }
+        below = b;
+    }
+
+    find_oldest();
+}
+
+bool FlashQueue_spill(void)
+{
+    uint16_t n = SampleRing_count();
+    if (n > FLASH_QUEUE_SEG_RECORDS) n = FLASH_QUEUE_SEG_RECORDS;
+    if (n == 0) return true;
+
+    /* Pass over slots that could not be read at boot */
+    for (uint16_t skipped = 0; segs[next_slot].unusable; skipped++) {
+        if (skipped == FLASH_QUEUE_SEGMENTS) {
+            stats.errors++;
+            return false;
+        }
+        next_slot = (uint16_t)((next_slot + 1) % FLASH_QUEUE_SEGMENTS);
+    }
+
+    /* Queue full: the slot after the newest segment holds the oldest */
+    if (segs[next_slot].used) {
+        stats.dropped += (uint32_t)(segs[next_slot].count - segs[next_slot].pos);
+        delete_slot(next_slot);
+        find_oldest();
+    }
+
+    SegHeader hdr = {
+        .magic = SEG_MAGIC,
+        .rec_size = sizeof(EnvSample_t),
+        .count = n,
+        .seq = next_seq,
+        .boot = boot_id,
+        .last_t_s = SampleRing_peek((uint16_t)(n - 1))->t_s,
+        .crc = 0,
+    };
+    for (uint16_t i = 0; i < n; i++) {
+        hdr.crc = crc32_update(hdr.crc, SampleRing_peek(i), sizeof(EnvSample_t));
+    }
+
+    uint8_t name[16];
+    seg_name(name, next_slot);
+    int32_t fd = sl_FsOpen(name, SL_FS_CREATE | SL_FS_OVERWRITE |
+                                 SL_FS_CREATE_NOSIGNATURE |
+                                 SL_FS_CREATE_MAX_SIZE(SEG_FILE_MAX), NULL);
+    if (fd < 0) {
+        stats.errors++;
+        return false;
+    }
+
+    bool ok = sl_FsWrite(fd, 0, (uint8_t *)&hdr, sizeof(hdr)) == (int32_t)sizeof(hdr);
+    for (uint16_t i = 0; ok && i < n; i++) {
+        uint32_t off = sizeof(hdr) + (uint32_t)i * sizeof(EnvSample_t);
+        ok = sl_FsWrite(fd, off, (uint8_t *)SampleRing_peek(i),
+                        sizeof(EnvSample_t)) == (int32_t)sizeof(EnvSample_t);
+    }
+
+    if (!ok) {
+        /* Abort: the NWP discards the uncommitted file */
+        sl_FsClose(fd, NULL, (const uint8_t *)"A", 1);
+        stats.errors++;
+        return false;
+    }
+    if (sl_FsClose(fd, NULL, NULL, 0) < 0) {
+        stats.errors++;
+        return false;
+    }
+
+    segs[next_slot] = (Segment){ .used = true, .count = n, .seq = next_seq };
+    if (stats.queued == 0) oldest = next_slot;
+    next_slot = (uint16_t)((next_slot + 1) % FLASH_QUEUE_SEGMENTS);
+    next_seq++;
+
+    stats.segments++;
+    stats.queued = (uint16_t)(stats.queued + n);
+    stats.spilled += n;
+    stats.writes++;
+    SampleRing_consume(n);
+    return true;
+}
+
+uint16_t FlashQueue_count(void)
+{
+    return stats.queued;
+}
+
+uint16_t FlashQueue_peek(EnvSample_t *out, uint16_t max)
+{
+    while (stats.queued > 0) {
+        Segment *s = &segs[oldest];
+        uint16_t left = (uint16_t)(s->count - s->pos);
+        uint16_t n = left < max ? left : max;
+
+        uint8_t name[16];
+        seg_name(name, oldest);
+        int32_t fd = sl_FsOpen(name, SL_FS_READ, NULL);
+        uint32_t len = (uint32_t)n * sizeof(EnvSample_t);
+        bool ok = fd >= 0 &&
+                  sl_FsRead(fd, sizeof(SegHeader) + (uint32_t)s->pos * sizeof(EnvSample_t),
+                            (uint8_t *)out, len) == (int32_t)len;
+        if (fd >= 0) sl_FsClose(fd, NULL, NULL, 0);
+
+        if (ok) {
+            for (uint16_t i = 0; i < n; i++) out[i].t_s -= s->shift_s;
+            return n;
+        }
+
+        /* Unreadable segment: drop it and try the next one */
+        stats.errors++;
+        stats.dropped += left;
+        delete_slot(oldest);
+        find_oldest();
+    }
+    return 0;
+}
+
+void FlashQueue_consume(uint16_t n)
+{
+    while (n > 0 && stats.queued > 0) {
+        Segment *s = &segs[oldest];
+        uint16_t take = (uint16_t)(s->count - s->pos);
+        if (take > n) take = n;
+
+        s->pos = (uint16_t)(s->pos + take);
+        stats.queued = (uint16_t)(stats.queued - take);
+        stats.replayed += take;
+        n = (uint16_t)(n - take);
+
+        if (s->pos == s->count) {
+            delete_slot(oldest);
+            find_oldest();
+        }
+    }
+}
+
+void FlashQueue_getStats(FlashQueueStats_t *out)
+{
+    *out = stats;
+}
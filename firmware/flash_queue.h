@@ -0,0 +1,55 @@
+#ifndef FLASH_QUEUE_H
+#define FLASH_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "env_data.h"
+
+/*
+ * Store-and-forward queue in the SimpleLink serial flash
+ *
+ * Second tier behind the RAM sample ring: while the broker is down
+ * and the ring is full, its oldest FLASH_QUEUE_SEG_RECORDS samples are
+ * spilled into one segment file. Segments survive a reset and are
+ * replayed oldest first once the broker is back. The NWP must be
+ * started (Conn_start) before any call.
+ */
+
+typedef struct {
+    uint32_t spilled;       /* Samples written to flash since boot */
+    uint32_t replayed;      /* Samples published from flash since boot */
+    uint32_t recovered;     /* Samples found in flash at boot */
+    uint32_t dropped;       /* Samples lost to a full queue or bad segment */
+    uint32_t writes;        /* Segment files written since boot */
+    uint32_t errors;        /* Failed file system operations */
+    uint16_t segments;      /* Segment files currently in flash */
+    uint16_t queued;        /* Samples currently waiting in flash */
+} FlashQueueStats_t;
+
+/* Scan flash for segments left by earlier boots, discarding any that
+ * fail validation, and rebase their timestamps onto this boot's
+ * uptime. Their true age is unknown across a reset; it is taken as if
+ * the reset took no time, so replayed ages are lower bounds. A slot
+ * that cannot be read is neither replayed nor overwritten this boot. */
+void FlashQueue_init(void);
+
+/* Move up to FLASH_QUEUE_SEG_RECORDS of the oldest ring samples into a
+ * new segment. When all FLASH_QUEUE_SEGMENTS are in use the oldest
+ * segment is dropped first. Returns false (ring untouched) on error. */
+bool FlashQueue_spill(void);
+
+/* Number of samples waiting in flash. */
+uint16_t FlashQueue_count(void);
+
+/* Copy up to max of the oldest queued samples into out, with t_s on
+ * this boot's uptime scale. Returns the number copied. */
+uint16_t FlashQueue_peek(EnvSample_t *out, uint16_t max);
+
+/* Drop the n oldest samples (after they were published). A segment
+ * file is deleted once all of its samples are consumed. */
+void FlashQueue_consume(uint16_t n);
+
+/* Copy the current statistics. */
+void FlashQueue_getStats(FlashQueueStats_t *stats);
+
+#endif
@@ -0,0 +1,268 @@
+#include "i2c_bus.h"
+#include <ti/drivers/dpl/ClockP.h>
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/drivers/dpl/SemaphoreP.h>
+
+/*
+ * Queued I2C transaction engine
+ *
+ * At most one job is on the bus (`active`). When it completes, the
+ * callback records the device's settle deadline, reports the result
+ * and starts the first queued job whose device is ready. If every
+ * queued job is waiting for a device to settle, a one-shot ClockP
+ * timer restarts the engine at the earliest deadline. The queue is
+ * only touched with interrupts disabled, so tasks, the I2C callback
+ * and the timer can all submit.
+ */
+
+#define I2CBUS_HZ       100000      /* I2C_100kHz, the Params default */
+#define I2CBUS_CLOCKS   9           /* Per byte, including ACK */
+#define I2CBUS_CANCEL_MS 5          /* Wait for the driver after I2C_cancel */
+
+static I2C_Handle i2c;
+static uint_least8_t i2c_index;
+static I2C_Params i2c_params;
+static volatile bool resetting;     /* Controller being reopened */
+static ClockP_Handle timer;
+static SemaphoreP_Handle sync;
+static uint32_t tick_us;            /* ClockP tick period */
+static uint32_t init_tick;
+
+static I2CBusJob *queue;            /* Oldest first */
+static I2CBusJob *volatile active;
+static uint16_t queued;
+static I2CBusDevice *devices;
+static I2CBusStats_t stats;
+
+static void start_next(void);
+
+static uint32_t ms_to_ticks(uint32_t ms)
+{
+    return (ms * 1000 + tick_us - 1) / tick_us;
+}
+
+static void timer_fxn(uintptr_t arg)
+{
+    (void)arg;
+    start_next();
+}
+
+/* Completion of the active job, from the I2C interrupt (or directly
+ * if the transfer could not be started) */
+static void transfer_done(I2C_Handle handle, I2C_Transaction *txn, bool ok)
+{
+    (void)handle;
+    /* A job abandoned by I2CBus_run is gone; a completion racing the
+     * controller reset only frees the bus */
+    if (active == NULL || txn != &active->txn) {
+        start_next();
+        return;
+    }
+    I2CBusJob *job = txn->arg;
+    I2CBusDevice *dev = job->dev;
+
+    uint32_t bytes = 0;
+    if (job->writeCount > 0) bytes += 1 + (uint32_t)job->writeCount;
+    if (job->readCount > 0)  bytes += 1 + (uint32_t)job->readCount;
+    uint64_t bus_us = (uint64_t)bytes * I2CBUS_CLOCKS * 1000000 / I2CBUS_HZ;
+
+    dev->ready_tick = ClockP_getSystemTicks() + ms_to_ticks(job->settle_ms);
+    dev->counts.transactions++;
+    dev->counts.bus_us += bus_us;
+    stats.total.transactions++;
+    stats.total.bus_us += bus_us;
+    if (!ok) {
+        dev->counts.errors++;
+        stats.total.errors++;
+    }
+
+    job->ok = ok;
+    job->pending = false;
+    active = NULL;
+
+    if (job->done != NULL) job->done(job, ok);
+    if (job->wake) SemaphoreP_post(sync);
+    start_next();
+}
+
+/* Put the first job whose device is ready on the bus, unless one is
+ * already there */
+static void start_next(void)
+{
+    uintptr_t key = HwiP_disable();
+    if (active != NULL || resetting) {
+        HwiP_restore(key);
+        return;
+    }
+
+    uint32_t now = ClockP_getSystemTicks();
+    int32_t wait = INT32_MAX;
+    I2CBusJob *job = NULL;
+    for (I2CBusJob **pp = &queue; *pp != NULL; pp = &(*pp)->next) {
+        int32_t left = (int32_t)((*pp)->dev->ready_tick - now);
+        if (left <= 0) {
+            job = *pp;
+            *pp = job->next;
+            queued--;
+            break;
+        }
+        if (left < wait) wait = left;
+    }
+    active = job;
+    HwiP_restore(key);
+
+    if (job == NULL) {
+        if (wait != INT32_MAX) {
+            ClockP_stop(timer);
+            ClockP_setTimeout(timer, (uint32_t)wait);
+            ClockP_start(timer);
+        }
+        return;
+    }
+
+    job->txn = (I2C_Transaction){0};
+    job->txn.targetAddress = job->dev->addr;
+    job->txn.writeBuf = job->writeBuf;
+    job->txn.writeCount = job->writeCount;
+    job->txn.readBuf = job->readBuf;
+    job->txn.readCount = job->readCount;
+    job->txn.arg = job;
+    if (i2c == NULL || !I2C_transfer(i2c, &job->txn)) {
+        transfer_done(i2c, &job->txn, false);
+    }
+}
+
+bool I2CBus_init(uint_least8_t index)
+{
+    I2C_Params_init(&i2c_params);
+    i2c_params.transferMode = I2C_MODE_CALLBACK;
+    i2c_params.transferCallbackFxn = transfer_done;
+
+    i2c_index = index;
+    i2c = I2C_open(index, &i2c_params);
+    if (i2c == NULL) return false;
+
+    ClockP_Params clock_params;
+    ClockP_Params_init(&clock_params);
+    timer = ClockP_create(timer_fxn, 1, &clock_params);
+    sync = SemaphoreP_createBinary(0);
+    if (timer == NULL || sync == NULL) return false;
+
+    tick_us = ClockP_getSystemTickPeriod();
+    init_tick = ClockP_getSystemTicks();
+    return true;
+}
+
+void I2CBus_attach(I2CBusDevice *dev)
+{
+    dev->ready_tick = ClockP_getSystemTicks();
+    dev->next = devices;
+    devices = dev;
+}
+
+bool I2CBus_submit(I2CBusJob *job)
+{
+    uintptr_t key = HwiP_disable();
+    if (job->pending) {
+        HwiP_restore(key);
+        return false;
+    }
+    job->pending = true;
+    job->wake = false;
+    job->next = NULL;
+
+    I2CBusJob **pp = &queue;
+    while (*pp != NULL) pp = &(*pp)->next;
+    *pp = job;
+    if (++queued > stats.queued_max) stats.queued_max = queued;
+    HwiP_restore(key);
+
+    start_next();
+    return true;
+}
+
+/* Unlink a job that has not reached the bus. Returns false if it is
+ * on the bus (or already done). */
+static bool cancel(I2CBusJob *job)
+{
+    bool found = false;
+    uintptr_t key = HwiP_disable();
+    for (I2CBusJob **pp = &queue; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == job) {
+            *pp = job->next;
+            queued--;
+            job->pending = false;
+            job->ok = false;
+            found = true;
+            break;
+        }
+    }
+    HwiP_restore(key);
+    return found;
+}
+
+bool I2CBus_run(I2CBusJob *job, uint32_t timeout_ms)
+{
+    if (!I2CBus_submit(job)) return false;
+    job->wake = true;
+
+    /* A post left over from an earlier timed-out wait only costs one
+     * extra pass */
+    uint32_t deadline = ClockP_getSystemTicks() + ms_to_ticks(timeout_ms);
+    while (job->pending) {
+        int32_t left = (int32_t)(deadline - ClockP_getSystemTicks());
+        if (left <= 0 || SemaphoreP_pend(sync, (uint32_t)left) != SemaphoreP_OK) {
+            break;
+        }
+    }
+
+    /* The job is usually in the caller's stack frame: it must leave the
+     * engine, and the driver, before we return. A queued job is
+     * dropped. One on the bus is cancelled in the driver, which fails
+     * it through the callback; if even that does not come (SCL held
+     * low), the controller is reopened so the driver lets go of it. */
+    if (job->pending && !cancel(job)) {
+        stats.cancelled++;
+        I2C_cancel(i2c);
+        deadline = ClockP_getSystemTicks() + ms_to_ticks(I2CBUS_CANCEL_MS);
+        while (job->pending) {
+            int32_t left = (int32_t)(deadline - ClockP_getSystemTicks());
+            if (left <= 0 || SemaphoreP_pend(sync, (uint32_t)left) != SemaphoreP_OK) {
+                break;
+            }
+        }
+
+        uintptr_t key = HwiP_disable();
+        bool hung = job->pending;
+        if (hung) {
+            active = NULL;
+            job->pending = false;
+            job->ok = false;
+            stats.abandoned++;
+            resetting = true;
+        }
+        HwiP_restore(key);
+
+        if (hung) {
+            I2C_close(i2c);
+            i2c = I2C_open(i2c_index, &i2c_params);
+            resetting = false;
+            start_next();
+        }
+    }
+    job->wake = false;
+    return job->ok;
+}
+
+void I2CBus_getStats(I2CBusStats_t *out)
+{
+    uintptr_t key = HwiP_disable();
+    *out = stats;
+    HwiP_restore(key);
+    out->elapsed_us = (uint64_t)(ClockP_getSystemTicks() - init_tick) * tick_us;
+}
+
+const I2CBusDevice *I2CBus_devices(void)
+{
+    return devices;
+}
@@ -0,0 +1,99 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <ti/drivers/I2C.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Queued I2C transaction engine
+ *
+ * Owns the I2C controller in callback mode. Drivers queue jobs (one
+ * transaction each) and get a completion callback; the calling task
+ * does not wait for the bus. A job can leave its device busy for a
+ * settle time afterwards (a conversion, a power-up); later jobs for
+ * that device are held back until it has passed, while jobs for other
+ * devices keep the bus busy. Jobs for one device run in submission
+ * order.
+ *
+ * Jobs and devices are owned by the drivers, normally static; the
+ * engine links them into its lists and never allocates.
+ */
+
+typedef struct {
+    uint32_t transactions;  /* Transfers completed, good or bad */
+    uint32_t errors;        /* Transfers that failed (NACK, bus error) */
+    uint64_t bus_us;        /* Bus time, from bytes at the bit rate */
+} I2CBusCounts_t;
+
+typedef struct I2CBusDevice I2CBusDevice;
+
+struct I2CBusDevice {
+    const char     *name;
+    uint8_t         addr;
+    /* Owned by the engine */
+    uint32_t        ready_tick;     /* Settling until this ClockP tick */
+    I2CBusCounts_t  counts;
+    I2CBusDevice   *next;
+};
+
+#define I2CBUS_DEVICE(n, a)     { .name = (n), .addr = (a) }
+
+typedef struct I2CBusJob I2CBusJob;
+
+/* Called from interrupt context when a job completes. It may submit
+ * jobs (including this one) but must not block. */
+typedef void (*I2CBusDoneFxn)(I2CBusJob *job, bool ok);
+
+struct I2CBusJob {
+    I2CBusDevice   *dev;
+    const void     *writeBuf;
+    size_t          writeCount;
+    void           *readBuf;
+    size_t          readCount;
+    uint16_t        settle_ms;      /* Device busy for this long afterwards */
+    I2CBusDoneFxn   done;           /* May be NULL */
+    /* Owned by the engine */
+    I2C_Transaction txn;
+    I2CBusJob      *next;
+    volatile bool   pending;        /* Queued or on the bus */
+    volatile bool   ok;             /* Result of the last run */
+    bool            wake;           /* A task waits in I2CBus_run */
+};
+
+typedef struct {
+    I2CBusCounts_t total;
+    uint64_t       elapsed_us;      /* Since I2CBus_init, for utilisation */
+    uint16_t       queued_max;      /* Most jobs waiting at once */
+    uint32_t       cancelled;       /* Timed out on the bus, I2C_cancel'd */
+    uint32_t       abandoned;       /* Of those, no callback even then:
+                                     * the controller was reopened */
+} I2CBusStats_t;
+
+/* Open I2C controller `index` in callback mode. Returns false if it
+ * cannot be opened. Call once, from a task, before any other call. */
+bool I2CBus_init(uint_least8_t index);
+
+/* Register a device for per-device settling and counts. */
+void I2CBus_attach(I2CBusDevice *dev);
+
+/* Queue a job. Returns false if it is still pending from an earlier
+ * submit. Safe from tasks and from completion callbacks. */
+bool I2CBus_submit(I2CBusJob *job);
+
+/* Queue a job and block the calling task until it completes or
+ * timeout_ms passes; other tasks run meanwhile. On timeout a job still
+ * queued is withdrawn, and one already on the bus is cancelled with
+ * I2C_cancel (a few ms more at most, then the controller is reopened),
+ * so the job can live on the caller's stack. Returns the job's result
+ * (false if withdrawn or cancelled). One waiting task at a time. */
+bool I2CBus_run(I2CBusJob *job, uint32_t timeout_ms);
+
+/* Copy the bus totals; per-device counts are in each I2CBusDevice. */
+void I2CBus_getStats(I2CBusStats_t *stats);
+
+/* Registered devices, most recently attached first. */
+const I2CBusDevice *I2CBus_devices(void);
+
+#endif
@@ -3,145 +3,800 @@
  *
  * CC3220SF SimpleLink SDK
  *
- * Reads all sensors every 30 seconds, checks CO thresholds,
- * and publishes JSON data to a local MQTT broker.
+ * Four tasks (see app_tasks.h). The CO task samples the MQ-7 at
+ * CO_SAMPLE_HZ, drives the alarm and reports alarm changes to the
+ * network task for an immediate publish. The mic task filters the
+ * microphone buffers the ADCBuf callback hands it. The sensing task
+ * reads each sensor at its own rate, folds the readings into
+ * per-window statistics (window_stat.h), and every READ_INTERVAL_MS
+ * passes their means and spreads as a sample to the network task,
+ * which queues it in a RAM ring buffer and publishes queued samples to
+ * a local MQTT broker in batches of up to BATCH_SIZE. During a broker
+ * outage a full ring spills to serial flash, and the flash backlog is
+ * replayed at a limited rate once publishing succeeds. With
+ * RADIO_DUTY_CYCLE the NWP is stopped between flushes (see config.h).
+ * With RATE_ADAPTIVE the sampling interval follows how fast the
+ * readings move (sample_rate.h).
  *
  * The SGP30 requires a measure_iaq call every 1 second for its
- * on-chip baseline algorithm to work. The main loop runs at 1 Hz,
- * ticking the SGP30 each iteration and doing a full publish cycle
- * every READ_INTERVAL_MS / 1000 iterations.
+ * on-chip baseline algorithm to work. The sensing task runs each
+ * sensor at its own period from a table (see sensor_sched.h), ticking
+ * the SGP30 at 1 Hz and taking a full sample every READ_INTERVAL_MS.
+ * Network stalls cannot delay it. Sensor I2C traffic goes through the
+ * queued engine in i2c_bus.c, so conversion delays (SGP30, BH1750)
+ * never block the sensing task.
  */
 
-#include <ti/drivers/I2C.h>
 #include <ti/drivers/ADC.h>
+#include <ti/drivers/dpl/HwiP.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <stdio.h>
-#include <unistd.h>
+#include <time.h>
+
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <task.h>
 
 #include "config.h"
 #include "Board.h"
+#include "app_tasks.h"
+#include "boot_time.h"
+#include "i2c_bus.h"
 #include "sensor_bme280.h"
 #include "sensor_sgp30.h"
 #include "sensor_bh1750.h"
 #include "sensor_bmv080.h"
 #include "sensor_mq7.h"
 #include "sensor_mic.h"
+#include "sensor_sched.h"
 #include "co_alarm.h"
+#include "energy.h"
+#include "env_data.h"
+#include "flash_queue.h"
+#include "mem_stats.h"
+#include "payload.h"
+#include "profile.h"
+#include "report.h"
+#include "sample_rate.h"
+#include "sample_ring.h"
 #include "wifi_mqtt.h"
+#include "window_stat.h"
+
+#if BATCH_SIZE < 1 || BATCH_SIZE > 255 || BATCH_SIZE > SAMPLE_RING_DEPTH
+#error "BATCH_SIZE must be 1..255 and no larger than SAMPLE_RING_DEPTH"
+#endif
+#if FLASH_REPLAY_BATCH < 2 || FLASH_REPLAY_BATCH > 255
+#error "FLASH_REPLAY_BATCH must be 2..255 so replayed JSON carries ages"
+#endif
+#if CO_SAMPLE_HZ < 1 || CO_SAMPLE_HZ > 10
+#error "CO_SAMPLE_HZ must be 1..10"
+#endif
+#if RADIO_DUTY_CYCLE && RADIO_WAKE_MAX_MS >= RADIO_FLUSH_PERIOD_MS
+#error "RADIO_WAKE_MAX_MS must be shorter than RADIO_FLUSH_PERIOD_MS"
+#endif
+#if RATE_ADAPTIVE && (READ_INTERVAL_MS < RATE_MIN_INTERVAL_MS || \
+                      READ_INTERVAL_MS > RATE_MAX_INTERVAL_MS)
+#error "READ_INTERVAL_MS must be within RATE_MIN/MAX_INTERVAL_MS"
+#endif
+
+/* Longest sampling window; its CO readings must fit a WindowStat_t */
+#if RATE_ADAPTIVE
+#define WINDOW_MAX_MS   RATE_MAX_INTERVAL_MS
+#else
+#define WINDOW_MAX_MS   READ_INTERVAL_MS
+#endif
+#if WINDOW_MAX_MS / 1000 * CO_SAMPLE_HZ >= WINDOW_STAT_MAX_N
+#error "Sampling window too long for WINDOW_STAT_MAX_N CO readings"
+#endif
+
+#define MESSAGE_RECORDS_MAX \
+    (BATCH_SIZE > FLASH_REPLAY_BATCH ? BATCH_SIZE : FLASH_REPLAY_BATCH)
+
+#if PAYLOAD_FORMAT == PAYLOAD_BINARY
+static uint8_t payload[PAYLOAD_BIN_BATCH_MAX(MESSAGE_RECORDS_MAX)];
+#define PAYLOAD_TOPIC   MQTT_TOPIC_BIN
+#else
+static char payload[PAYLOAD_JSON_BATCH_MAX(MESSAGE_RECORDS_MAX)];
+#define PAYLOAD_TOPIC   MQTT_TOPIC
+#endif
+
+/* Messages to the network task */
+#define NET_MSG_SAMPLE      0
+#define NET_MSG_CO_ALERT    1
+#define NET_MSG_DIAG        2
+#define NET_MSG_CONN        3       /* Connection event; only wakes the task */
+#define NET_MSG_RATE        4
+#define NET_MSG_PROFILE     5       /* Publish every profiling scope */
 
 typedef struct {
-    float    temperature;   /* C */
-    float    humidity;      /* %RH */
-    float    pressure;      /* hPa */
-    uint16_t eco2;          /* ppm */
-    uint16_t tvoc;          /* ppb */
-    float    co_ppm;        /* ppm (MQ-7) */
-    uint16_t lux;           /* lux */
-    float    pm1;           /* ug/m3 (BMV080) */
-    float    pm25;          /* ug/m3 (BMV080) */
-    float    pm10;          /* ug/m3 (BMV080) */
-    float    noise_db;      /* dB (MEMS mic) */
-    bool     co_alarm;      /* true if CO above threshold */
-} EnvData_t;
-
-void mainThread(void *arg0)
+    uint8_t type;
+    union {
+        EnvSample_t sample;
+        struct {
+            int32_t co_mppm;
+            bool  active;
+        } alert;
+        PayloadDiag_t diag;
+        SampleRateDecision_t rate;
+    } u;
+} NetMsg_t;
+
+static QueueHandle_t netQueue;
+
+/* Readings of the current sampling window, one per ENV_AGG_* field;
+ * CO is written by the CO task */
+static WindowStat_t window[ENV_AGG_COUNT];
+
+static uint32_t uptime_s(void)
 {
-    (void)arg0;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec;
+}
 
-    /* Initialize drivers */
-    I2C_Handle i2c = I2C_open(Board_I2C0, NULL);
-    if (i2c == NULL) {
-        while (1) {}  /* Fatal: I2C unavailable */
+static uint32_t uptime_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000U + (uint32_t)(ts.tv_nsec / 1000000);
+}
+
+static uint16_t age_s(const EnvSample_t *sample, uint32_t now_s)
+{
+    uint32_t age = now_s - sample->t_s;
+    return age > UINT16_MAX ? UINT16_MAX : (uint16_t)age;
+}
+
+/* Publish up to BATCH_SIZE of the oldest queued samples as one message.
+ * Samples leave the ring only once the broker has accepted them. */
+static bool publish_batch(uint32_t now_s)
+{
+    PROFILE_BEGIN(PAYLOAD_BUILD);
+    PayloadBatch_t batch;
+    PayloadBatch_begin(&batch, PAYLOAD_FORMAT, BATCH_SIZE,
+                       payload, sizeof(payload));
+
+    uint16_t n = 0;
+    const EnvSample_t *sample;
+    while ((sample = SampleRing_peek(n)) != NULL) {
+        if (!PayloadBatch_add(&batch, &sample->data, sample->fields,
+                              age_s(sample, now_s))) break;
+        n++;
+    }
+
+    size_t len = PayloadBatch_end(&batch);
+    PROFILE_END(PAYLOAD_BUILD);
+    if (len == 0) return true;
+    if (!MQTT_publish(PAYLOAD_TOPIC, payload, len)) return false;
+
+    SampleRing_consume(n);
+    return true;
+}
+
+/* Publish up to FLASH_REPLAY_BATCH samples from the flash backlog. */
+static bool replay_batch(uint32_t now_s)
+{
+    static EnvSample_t replay[FLASH_REPLAY_BATCH];
+    uint16_t avail = FlashQueue_peek(replay, FLASH_REPLAY_BATCH);
+
+    PROFILE_BEGIN(PAYLOAD_BUILD);
+    PayloadBatch_t batch;
+    PayloadBatch_begin(&batch, PAYLOAD_FORMAT, FLASH_REPLAY_BATCH,
+                       payload, sizeof(payload));
+
+    uint16_t n = 0;
+    while (n < avail &&
+           PayloadBatch_add(&batch, &replay[n].data, replay[n].fields,
+                            age_s(&replay[n], now_s))) {
+        n++;
+    }
+
+    size_t len = PayloadBatch_end(&batch);
+    PROFILE_END(PAYLOAD_BUILD);
+    if (len == 0) return true;
+    if (!MQTT_publish(PAYLOAD_TOPIC, payload, len)) return false;
+
+    FlashQueue_consume(n);
+    return true;
+}
+
+void App_init(void)
+{
+    Energy_init();
+#if PROFILE_ENABLE
+    Profile_init();
+#endif
+    SampleRate_init(READ_INTERVAL_MS);
+#if STATIC_ALLOCATION
+    static StaticQueue_t queue_buf;
+    static uint8_t queue_storage[NET_QUEUE_DEPTH * sizeof(NetMsg_t)];
+    netQueue = xQueueCreateStatic(NET_QUEUE_DEPTH, sizeof(NetMsg_t),
+                                  queue_storage, &queue_buf);
+#else
+    netQueue = xQueueCreate(NET_QUEUE_DEPTH, sizeof(NetMsg_t));
+    if (netQueue == NULL) {
+        while (1) {}  /* Fatal: out of heap */
     }
+#endif
+}
+
+void *coThread(void *arg0)
+{
+    (void)arg0;
+    MemStats_register(MEM_TASK_CO);
 
     ADC_Handle adc_co = ADC_open(Board_ADC_CH2, NULL);
     if (adc_co == NULL) {
         while (1) {}  /* Fatal: CO ADC unavailable */
     }
 
-    ADC_Handle adc_mic = ADC_open(Board_ADC_CH3, NULL);
-    if (adc_mic == NULL) {
-        while (1) {}  /* Fatal: Mic ADC unavailable */
+    PROFILE_BEGIN(MQ7_INIT);
+    MQ7_init(adc_co);
+    PROFILE_END(MQ7_INIT);
+    COAlarm_init(CO_ALARM_PPM * 1000, CO_CLEAR_PPM * 1000);
+
+    bool reported = false;
+
+    /* Reference for vTaskDelayUntil(): readings are released on a fixed
+     * grid, so their spacing does not stretch by the time each takes */
+    const TickType_t period = pdMS_TO_TICKS(1000 / CO_SAMPLE_HZ);
+    TickType_t woke = xTaskGetTickCount();
+
+    while (1) {
+        /* --- CO safety check (filtered, with hysteresis) --- */
+        PROFILE_BEGIN(MQ7_READ);
+        int32_t raw = MQ7_readCO(adc_co);
+        PROFILE_END(MQ7_READ);
+        bool active = COAlarm_update(raw, uptime_ms());
+
+        /* --- Filtered CO into the sample window, once the heater is
+         *     warm; the sensing task reads it with interrupts off --- */
+        int32_t co = COAlarm_filtered();
+        if (co >= 0 && uptime_ms() >= MQ7_WARMUP_MS) {
+            WindowStat_add(&window[ENV_AGG_CO], co);
+        }
+
+        /* --- Tell the network task at once, ahead of queued samples;
+         *     if the queue is full, try again next reading --- */
+        if (active != reported) {
+            NetMsg_t msg = { .type = NET_MSG_CO_ALERT };
+            msg.u.alert.co_mppm = COAlarm_filtered();
+            msg.u.alert.active = active;
+            if (xQueueSendToFront(netQueue, &msg, 0) == pdPASS) {
+                reported = active;
+            }
+        }
+
+        /* A reading that ran a whole period late restarts the grid
+         * rather than catching up in a burst */
+        if ((TickType_t)(xTaskGetTickCount() - woke) >= period) {
+            woke = xTaskGetTickCount();
+        }
+        vTaskDelayUntil(&woke, period);
     }
+}
 
-    /* Initialize sensors */
-    BME280_init(i2c);
-    SGP30_init(i2c);
-    BH1750_init(i2c);
-    BMV080_init(i2c);
-    MQ7_init(adc_co);
-    MIC_init(adc_mic);
-    COAlarm_init(CO_ALARM_PPM, CO_CLEAR_PPM);
+/* Latest reading of each I2C sensor, refreshed by the scheduler at the
+ * sensor's own period and folded into the window; a field whose window
+ * had no readings is published as its latest value */
+static EnvData_t latest;
+
+static void init_sgp30(void)
+{
+    PROFILE_BEGIN(SGP30_INIT);
+    SGP30_init();
+    PROFILE_END(SGP30_INIT);
+}
 
-    /* Connect to Wi-Fi & MQTT broker */
-    if (!WiFi_connect(WIFI_SSID, WIFI_PASS)) {
-        while (1) {}  /* Fatal: no network */
+static void init_bme280(void)
+{
+    PROFILE_BEGIN(BME280_INIT);
+    BME280_init();
+    PROFILE_END(BME280_INIT);
+}
+
+static void init_bh1750(void)
+{
+    PROFILE_BEGIN(BH1750_INIT);
+    BH1750_init();
+    PROFILE_END(BH1750_INIT);
+}
+
+static void init_bmv080(void)
+{
+    PROFILE_BEGIN(BMV080_INIT);
+    BMV080_init();
+    PROFILE_END(BMV080_INIT);
+}
+
+static void tick_sgp30(void)
+{
+    /* The result of the previous second's measurement */
+    PROFILE_BEGIN(SGP30_READ);
+    SGP30_read(&latest.eco2, &latest.tvoc);
+    PROFILE_END(SGP30_READ);
+    if (latest.eco2 != ENV_NO_READING) {
+        WindowStat_add(&window[ENV_AGG_ECO2], latest.eco2);
+        WindowStat_add(&window[ENV_AGG_TVOC], latest.tvoc);
     }
-    if (!MQTT_connect(MQTT_BROKER, MQTT_PORT, MQTT_CLIENT_ID)) {
-        while (1) {}  /* Fatal: no MQTT */
+    PROFILE_BEGIN(SGP30_TICK);
+    SGP30_tick();
+    PROFILE_END(SGP30_TICK);
+}
+
+static void read_bme280(void)
+{
+    PROFILE_BEGIN(BME280_READ);
+    bool ok = BME280_read(&latest.temp_cc, &latest.hum_mrh, &latest.press_pa);
+    PROFILE_END(BME280_READ);
+    if (!ok) return;    /* A failed read is no reading, not a zero */
+    WindowStat_add(&window[ENV_AGG_TEMP], latest.temp_cc);
+    WindowStat_add(&window[ENV_AGG_HUM], (int32_t)latest.hum_mrh);
+    WindowStat_add(&window[ENV_AGG_PRESS], (int32_t)latest.press_pa);
+}
+
+static void read_bh1750(void)
+{
+    PROFILE_BEGIN(BH1750_READ);
+    bool ok = BH1750_read(&latest.lux);
+    PROFILE_END(BH1750_READ);
+    if (ok) WindowStat_add(&window[ENV_AGG_LUX], latest.lux);
+}
+
+static void add_pm(int i, uint16_t dug)
+{
+    if (dug != ENV_NO_READING) WindowStat_add(&window[i], dug);
+}
+
+static void read_bmv080(void)
+{
+    PROFILE_BEGIN(BMV080_READ);
+    BMV080_read(&latest.pm1_dug, &latest.pm25_dug, &latest.pm10_dug);
+    PROFILE_END(BMV080_READ);
+    add_pm(ENV_AGG_PM1, latest.pm1_dug);
+    add_pm(ENV_AGG_PM25, latest.pm25_dug);
+    add_pm(ENV_AGG_PM10, latest.pm10_dug);
+}
+
+static void set_mean(EnvData_t *data, int i, int32_t mean)
+{
+    switch (i) {
+    case ENV_AGG_TEMP:  data->temp_cc = (int16_t)mean; break;
+    case ENV_AGG_HUM:   data->hum_mrh = (uint32_t)mean; break;
+    case ENV_AGG_PRESS: data->press_pa = (uint32_t)mean; break;
+    case ENV_AGG_ECO2:  data->eco2 = (uint16_t)mean; break;
+    case ENV_AGG_TVOC:  data->tvoc = (uint16_t)mean; break;
+    case ENV_AGG_CO:    data->co_mppm = mean; break;
+    case ENV_AGG_LUX:   data->lux = (uint16_t)mean; break;
+    case ENV_AGG_PM1:   data->pm1_dug = (uint16_t)mean; break;
+    case ENV_AGG_PM25:  data->pm25_dug = (uint16_t)mean; break;
+    case ENV_AGG_PM10:  data->pm10_dug = (uint16_t)mean; break;
+    }
+}
+
+/* Close the window: the mean and spread of each field, then start the
+ * next one */
+static void close_window(EnvData_t *data)
+{
+    WindowStat_t closed[ENV_AGG_COUNT];
+    uintptr_t key = HwiP_disable();
+    closed[ENV_AGG_CO] = window[ENV_AGG_CO];
+    WindowStat_reset(&window[ENV_AGG_CO]);
+    HwiP_restore(key);
+
+    for (int i = 0; i < ENV_AGG_COUNT; i++) {
+        if (i != ENV_AGG_CO) {
+            closed[i] = window[i];
+            WindowStat_reset(&window[i]);
+        }
+        int32_t mean;
+        WindowSpread_t spread;
+        data->spread[i] = ENV_SPREAD_NONE;
+        if (WindowStat_result(&closed[i], &mean, &spread)) {
+            set_mean(data, i, mean);
+            data->spread[i] = Payload_packSpread(i, &spread);
+        }
+    }
+}
+
+/* Table index of the periodic "sample" entry */
+static uint8_t sample_entry;
+
+/* A sample has carried CO since the MQ-7 warmed up */
+static bool co_sampled;
+
+/* Assemble a sample from the latest readings and hand it to the
+ * network task */
+static void take_sample(void)
+{
+    NetMsg_t msg = { .type = NET_MSG_SAMPLE };
+    EnvData_t *data = &msg.u.sample.data;
+    msg.u.sample.t_s = uptime_s();
+
+    *data = latest;
+    SGP30_read(&data->eco2, &data->tvoc);
+    /* The alarm runs from power-on, but published CO waits for the
+     * heater */
+    bool co_ready = uptime_ms() >= MQ7_WARMUP_MS;
+    data->co_mppm   = co_ready ? COAlarm_filtered() : -1;
+    close_window(data);
+    PROFILE_BEGIN(MIC_READ_DB);
+    data->noise_ddb = MIC_readDB();
+    PROFILE_END(MIC_READ_DB);
+    MICLevels_t levels;
+    PROFILE_BEGIN(MIC_LEVELS);
+    MIC_readLevels(&levels);
+    PROFILE_END(MIC_LEVELS);
+    data->laeq_ddb  = levels.leq;
+    data->lamax_ddb = levels.lmax;
+    data->lamin_ddb = levels.lmin;
+    data->la10_ddb  = levels.l10;
+    data->la90_ddb  = levels.l90;
+    data->co_alarm = COAlarm_active();
+    if (co_ready) co_sampled = true;
+
+    BootTime_mark(BOOT_FIRST_SAMPLE);
+    if (co_ready && SGP30_ready()) BootTime_mark(BOOT_FIRST_VALID);
+
+#if PROFILE_ENABLE
+    static const NetMsg_t profile_msg = { .type = NET_MSG_PROFILE };
+    static uint32_t samples;
+    if (++samples % PROFILE_REPORT_SAMPLES == 0) xQueueSend(netQueue, &profile_msg, 0);
+#endif
+
+    /* Report by exception: nothing moved past its deadband */
+    msg.u.sample.fields = Report_fields(data, uptime_ms());
+    if (msg.u.sample.fields == 0) return;
+
+    /* Never wait for the network task; if it has fallen
+     * NET_QUEUE_DEPTH messages behind, drop this sample */
+    if (xQueueSend(netQueue, &msg, 0) != pdPASS) {
+        Report_lost(msg.u.sample.fields);
+    }
+}
+
+/* Report the SGP30 tick timing (table entry 0), the boot phases, the
+ * connection drops, the energy account, the report-by-exception
+ * counts, the sampling interval and the memory high-water marks */
+static void send_diag(void)
+{
+    SensorSchedStats_t tick;
+    SensorSched_getStats(0, &tick);
+    ConnStats_t conn;
+    Conn_getStats(&conn);
+    EnergyStats_t energy;
+    Energy_getStats(&energy);
+    ReportStats_t report;
+    Report_getStats(&report);
+    SampleRateStats_t rate;
+    SampleRate_getStats(&rate);
+    MemStats_t mem;
+    MemStats_get(&mem);
+    I2CBusStats_t bus;
+    I2CBus_getStats(&bus);
+
+    NetMsg_t msg = { .type = NET_MSG_DIAG };
+    PayloadDiag_t *diag = &msg.u.diag;
+    diag->uptime_s = uptime_s();
+    diag->ticks = tick.runs;
+    diag->skipped = tick.skipped;
+    diag->late_max_ms = tick.late_max_ms;
+    diag->period_min_us = tick.period.min_us;
+    diag->period_max_us = tick.period.max_us;
+    diag->period_mean_us = tick.period.count
+        ? (uint32_t)(tick.period.sum_us / tick.period.count) : 0;
+    diag->wifi_ms = BootTime_get(BOOT_WIFI_UP);
+    diag->mqtt_ms = BootTime_get(BOOT_MQTT_UP);
+    diag->first_sample_ms = BootTime_get(BOOT_FIRST_SAMPLE);
+    diag->first_valid_ms = BootTime_get(BOOT_FIRST_VALID);
+    diag->first_publish_ms = BootTime_get(BOOT_FIRST_PUBLISH);
+    diag->wifi_drops = conn.wlan_drops;
+    diag->mqtt_drops = conn.mqtt_drops;
+    diag->reconnect_ms = conn.latency_last_ms;
+    diag->reconnect_max_ms = conn.latency_max_ms;
+    diag->power_uw = energy.mean_uw;
+    diag->runtime_h = energy.runtime_h;
+    diag->mcu_lpds_s = (uint32_t)(energy.comp[ENERGY_MCU].ms[ENERGY_SLEEP] / 1000);
+    diag->nwp_awake_s = (uint32_t)(energy.comp[ENERGY_NWP].ms[ENERGY_AWAKE] / 1000);
+    diag->samples_full = report.full;
+    diag->samples_partial = report.partial;
+    diag->samples_suppressed = report.suppressed;
+    diag->fields_suppressed = report.fields_suppressed;
+    diag->interval_s = rate.interval_ms / 1000;
+    diag->interval_min_s = rate.min_ms / 1000;
+    diag->rate_faster = rate.faster;
+    diag->rate_slower = rate.slower;
+    diag->stack_sl = mem.stack_free[MEM_TASK_SL];
+    diag->stack_co = mem.stack_free[MEM_TASK_CO];
+    diag->stack_sensor = mem.stack_free[MEM_TASK_SENSOR];
+    diag->stack_mic = mem.stack_free[MEM_TASK_MIC];
+    diag->stack_net = mem.stack_free[MEM_TASK_NET];
+    diag->heap_free = mem.heap_free;
+    diag->heap_min = mem.heap_min;
+    diag->i2c_cancelled = bus.cancelled;
+    diag->i2c_abandoned = bus.abandoned;
+    xQueueSend(netQueue, &msg, 0);
+}
+
+/* Once the MQ-7 is warm, close the window at once unless a sample
+ * has already carried CO */
+static void sample_ready(void)
+{
+    if (!co_sampled) SensorSched_release(sample_entry);
+}
+
+#if RATE_ADAPTIVE
+/* Re-evaluate the sampling interval on the latest readings; a change
+ * applies to the current window and is published */
+static void adapt_rate(void)
+{
+    EnvData_t now = latest;
+    now.co_mppm = uptime_ms() >= MQ7_WARMUP_MS ? COAlarm_filtered() : -1;
+
+    NetMsg_t msg = { .type = NET_MSG_RATE };
+    if (!SampleRate_update(&now, uptime_ms(), &msg.u.rate)) return;
+    SensorSched_setPeriod(sample_entry, msg.u.rate.interval_ms);
+    xQueueSend(netQueue, &msg, 0);
+}
+#endif
+
+/*
+ * Sensing schedule. Conversion times are the wait from init to the
+ * first valid reading: SGP30 iaq_init 10 ms, BME280 first normal-mode
+ * measurement (temp x2, press x16, hum x1) ~46 ms, BH1750 high-res
+ * 180 ms max. The SGP30 baseline algorithm requires measure_iaq every
+ * 1 second. The first sample is taken once the SGP30 has returned a
+ * warmed-up measurement, and every READ_INTERVAL_MS after that. When
+ * the MQ-7 heater is warm too, "ready" releases "sample" at once if no
+ * sample has carried CO yet, so the first complete sample waits for
+ * neither the next interval nor, with RATE_ADAPTIVE, the current rate
+ * (500 ms covers the SGP30's measure-and-read after its warm-up). The
+ * MQ-7 heater and the network come up meanwhile in their own tasks. The
+ * SGP30 must stay entry 0 for send_diag(). With RATE_ADAPTIVE the
+ * "rate" entry changes the period of "sample".
+ */
+static const SensorDesc_t sensors[] = {
+    { "SGP30",  init_sgp30,  tick_sgp30,  1000,             10 },
+    { "BME280", init_bme280, read_bme280, BME280_PERIOD_MS, 50 },
+    { "BH1750", init_bh1750, read_bh1750, BH1750_PERIOD_MS, 180 },
+    { "BMV080", init_bmv080, read_bmv080, BMV080_PERIOD_MS, 0 },
+#if MIC_CAPTURE_PERIOD_MS > 0
+    { "mic",    NULL,        MIC_capture, MIC_CAPTURE_PERIOD_MS, 0 },
+#endif
+    { "sample", NULL,        take_sample, READ_INTERVAL_MS, SGP30_WARMUP_MS + 500 },
+    { "ready",  NULL,        sample_ready, 0,               MQ7_WARMUP_MS + 500 },
+#if RATE_ADAPTIVE
+    { "rate",   NULL,        adapt_rate,  RATE_EVAL_MS,     RATE_EVAL_MS },
+#endif
+    { "diag",   NULL,        send_diag,   DIAG_INTERVAL_MS, DIAG_INTERVAL_MS },
+};
+
+void *sensorThread(void *arg0)
+{
+    (void)arg0;
+    MemStats_register(MEM_TASK_SENSOR);
+
+    /* Initialize drivers */
+    PROFILE_BEGIN(I2C_INIT);
+    bool ok = I2CBus_init(Board_I2C0);
+    PROFILE_END(I2C_INIT);
+    if (!ok) {
+        while (1) {}  /* Fatal: I2C unavailable */
+    }
+
+    uint8_t count = sizeof(sensors) / sizeof(sensors[0]);
+    for (uint8_t i = 0; i < count; i++) {
+        if (sensors[i].sample == take_sample) sample_entry = i;
     }
 
-    int publish_counter = 0;
-    int publish_interval = READ_INTERVAL_MS / 1000;
+    /* Initialize sensors and run them; does not return */
+    SensorSched_run(sensors, count);
+    return NULL;
+}
+
+void *micThread(void *arg0)
+{
+    (void)arg0;
+    MemStats_register(MEM_TASK_MIC);
+
+    PROFILE_BEGIN(MIC_INIT);
+    bool ok = MIC_init(Board_ADCBUF0);
+    PROFILE_END(MIC_INIT);
+    if (!ok) {
+        while (1) {}  /* Fatal: Mic ADCBuf unavailable */
+    }
 
     while (1) {
-        /*
-         * SGP30 baseline algorithm requires measure_iaq every 1 second.
-         * Tick it on every loop iteration (1 Hz).
-         */
-        SGP30_tick(i2c);
-
-        if (++publish_counter >= publish_interval) {
-            publish_counter = 0;
-
-            EnvData_t data = {0};
-
-            /* --- Read all sensors --- */
-            BME280_read(i2c, &data.temperature,
-                        &data.humidity, &data.pressure);
-            SGP30_read(&data.eco2, &data.tvoc);
-            BH1750_read(i2c, &data.lux);
-            BMV080_read(i2c, &data.pm1, &data.pm25, &data.pm10);
-            data.co_ppm   = MQ7_readPPM(adc_co);
-            data.noise_db = MIC_readDB(adc_mic);
-
-            /* --- CO safety check (with hysteresis) --- */
-            data.co_alarm = COAlarm_check(data.co_ppm);
-
-            /* --- Build JSON payload --- */
-            char payload[512];
-            int len = snprintf(payload, sizeof(payload),
-                "{"
-                "\"temp\":%.1f,"
-                "\"hum\":%.1f,"
-                "\"press\":%.1f,"
-                "\"eco2\":%u,"
-                "\"tvoc\":%u,"
-                "\"co_ppm\":%.1f,"
-                "\"lux\":%u,"
-                "\"pm1\":%.1f,"
-                "\"pm25\":%.1f,"
-                "\"pm10\":%.1f,"
-                "\"noise_db\":%.1f,"
-                "\"co_alert\":%s"
-                "}",
-                data.temperature, data.humidity,
-                data.pressure, (unsigned)data.eco2, (unsigned)data.tvoc,
-                data.co_ppm, (unsigned)data.lux,
-                data.pm1, data.pm25, data.pm10,
-                data.noise_db,
-                data.co_alarm ? "true" : "false");
-
-            /* --- Publish (skip if truncated) --- */
-            if (len > 0 && len < (int)sizeof(payload)) {
-                if (!MQTT_publish(MQTT_TOPIC, payload)) {
-                    /* Attempt reconnect on publish failure */
-                    MQTT_reconnect();
+        MIC_process();
+    }
+}
+
+/* From the SimpleLink event context: run Conn_poll() now rather than
+ * at the next 1 s wakeup. If the queue is full the task is awake
+ * anyway. */
+static void wake_net(void)
+{
+    NetMsg_t msg = { .type = NET_MSG_CONN };
+    xQueueSend(netQueue, &msg, 0);
+}
+
+void *netThread(void *arg0)
+{
+    (void)arg0;
+    MemStats_register(MEM_TASK_NET);
+
+    /* Wi-Fi and the broker come up in the background (wifi_mqtt.h);
+     * until then samples wait in the ring and spill to flash, which
+     * Conn_start() has already made usable by starting the NWP. */
+    Conn_start(wake_net);
+    SampleRing_init();
+    FlashQueue_init();
+
+    uint32_t flush_age_s = BATCH_FLUSH_MS / 1000;
+    uint32_t replay_at_s = 0;
+    bool alert_pending = false;
+    bool diag_pending = false;
+    bool rate_pending = false;
+    bool flush_now = false;
+    NetMsg_t alert = {0};
+    NetMsg_t diag = {0};
+    NetMsg_t rate = {0};
+#if PROFILE_ENABLE
+    int profile_next = PROFILE_SCOPES;      /* Next scope to publish */
+#endif
+#if RADIO_DUTY_CYCLE
+    uint32_t wake_ms = uptime_ms();     /* Radio last started */
+    uint32_t next_wake_ms = 0;
+#endif
+
+    while (1) {
+        /* --- Advance the connection; it says when it next needs us --- */
+        uint32_t conn_ms = Conn_poll();
+        bool up = Conn_isUp();
+
+        /* --- Take new messages, waking at least every second for
+         *     flush deadlines and replay --- */
+        NetMsg_t msg;
+        uint32_t wait_ms = (flush_now && up) ? 0 : (conn_ms < 1000 ? conn_ms : 1000);
+        TickType_t wait = pdMS_TO_TICKS(wait_ms);
+        while (xQueueReceive(netQueue, &msg, wait) == pdPASS) {
+            wait = 0;
+            if (msg.type == NET_MSG_CONN) continue;
+            if (msg.type == NET_MSG_CO_ALERT) {
+                /* Only the latest alarm state matters */
+                alert = msg;
+                alert_pending = true;
+                continue;
+            }
+            if (msg.type == NET_MSG_DIAG) {
+                diag = msg;
+                diag_pending = true;
+                continue;
+            }
+#if PROFILE_ENABLE
+            if (msg.type == NET_MSG_PROFILE) {
+                profile_next = 0;
+                continue;
+            }
+#endif
+            if (msg.type == NET_MSG_RATE) {
+                /* The latest change; its count shows any overtaken */
+                rate = msg;
+                rate_pending = true;
+                continue;
+            }
+            uint32_t lost = SampleRing_push(&msg.u.sample);
+            if (lost != 0) Report_lost(lost);
+
+            /* --- Broker down and ring full: move the oldest to flash,
+             *     starting the NWP for it if the radio is off --- */
+            if (!up && SampleRing_count() >= SAMPLE_RING_DEPTH) {
+#if RADIO_DUTY_CYCLE
+                if (Conn_isOff()) {
+                    Conn_wake();
+                    wake_ms = uptime_ms();
                 }
+#endif
+                /* A full flash queue drops its oldest segment, whose
+                 * fields are not known here: resend them all */
+                FlashQueueStats_t fq;
+                FlashQueue_getStats(&fq);
+                uint32_t dropped = fq.dropped;
+                FlashQueue_spill();
+                FlashQueue_getStats(&fq);
+                if (fq.dropped != dropped) Report_lost(ENV_FIELDS_ALL);
             }
         }
 
-        sleep(1);
+        uint32_t now_s = uptime_s();
+
+        /* --- Publish a CO alarm change out of band, then flush the
+         *     queued samples behind it without waiting for a batch --- */
+        const EnvSample_t *oldest = SampleRing_peek(0);
+        bool attempted = true;
+        bool sent;
+        if (alert_pending && up) {
+            static char alert_msg[PAYLOAD_ALERT_MAX];
+            size_t len = Payload_alert(alert_msg, sizeof(alert_msg),
+                                       alert.u.alert.co_mppm, alert.u.alert.active);
+            sent = MQTT_publish(MQTT_TOPIC_ALERT, alert_msg, len);
+            if (sent) {
+                alert_pending = false;
+                flush_now = SampleRing_count() > 0;
+            }
+        } else if (oldest != NULL && up &&
+                   (RADIO_DUTY_CYCLE || flush_now || SampleRing_count() >= BATCH_SIZE ||
+                    now_s - oldest->t_s >= flush_age_s)) {
+            sent = publish_batch(now_s);
+            if (sent) {
+                flush_now = false;
+                BootTime_mark(BOOT_FIRST_PUBLISH);
+            }
+        } else if (rate_pending && up) {
+            static char rate_msg[PAYLOAD_RATE_MAX];
+            const SampleRateDecision_t *d = &rate.u.rate;
+            size_t len = Payload_rate(rate_msg, sizeof(rate_msg), d->cause,
+                                      d->interval_ms, d->was_ms, d->ratio_pct,
+                                      d->changes);
+            sent = MQTT_publish(MQTT_TOPIC_RATE, rate_msg, len);
+            if (sent) rate_pending = false;
+        } else if (diag_pending && up) {
+            static char diag_msg[PAYLOAD_DIAG_MAX];
+            size_t len = Payload_diag(diag_msg, sizeof(diag_msg), &diag.u.diag);
+            sent = MQTT_publish(MQTT_TOPIC_DIAG, diag_msg, len);
+            if (sent) diag_pending = false;
+#if PROFILE_ENABLE
+        } else if (profile_next < PROFILE_SCOPES && up) {
+            /* --- One scope per pass, so live samples are not held up --- */
+            static char profile_msg[PAYLOAD_PROFILE_MAX];
+            ProfileStats_t stats;
+            const char *name;
+            Profile_get((ProfileScope_t)profile_next, &stats, &name);
+            size_t len = Payload_profile(profile_msg, sizeof(profile_msg), name, &stats);
+            sent = MQTT_publish(MQTT_TOPIC_PROF, profile_msg, len);
+            if (sent) profile_next++;
+#endif
+        } else if (up && FlashQueue_count() > 0 &&
+                   SampleRing_count() < BATCH_SIZE &&
+                   (RADIO_DUTY_CYCLE || (int32_t)(now_s - replay_at_s) >= 0)) {
+            /* --- Drain the flash backlog between live publishes --- */
+            sent = replay_batch(now_s);
+            replay_at_s = now_s + FLASH_REPLAY_INTERVAL_MS / 1000;
+        } else {
+            attempted = false;
+            sent = false;
+        }
+
+        if (attempted && !sent) {
+            /* Keep the samples queued; Conn_poll() reconnects, backing
+             * off while the broker stays unreachable */
+            Conn_lost();
+        }
+
+#if RADIO_DUTY_CYCLE
+        /* --- Radio duty cycle: up for the flush, a CO alarm change
+         *     or the whole of an alarm; off otherwise. It stays up
+         *     after boot until the first sample is out. --- */
+        uint32_t now_ms = uptime_ms();
+        bool alarm = alert_pending || alert.u.alert.active;
+        if (Conn_isOff()) {
+            if (alarm || (int32_t)(now_ms - next_wake_ms) >= 0) {
+                Conn_wake();
+                wake_ms = now_ms;
+            }
+        } else if (!alarm) {
+            bool up_now = Conn_isUp();
+            bool flushed = up_now && SampleRing_count() == 0 && !diag_pending &&
+                           !rate_pending && FlashQueue_count() == 0 &&
+#if PROFILE_ENABLE
+                           profile_next == PROFILE_SCOPES &&
+#endif
+                           BootTime_get(BOOT_FIRST_PUBLISH) != BOOT_NOT_REACHED;
+            if (flushed || (!up_now && now_ms - wake_ms >= RADIO_WAKE_MAX_MS)) {
+                Conn_sleep();
+                next_wake_ms = now_ms + RADIO_FLUSH_PERIOD_MS;
+            }
+        }
+#endif
     }
 }
@@ -2,7 +2,10 @@
  * main_freertos.c - FreeRTOS entry point for CC3220SF
  *
  * Based on TI SimpleLink SDK example main_freertos.c.
- * Creates a POSIX thread that runs mainThread() defined in main.c.
+ * Creates the SimpleLink host driver task and the application tasks
+ * declared in app_tasks.h, each with its own priority and stack. With
+ * STATIC_ALLOCATION the stacks are static arrays instead of heap
+ * blocks, so their size shows in the link map.
  */
 
 #include <stdint.h>
@@ -15,35 +18,79 @@
 #include <task.h>
 
 #include <ti/drivers/Board.h>
+#include <ti/drivers/net/wifi/simplelink.h>
 
-extern void *mainThread(void *arg0);
+#include "config.h"
+#include "app_tasks.h"
+#include "mem_stats.h"
 
-/* Stack size in bytes */
-#define THREADSTACKSIZE 4096
+#if STATIC_ALLOCATION && !configSUPPORT_STATIC_ALLOCATION
+#error "STATIC_ALLOCATION needs configSUPPORT_STATIC_ALLOCATION in FreeRTOSConfig.h"
+#endif
 
-int main(void)
+/* SimpleLink host driver task: dispatches NWP events, so it must
+ * outrank every task that calls into sl_* */
+#define SPAWN_TASK_PRIORITY     9
+#define SPAWN_TASK_STACK        2048
+
+#if STATIC_ALLOCATION
+static uint64_t sl_stack[SPAWN_TASK_STACK / sizeof(uint64_t)];
+static uint64_t co_stack[CO_TASK_STACK / sizeof(uint64_t)];
+static uint64_t sensor_stack[SENSOR_TASK_STACK / sizeof(uint64_t)];
+static uint64_t mic_stack[MIC_TASK_STACK / sizeof(uint64_t)];
+static uint64_t net_stack[NET_TASK_STACK / sizeof(uint64_t)];
+#define STACK(name)     (name)
+#else
+#define STACK(name)     NULL
+#endif
+
+/* The host driver task, registered for its stack watermark */
+static void *sl_thread(void *arg0)
+{
+    MemStats_register(MEM_TASK_SL);
+    return sl_Task(arg0);
+}
+
+/* stack: NULL for a heap stack of `size` bytes */
+static void start_thread(void *(*entry)(void *), int priority, void *stack,
+                         size_t size)
 {
     pthread_t thread;
     pthread_attr_t attrs;
     struct sched_param priParam;
     int retc;
 
-    Board_init();
-
     pthread_attr_init(&attrs);
 
-    priParam.sched_priority = 1;
-    retc                    = pthread_attr_setschedparam(&attrs, &priParam);
+    priParam.sched_priority = priority;
+    retc  = pthread_attr_setschedparam(&attrs, &priParam);
     retc |= pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
-    retc |= pthread_attr_setstacksize(&attrs, THREADSTACKSIZE);
+    if (stack != NULL) {
+        retc |= pthread_attr_setstack(&attrs, stack, size);
+    } else {
+        retc |= pthread_attr_setstacksize(&attrs, size);
+    }
     if (retc != 0) {
         while (1) {}
     }
 
-    retc = pthread_create(&thread, &attrs, mainThread, NULL);
+    retc = pthread_create(&thread, &attrs, entry, NULL);
     if (retc != 0) {
         while (1) {}
     }
+}
+
+int main(void)
+{
+    Board_init();
+    App_init();
+
+    start_thread(sl_thread, SPAWN_TASK_PRIORITY, STACK(sl_stack), SPAWN_TASK_STACK);
+    start_thread(coThread, CO_TASK_PRIORITY, STACK(co_stack), CO_TASK_STACK);
+    start_thread(sensorThread, SENSOR_TASK_PRIORITY, STACK(sensor_stack),
+                 SENSOR_TASK_STACK);
+    start_thread(micThread, MIC_TASK_PRIORITY, STACK(mic_stack), MIC_TASK_STACK);
+    start_thread(netThread, NET_TASK_PRIORITY, STACK(net_stack), NET_TASK_STACK);
 
     /* Start the FreeRTOS scheduler */
     vTaskStartScheduler();
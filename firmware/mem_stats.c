@@ -0,0 +1,25 @@
+#include "mem_stats.h"
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#if !INCLUDE_uxTaskGetStackHighWaterMark || !INCLUDE_xTaskGetCurrentTaskHandle
+#error "mem_stats.c needs INCLUDE_uxTaskGetStackHighWaterMark and INCLUDE_xTaskGetCurrentTaskHandle in FreeRTOSConfig.h"
+#endif
+
+static TaskHandle_t tasks[MEM_TASKS];
+
+void MemStats_register(MemTask_t task)
+{
+    tasks[task] = xTaskGetCurrentTaskHandle();
+}
+
+void MemStats_get(MemStats_t *stats)
+{
+    for (int i = 0; i < MEM_TASKS; i++) {
+        stats->stack_free[i] = tasks[i] == NULL ? MEM_STATS_NONE
+            : (uint32_t)uxTaskGetStackHighWaterMark(tasks[i]) * sizeof(StackType_t);
+    }
+    stats->heap_free = (uint32_t)xPortGetFreeHeapSize();
+    stats->heap_min = (uint32_t)xPortGetMinimumEverFreeHeapSize();
+}
@@ -0,0 +1,38 @@
+#ifndef MEM_STATS_H
+#define MEM_STATS_H
+
+#include <stdint.h>
+
+/*
+ * Stack and heap high-water marks
+ *
+ * Each task registers itself once at start-up; afterwards any task can
+ * read the least free stack space each task has ever had (FreeRTOS
+ * stack watermark) and the FreeRTOS heap's current and minimum-ever
+ * free bytes. Size stacks and configTOTAL_HEAP_SIZE from these.
+ */
+
+typedef enum {
+    MEM_TASK_SL,            /* SimpleLink host driver (main_freertos.c) */
+    MEM_TASK_CO,
+    MEM_TASK_SENSOR,
+    MEM_TASK_MIC,
+    MEM_TASK_NET,
+    MEM_TASKS
+} MemTask_t;
+
+#define MEM_STATS_NONE      UINT32_MAX  /* Task not registered */
+
+typedef struct {
+    uint32_t stack_free[MEM_TASKS]; /* Bytes, least ever, or MEM_STATS_NONE */
+    uint32_t heap_free;             /* Bytes */
+    uint32_t heap_min;              /* Least ever free since boot */
+} MemStats_t;
+
+/* Record the calling task as `task`. Call at the top of the task. */
+void MemStats_register(MemTask_t task);
+
+/* Read the marks. Walks each stack, so call at diagnostics rate. */
+void MemStats_get(MemStats_t *stats);
+
+#endif
@@ -0,0 +1,439 @@
+#include "payload.h"
+#include "config.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Fixed-point JSON serializer
+ *
+ * Replaces snprintf("%.1f") on the publish path. With -mfloat-abi=soft
+ * and newlib-nano, float printf pulls in _dtoa and performs dozens of
+ * soft-float operations per field. EnvData_t fields are already
+ * integers in fixed point, so each is rounded to tenths (half away
+ * from zero) and the digits come from integer division by 10, which
+ * the compiler turns into a multiply-high on the Cortex-M4.
+ */
+
+typedef struct {
+    char *pos;
+    char *end;
+    bool  overflow;
+} Writer;
+
+static void put_char(Writer *w, char c)
+{
+    if (w->pos < w->end) {
+        *w->pos++ = c;
+    } else {
+        w->overflow = true;
+    }
+}
+
+static void put_str(Writer *w, const char *s)
+{
+    while (*s) put_char(w, *s++);
+}
+
+static void put_uint(Writer *w, uint32_t v)
+{
+    char digits[10];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    while (n > 0) put_char(w, digits[--n]);
+}
+
+/* v / d rounded to nearest, halves away from zero; d > 0 */
+static int32_t div_round(int32_t v, int32_t d)
+{
+    return (v >= 0 ? v + d / 2 : v - d / 2) / d;
+}
+
+/* Write a count of tenths with one decimal place, e.g. -1.0, 1013.3 */
+static void put_tenths(Writer *w, int32_t tenths)
+{
+    uint32_t mag = (uint32_t)tenths;
+    if (tenths < 0) {
+        put_char(w, '-');
+        mag = 0U - mag;
+    }
+    put_uint(w, mag / 10);
+    put_char(w, '.');
+    put_char(w, (char)('0' + mag % 10));
+}
+
+/* Optional reading in tenths; no reading is published as -1.0 */
+static void put_opt_tenths(Writer *w, uint16_t tenths)
+{
+    put_tenths(w, tenths == ENV_NO_READING ? -10 : tenths);
+}
+
+/* Optional count; no reading is published as -1 */
+static void put_opt_uint(Writer *w, uint16_t v)
+{
+    if (v == ENV_NO_READING) {
+        put_str(w, "-1");
+    } else {
+        put_uint(w, v);
+    }
+}
+
+/* CO in 0.001 ppm; negative is no reading, published as -1.0 */
+static int32_t co_tenths(int32_t co_mppm)
+{
+    return co_mppm < 0 ? -10 : div_round(co_mppm, 100);
+}
+
+/* Write "key": behind a comma unless it opens the object */
+static void put_key(Writer *w, bool *first, const char *key)
+{
+    if (!*first) put_char(w, ',');
+    *first = false;
+    put_char(w, '"');
+    put_str(w, key);
+    put_str(w, "\":");
+}
+
+/* Keys of the ENV_AGG_* fields */
+static const char *const agg_key[ENV_AGG_COUNT] = {
+    "temp", "hum", "press", "eco2", "tvoc", "co_ppm", "lux", "pm1", "pm25", "pm10",
+};
+
+/* A value of ENV_AGG_* field i, scaled as the field itself */
+static void put_agg(Writer *w, int i, int32_t v)
+{
+    switch (i) {
+    case ENV_AGG_TEMP:
+    case ENV_AGG_PRESS: put_tenths(w, div_round(v, 10)); break;
+    case ENV_AGG_HUM:
+    case ENV_AGG_CO:    put_tenths(w, div_round(v, 100)); break;
+    case ENV_AGG_PM1:
+    case ENV_AGG_PM25:
+    case ENV_AGG_PM10:  put_tenths(w, v); break;
+    default:            put_uint(w, (uint32_t)v); break;
+    }
+}
+
+/* "<key>_min", "<key>_max" and "<key>_sd" of field i, if its window
+ * had readings */
+static void put_spread(Writer *w, int i, const EnvSpread_t *s)
+{
+    if (s->sd == ENV_NO_READING) return;
+    put_str(w, ",\""); put_str(w, agg_key[i]); put_str(w, "_min\":");
+    put_agg(w, i, Payload_spreadValue(i, s->min));
+    put_str(w, ",\""); put_str(w, agg_key[i]); put_str(w, "_max\":");
+    put_agg(w, i, Payload_spreadValue(i, s->max));
+    put_str(w, ",\""); put_str(w, agg_key[i]); put_str(w, "_sd\":");
+    put_agg(w, i, Payload_spreadValue(i, s->sd));
+}
+
+/* The ENV_FIELD_* fields of `data`, in a fixed order, each window mean
+ * followed by its spread */
+static void put_json_object(Writer *w, const EnvData_t *data, uint32_t fields,
+                            bool with_age, uint16_t age_s)
+{
+    bool first = true;
+    put_char(w, '{');
+    if (with_age) {
+        put_key(w, &first, "age");      put_uint(w, age_s);
+    }
+    if (fields & ENV_FIELD_TEMP) {
+        put_key(w, &first, "temp");     put_tenths(w, div_round(data->temp_cc, 10));
+        put_spread(w, ENV_AGG_TEMP, &data->spread[ENV_AGG_TEMP]);
+    }
+    if (fields & ENV_FIELD_HUM) {
+        put_key(w, &first, "hum");      put_tenths(w, div_round((int32_t)data->hum_mrh, 100));
+        put_spread(w, ENV_AGG_HUM, &data->spread[ENV_AGG_HUM]);
+    }
+    if (fields & ENV_FIELD_PRESS) {
+        put_key(w, &first, "press");    put_tenths(w, div_round((int32_t)data->press_pa, 10));
+        put_spread(w, ENV_AGG_PRESS, &data->spread[ENV_AGG_PRESS]);
+    }
+    if (fields & ENV_FIELD_ECO2) {
+        put_key(w, &first, "eco2");     put_opt_uint(w, data->eco2);
+        put_spread(w, ENV_AGG_ECO2, &data->spread[ENV_AGG_ECO2]);
+    }
+    if (fields & ENV_FIELD_TVOC) {
+        put_key(w, &first, "tvoc");     put_opt_uint(w, data->tvoc);
+        put_spread(w, ENV_AGG_TVOC, &data->spread[ENV_AGG_TVOC]);
+    }
+    if (fields & ENV_FIELD_CO) {
+        put_key(w, &first, "co_ppm");   put_tenths(w, co_tenths(data->co_mppm));
+        put_spread(w, ENV_AGG_CO, &data->spread[ENV_AGG_CO]);
+    }
+    if (fields & ENV_FIELD_LUX) {
+        put_key(w, &first, "lux");      put_uint(w, data->lux);
+        put_spread(w, ENV_AGG_LUX, &data->spread[ENV_AGG_LUX]);
+    }
+    if (fields & ENV_FIELD_PM1) {
+        put_key(w, &first, "pm1");      put_opt_tenths(w, data->pm1_dug);
+        put_spread(w, ENV_AGG_PM1, &data->spread[ENV_AGG_PM1]);
+    }
+    if (fields & ENV_FIELD_PM25) {
+        put_key(w, &first, "pm25");     put_opt_tenths(w, data->pm25_dug);
+        put_spread(w, ENV_AGG_PM25, &data->spread[ENV_AGG_PM25]);
+    }
+    if (fields & ENV_FIELD_PM10) {
+        put_key(w, &first, "pm10");     put_opt_tenths(w, data->pm10_dug);
+        put_spread(w, ENV_AGG_PM10, &data->spread[ENV_AGG_PM10]);
+    }
+    if (fields & ENV_FIELD_NOISE) {
+        put_key(w, &first, "noise_db"); put_tenths(w, data->noise_ddb);
+    }
+    if (fields & ENV_FIELD_LAEQ) {
+        put_key(w, &first, "laeq");     put_tenths(w, data->laeq_ddb);
+    }
+    if (fields & ENV_FIELD_LAMAX) {
+        put_key(w, &first, "lamax");    put_tenths(w, data->lamax_ddb);
+    }
+    if (fields & ENV_FIELD_LAMIN) {
+        put_key(w, &first, "lamin");    put_tenths(w, data->lamin_ddb);
+    }
+    if (fields & ENV_FIELD_LA10) {
+        put_key(w, &first, "la10");     put_tenths(w, data->la10_ddb);
+    }
+    if (fields & ENV_FIELD_LA90) {
+        put_key(w, &first, "la90");     put_tenths(w, data->la90_ddb);
+    }
+    if (fields & ENV_FIELD_CO_ALARM) {
+        put_key(w, &first, "co_alert"); put_str(w, data->co_alarm ? "true" : "false");
+    }
+    put_char(w, '}');
+}
+
+size_t Payload_rate(char *buf, size_t size, int8_t cause, uint32_t interval_ms,
+                    uint32_t was_ms, uint16_t ratio_pct, uint32_t changes)
+{
+    Writer w = { buf, buf + size, false };
+    put_str(&w, "{\"interval_s\":"); put_uint(&w, interval_ms / 1000);
+    put_str(&w, ",\"was_s\":");       put_uint(&w, was_ms / 1000);
+    put_str(&w, ",\"cause\":\"");
+    put_str(&w, cause >= 0 && cause < ENV_AGG_COUNT ? agg_key[cause] : "quiet");
+    put_str(&w, "\",\"ratio\":");     put_uint(&w, ratio_pct);
+    put_str(&w, ",\"changes\":");     put_uint(&w, changes);
+    put_char(&w, '}');
+    return w.overflow ? 0 : (size_t)(w.pos - buf);
+}
+
+size_t Payload_alert(char *buf, size_t size, int32_t co_mppm, bool active)
+{
+    Writer w = { buf, buf + size, false };
+    put_str(&w, "{\"co_ppm\":");   put_tenths(&w, co_tenths(co_mppm));
+    put_str(&w, ",\"co_alert\":"); put_str(&w, active ? "true" : "false");
+    put_char(&w, '}');
+    return w.overflow ? 0 : (size_t)(w.pos - buf);
+}
+
+#if PROFILE_ENABLE
+size_t Payload_profile(char *buf, size_t size, const char *name,
+                       const ProfileStats_t *stats)
+{
+    Writer w = { buf, buf + size, false };
+    put_str(&w, "{\"scope\":\"");  put_str(&w, name);
+    put_str(&w, "\",\"n\":");       put_uint(&w, stats->count);
+    put_str(&w, ",\"min_cyc\":");   put_uint(&w, stats->min);
+    put_str(&w, ",\"max_cyc\":");   put_uint(&w, stats->max);
+    put_str(&w, ",\"mean_cyc\":");
+    put_uint(&w, stats->count ? (uint32_t)(stats->sum / stats->count) : 0);
+    put_str(&w, ",\"hist\":[");
+    for (int i = 0; i < PROFILE_BUCKETS; i++) {
+        if (i > 0) put_char(&w, ',');
+        put_uint(&w, stats->hist[i]);
+    }
+    put_str(&w, "]}");
+    return w.overflow ? 0 : (size_t)(w.pos - buf);
+}
+#endif
+
+/* Optional value, e.g. a boot-phase time; none is published as -1 */
+static void put_opt(Writer *w, uint32_t v)
+{
+    if (v == PAYLOAD_DIAG_NONE) {
+        put_str(w, "-1");
+    } else {
+        put_uint(w, v);
+    }
+}
+
+size_t Payload_diag(char *buf, size_t size, const PayloadDiag_t *diag)
+{
+    Writer w = { buf, buf + size, false };
+    put_str(&w, "{\"uptime\":");          put_uint(&w, diag->uptime_s);
+    put_str(&w, ",\"ticks\":");           put_uint(&w, diag->ticks);
+    put_str(&w, ",\"tick_skipped\":");    put_uint(&w, diag->skipped);
+    put_str(&w, ",\"tick_late_max_ms\":"); put_uint(&w, diag->late_max_ms);
+    put_str(&w, ",\"tick_min_us\":");     put_uint(&w, diag->period_min_us);
+    put_str(&w, ",\"tick_max_us\":");     put_uint(&w, diag->period_max_us);
+    put_str(&w, ",\"tick_mean_us\":");    put_uint(&w, diag->period_mean_us);
+    put_str(&w, ",\"boot_wifi_ms\":");    put_opt(&w, diag->wifi_ms);
+    put_str(&w, ",\"boot_mqtt_ms\":");    put_opt(&w, diag->mqtt_ms);
+    put_str(&w, ",\"boot_sample_ms\":");  put_opt(&w, diag->first_sample_ms);
+    put_str(&w, ",\"boot_valid_ms\":");   put_opt(&w, diag->first_valid_ms);
+    put_str(&w, ",\"boot_publish_ms\":"); put_opt(&w, diag->first_publish_ms);
+    put_str(&w, ",\"wifi_drops\":");      put_uint(&w, diag->wifi_drops);
+    put_str(&w, ",\"mqtt_drops\":");      put_uint(&w, diag->mqtt_drops);
+    put_str(&w, ",\"reconnect_ms\":");    put_opt(&w, diag->reconnect_ms);
+    put_str(&w, ",\"reconnect_max_ms\":"); put_uint(&w, diag->reconnect_max_ms);
+    put_str(&w, ",\"power_uw\":");        put_uint(&w, diag->power_uw);
+    put_str(&w, ",\"runtime_h\":");       put_uint(&w, diag->runtime_h);
+    put_str(&w, ",\"mcu_lpds_s\":");      put_uint(&w, diag->mcu_lpds_s);
+    put_str(&w, ",\"nwp_awake_s\":");     put_uint(&w, diag->nwp_awake_s);
+    put_str(&w, ",\"samples_full\":");    put_uint(&w, diag->samples_full);
+    put_str(&w, ",\"samples_partial\":"); put_uint(&w, diag->samples_partial);
+    put_str(&w, ",\"samples_suppressed\":"); put_uint(&w, diag->samples_suppressed);
+    put_str(&w, ",\"fields_suppressed\":"); put_uint(&w, diag->fields_suppressed);
+    put_str(&w, ",\"interval_s\":");    put_uint(&w, diag->interval_s);
+    put_str(&w, ",\"interval_min_s\":"); put_uint(&w, diag->interval_min_s);
+    put_str(&w, ",\"rate_faster\":");   put_uint(&w, diag->rate_faster);
+    put_str(&w, ",\"rate_slower\":");   put_uint(&w, diag->rate_slower);
+    put_str(&w, ",\"stack_sl_free\":");  put_opt(&w, diag->stack_sl);
+    put_str(&w, ",\"stack_co_free\":");  put_opt(&w, diag->stack_co);
+    put_str(&w, ",\"stack_sensor_free\":"); put_opt(&w, diag->stack_sensor);
+    put_str(&w, ",\"stack_mic_free\":"); put_opt(&w, diag->stack_mic);
+    put_str(&w, ",\"stack_net_free\":"); put_opt(&w, diag->stack_net);
+    put_str(&w, ",\"heap_free\":");      put_uint(&w, diag->heap_free);
+    put_str(&w, ",\"heap_min\":");       put_uint(&w, diag->heap_min);
+    put_str(&w, ",\"i2c_cancelled\":");  put_uint(&w, diag->i2c_cancelled);
+    put_str(&w, ",\"i2c_abandoned\":");  put_uint(&w, diag->i2c_abandoned);
+    put_char(&w, '}');
+    return w.overflow ? 0 : (size_t)(w.pos - buf);
+}
+
+/* ---- Binary frame ---- */
+
+static uint8_t *put_u16le(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+/* Clamp to the u16 range, below the "no reading" code */
+static uint16_t to_u16(int32_t v)
+{
+    if (v < 0) return 0;
+    return v >= PAYLOAD_BIN_INVALID ? PAYLOAD_BIN_INVALID - 1 : (uint16_t)v;
+}
+
+/* A value of ENV_AGG_* field i in the field's binary scale */
+static uint16_t bin_agg(int i, int32_t v)
+{
+    switch (i) {
+    case ENV_AGG_TEMP:
+        if (v < INT16_MIN) return (uint16_t)INT16_MIN;
+        return (uint16_t)(v > INT16_MAX ? INT16_MAX : v);
+    case ENV_AGG_HUM:
+    case ENV_AGG_PRESS: return to_u16(div_round(v, 10));
+    case ENV_AGG_CO:    return to_u16(div_round(v, 100));
+    default:            return to_u16(v);
+    }
+}
+
+EnvSpread_t Payload_packSpread(int i, const WindowSpread_t *s)
+{
+    return (EnvSpread_t){
+        .min = bin_agg(i, s->min),
+        .max = bin_agg(i, s->max),
+        .sd  = bin_agg(i, s->sd > INT32_MAX ? INT32_MAX : (int32_t)s->sd),
+    };
+}
+
+int32_t Payload_spreadValue(int i, uint16_t v)
+{
+    switch (i) {
+    case ENV_AGG_TEMP:  return (int16_t)v;
+    case ENV_AGG_HUM:
+    case ENV_AGG_PRESS: return (int32_t)v * 10;
+    case ENV_AGG_CO:    return (int32_t)v * 100;
+    default:            return v;
+    }
+}
+
+static void put_record(uint8_t *p, const EnvData_t *d, uint16_t age_s)
+{
+    p = put_u16le(p, age_s);
+    p = put_u16le(p, (uint16_t)d->temp_cc);
+    p = put_u16le(p, to_u16(div_round((int32_t)d->hum_mrh, 10)));
+    p = put_u16le(p, to_u16(div_round((int32_t)d->press_pa, 10)));
+    p = put_u16le(p, d->eco2);
+    p = put_u16le(p, d->tvoc);
+    p = put_u16le(p, d->co_mppm < 0 ? PAYLOAD_BIN_INVALID
+                                    : to_u16(div_round(d->co_mppm, 100)));
+    p = put_u16le(p, d->lux);
+    p = put_u16le(p, d->pm1_dug);
+    p = put_u16le(p, d->pm25_dug);
+    p = put_u16le(p, d->pm10_dug);
+    p = put_u16le(p, d->noise_ddb);
+    *p++ = d->co_alarm ? PAYLOAD_BIN_FLAG_CO_ALARM : 0;
+    p = put_u16le(p, d->laeq_ddb);
+    p = put_u16le(p, d->lamax_ddb);
+    p = put_u16le(p, d->lamin_ddb);
+    p = put_u16le(p, d->la10_ddb);
+    p = put_u16le(p, d->la90_ddb);
+    for (int i = 0; i < ENV_AGG_COUNT; i++) {
+        p = put_u16le(p, d->spread[i].min);
+        p = put_u16le(p, d->spread[i].max);
+        p = put_u16le(p, d->spread[i].sd);
+    }
+}
+
+/* ---- Batch encoder ---- */
+
+void PayloadBatch_begin(PayloadBatch_t *batch, uint8_t format,
+                        uint8_t max_records, void *buf, size_t size)
+{
+    batch->buf = buf;
+    batch->size = size;
+    batch->len = 0;
+    batch->format = format;
+    batch->max_records = max_records;
+    batch->count = 0;
+
+    if (format == PAYLOAD_BINARY) {
+        batch->len = PAYLOAD_BIN_HEADER_LEN;   /* Header written by end() */
+    } else if (max_records > 1) {
+        batch->len = 1;                        /* '[' */
+    }
+}
+
+bool PayloadBatch_add(PayloadBatch_t *batch, const EnvData_t *data,
+                      uint32_t fields, uint16_t age_s)
+{
+    if (batch->count >= batch->max_records) return false;
+
+    if (batch->format == PAYLOAD_BINARY) {
+        if (batch->len + PAYLOAD_BIN_RECORD_LEN > batch->size) return false;
+        put_record(batch->buf + batch->len, data, age_s);
+        batch->len += PAYLOAD_BIN_RECORD_LEN;
+    } else {
+        /* Arrays keep one byte in reserve for the closing ']' */
+        bool array = batch->max_records > 1;
+        char *start = (char *)batch->buf + batch->len;
+        Writer w = { start, (char *)batch->buf + batch->size - (array ? 1 : 0), false };
+        if (batch->count > 0) put_char(&w, ',');
+        put_json_object(&w, data, fields, array, age_s);
+        if (w.overflow) return false;
+        batch->len += (size_t)(w.pos - start);
+    }
+
+    batch->count++;
+    return true;
+}
+
+size_t PayloadBatch_end(PayloadBatch_t *batch)
+{
+    if (batch->count == 0) return 0;
+
+    if (batch->format == PAYLOAD_BINARY) {
+        batch->buf[0] = PAYLOAD_BIN_MAGIC;
+        batch->buf[1] = PAYLOAD_BIN_VERSION;
+        batch->buf[2] = batch->count;
+        batch->buf[3] = 0;
+    } else if (batch->max_records > 1) {
+        batch->buf[0] = '[';
+        batch->buf[batch->len++] = ']';
+    }
+    return batch->len;
+}
@@ -0,0 +1,210 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "env_data.h"
+#include "profile.h"
+#include "window_stat.h"
+
+/*
+ * JSON: a batch of one sample is the single object Telegraf has always
+ * received. Larger batches are an array of objects, each with an extra
+ * "age" field (seconds before the message was sent). Fixed-point
+ * fields are rounded to one decimal, without printf or heap use. An
+ * object carries only the fields report-by-exception chose (report.h);
+ * binary records always carry all of them. Each window-averaged field
+ * is followed by the spread of its readings, e.g. "temp":21.4,
+ * "temp_min":21.3,"temp_max":21.6,"temp_sd":0.1, left out if the
+ * window had none.
+ */
+
+/* Worst-case JSON length for one sample object incl. "age" and separator. */
+#define PAYLOAD_JSON_MAX            776
+#define PAYLOAD_JSON_BATCH_MAX(n)   (2 + (n) * PAYLOAD_JSON_MAX)
+
+/*
+ * Binary frame (all multi-byte fields little-endian)
+ *
+ *   Header, 4 bytes:
+ *     0  u8   magic 'E' (0x45)
+ *     1  u8   version (3)
+ *     2  u8   record count (oldest first)
+ *     3  u8   reserved (0)
+ *
+ *   Record, 95 bytes each:
+ *     0  u16  age_s      seconds before the frame was sent
+ *     2  i16  temp       0.01 C
+ *     4  u16  hum        0.01 %RH
+ *     6  u16  press      0.1 hPa
+ *     8  u16  eco2       ppm
+ *    10  u16  tvoc       ppb
+ *    12  u16  co         0.1 ppm
+ *    14  u16  lux        lux
+ *    16  u16  pm1        0.1 ug/m3
+ *    18  u16  pm25       0.1 ug/m3
+ *    20  u16  pm10       0.1 ug/m3
+ *    22  u16  noise      0.1 dB
+ *    24  u8   flags      bit 0: CO alarm active
+ *    25  u16  laeq       0.1 dB(A)
+ *    27  u16  lamax      0.1 dB(A)
+ *    29  u16  lamin      0.1 dB(A)
+ *    31  u16  la10       0.1 dB(A)
+ *    33  u16  la90       0.1 dB(A)
+ *    35  10 x spread, 6 bytes each, for temp, hum, press, eco2, tvoc,
+ *        co, lux, pm1, pm25, pm10 in turn:
+ *         0  u16  min    in the field's own scale (temp as i16)
+ *         2  u16  max
+ *         4  u16  sd     standard deviation; 0xFFFF: no readings in
+ *                        the window (min and max 0)
+ *
+ * Version 1 records stopped at flags (25 bytes), version 2 at la90
+ * (35 bytes).
+ *
+ * co, eco2, tvoc and pm* use 0xFFFF for "no reading" (negative co,
+ * or ENV_NO_READING from the driver, e.g. during sensor warm-up);
+ * other fields saturate at their range limits. The Pi-side
+ * decoder in pi/envframe.c must be kept in step with this layout.
+ */
+#define PAYLOAD_BIN_MAGIC       0x45
+#define PAYLOAD_BIN_VERSION     3
+#define PAYLOAD_BIN_HEADER_LEN  4
+#define PAYLOAD_BIN_RECORD_LEN  95
+#define PAYLOAD_BIN_INVALID     0xFFFF
+#define PAYLOAD_BIN_FLAG_CO_ALARM  0x01
+
+#define PAYLOAD_BIN_BATCH_MAX(n)    (PAYLOAD_BIN_HEADER_LEN + (n) * PAYLOAD_BIN_RECORD_LEN)
+
+/* The spread of ENV_AGG_* field i, packed as records carry it; the
+ * sample keeps it in this form from the window to the serializer. */
+EnvSpread_t Payload_packSpread(int i, const WindowSpread_t *spread);
+
+/* One packed spread value of field i, back in the field's own units. */
+int32_t Payload_spreadValue(int i, uint16_t v);
+
+/* Out-of-band CO alarm message, always JSON, e.g.
+ * {"co_ppm":61.2,"co_alert":true} */
+#define PAYLOAD_ALERT_MAX       48
+
+/* Write the alert into buf. Returns its length, or 0 if it does not fit. */
+size_t Payload_alert(char *buf, size_t size, int32_t co_mppm, bool active);
+
+/* Sampling interval change (sample_rate.h), always JSON, e.g.
+ * {"interval_s":10,"was_s":30,"cause":"co_ppm","ratio":310,"changes":4}
+ * cause is the reading that set the pace, or "quiet"; ratio its rate
+ * in % of its threshold; changes counts them since boot, so a change
+ * overtaken by the next before it was sent still shows. */
+#define PAYLOAD_RATE_MAX        96
+
+/* Write the change into buf. Returns its length, or 0 if it does not
+ * fit. */
+size_t Payload_rate(char *buf, size_t size, int8_t cause, uint32_t interval_ms,
+                    uint32_t was_ms, uint16_t ratio_pct, uint32_t changes);
+
+#if PROFILE_ENABLE
+/* One profiling scope (profile.h), always JSON, cycles since boot, e.g.
+ * {"scope":"bme280_read","n":3600,"min_cyc":9120,"max_cyc":15440,
+ *  "mean_cyc":9876,"hist":[0,0,0,0,0,0,3598,2,0,0,0,0,0,0,0,0]} */
+#define PAYLOAD_PROFILE_MAX     320
+
+/* Write the scope into buf. Returns its length, or 0 if it does not
+ * fit. */
+size_t Payload_profile(char *buf, size_t size, const char *name,
+                       const ProfileStats_t *stats);
+#endif
+
+/* Periodic diagnostics, always JSON: uptime, the sensing task's 1 Hz
+ * tick timing since boot (sensor_sched.h), the boot-phase times in
+ * ms (boot_time.h, -1 until reached), the connection drops and
+ * reconnect latency (wifi_mqtt.h, -1 before the first reconnect), the
+ * energy account since boot (energy.h), the report-by-exception
+ * counts (report.h), the sampling interval (sample_rate.h) and the
+ * least free bytes ever of each task stack and of the heap
+ * (mem_stats.h, stack -1 for a task not running) and the I2C
+ * transfers cancelled on the bus after a timeout (i2c_bus.h), e.g.
+ * {"uptime":3600,"ticks":3599,"tick_skipped":0,"tick_late_max_ms":0,
+ *  "tick_min_us":999000,"tick_max_us":1001000,"tick_mean_us":1000000,
+ *  "boot_wifi_ms":2600,"boot_mqtt_ms":2620,"boot_sample_ms":15000,
+ *  "boot_valid_ms":75000,"boot_publish_ms":15003,"wifi_drops":0,
+ *  "mqtt_drops":1,"reconnect_ms":21600,"reconnect_max_ms":21600,
+ *  "power_uw":412000,"runtime_h":89,"mcu_lpds_s":0,"nwp_awake_s":5,
+ *  "samples_full":6,"samples_partial":92,"samples_suppressed":22,
+ *  "fields_suppressed":1530,"interval_s":30,"interval_min_s":5,
+ *  "rate_faster":3,"rate_slower":5,"stack_sl_free":1024,
+ *  "stack_co_free":712,"stack_sensor_free":936,"stack_mic_free":640,
+ *  "stack_net_free":1880,
+ *  "heap_free":21464,"heap_min":20920,"i2c_cancelled":0,
+ *  "i2c_abandoned":0} */
+#define PAYLOAD_DIAG_MAX        1024
+
+#define PAYLOAD_DIAG_NONE       UINT32_MAX  /* Not reached / no reconnect yet */
+
+typedef struct {
+    uint32_t uptime_s;
+    uint32_t ticks;
+    uint32_t skipped;
+    uint32_t late_max_ms;
+    uint32_t period_min_us;
+    uint32_t period_max_us;
+    uint32_t period_mean_us;
+    uint32_t wifi_ms;           /* Boot phases, or PAYLOAD_DIAG_NONE */
+    uint32_t mqtt_ms;
+    uint32_t first_sample_ms;
+    uint32_t first_valid_ms;
+    uint32_t first_publish_ms;
+    uint32_t wifi_drops;
+    uint32_t mqtt_drops;
+    uint32_t reconnect_ms;      /* Latest, or PAYLOAD_DIAG_NONE */
+    uint32_t reconnect_max_ms;
+    uint32_t power_uw;          /* Mean since boot */
+    uint32_t runtime_h;         /* On ENERGY_BATTERY_MWH at that power */
+    uint32_t mcu_lpds_s;        /* MCU time in LPDS */
+    uint32_t nwp_awake_s;
+    uint32_t samples_full;      /* Report by exception */
+    uint32_t samples_partial;
+    uint32_t samples_suppressed;
+    uint32_t fields_suppressed;
+    uint32_t interval_s;        /* Adaptive sampling */
+    uint32_t interval_min_s;
+    uint32_t rate_faster;
+    uint32_t rate_slower;
+    uint32_t stack_sl;          /* Least free bytes, or PAYLOAD_DIAG_NONE */
+    uint32_t stack_co;
+    uint32_t stack_sensor;
+    uint32_t stack_mic;
+    uint32_t stack_net;
+    uint32_t heap_free;
+    uint32_t heap_min;
+    uint32_t i2c_cancelled;     /* I2CBusStats_t */
+    uint32_t i2c_abandoned;
+} PayloadDiag_t;
+
+/* Write the diagnostics into buf. Returns its length, or 0 if it does
+ * not fit. */
+size_t Payload_diag(char *buf, size_t size, const PayloadDiag_t *diag);
+
+/* Incremental batch encoder writing directly into a caller buffer. */
+typedef struct {
+    uint8_t *buf;
+    size_t   size;
+    size_t   len;
+    uint8_t  format;        /* PAYLOAD_JSON or PAYLOAD_BINARY (config.h) */
+    uint8_t  max_records;
+    uint8_t  count;
+} PayloadBatch_t;
+
+/* Start a message of up to max_records samples (1..255) in buf. */
+void PayloadBatch_begin(PayloadBatch_t *batch, uint8_t format,
+                        uint8_t max_records, void *buf, size_t size);
+
+/* Append one sample taken age_s seconds ago, with its ENV_FIELD_*
+ * fields in JSON. Returns false, leaving the batch unchanged, if it is
+ * full or the sample does not fit. */
+bool PayloadBatch_add(PayloadBatch_t *batch, const EnvData_t *data,
+                      uint32_t fields, uint16_t age_s);
+
+/* Finish the message. Returns its exact length, or 0 if it is empty. */
+size_t PayloadBatch_end(PayloadBatch_t *batch);
+
+#endif
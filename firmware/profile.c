@@ -0,0 +1,92 @@
+#include "profile.h"
+
+#if PROFILE_ENABLE
+
+#include <ti/drivers/Power.h>
+#include <ti/drivers/power/PowerCC32XX.h>
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/devices/cc32xx/inc/hw_types.h>
+
+/* Cortex-M4 debug registers (ARMv7-M ARM C1.8) */
+#define DEMCR               0xE000EDFC
+#define DEMCR_TRCENA        0x01000000
+#define DWT_CTRL            0xE0001000
+#define DWT_CTRL_CYCCNTENA  0x00000001
+#define DWT_CYCCNT          0xE0001004
+
+static const char *const names[PROFILE_SCOPES] = {
+    "i2c_init", "sgp30_init", "bme280_init", "bh1750_init", "bmv080_init",
+    "mq7_init", "mic_init", "sgp30_tick", "sgp30_read", "bme280_read",
+    "bh1750_read", "bmv080_read", "mq7_read", "mic_read_db", "mic_levels",
+    "payload_build", "mqtt_publish",
+};
+
+static ProfileStats_t stats[PROFILE_SCOPES];
+static Power_NotifyObj enter_notify;
+static Power_NotifyObj wake_notify;
+static uint32_t carried;            /* Cycles counted before the last LPDS */
+
+static void start_counter(void)
+{
+    HWREG(DEMCR) |= DEMCR_TRCENA;
+    HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+}
+
+/* The debug block loses its state in LPDS and CYCCNT restarts from 0,
+ * so the count so far is carried over the sleep */
+static int_fast16_t lpds_event(uint_fast16_t eventType, uintptr_t eventArg,
+                               uintptr_t clientArg)
+{
+    (void)eventArg;
+    (void)clientArg;
+    if (eventType == PowerCC32XX_ENTERING_LPDS) {
+        carried += (uint32_t)HWREG(DWT_CYCCNT);
+    } else {
+        start_counter();
+    }
+    return Power_NOTIFYDONE;
+}
+
+void Profile_init(void)
+{
+    start_counter();
+    Power_registerNotify(&enter_notify, PowerCC32XX_ENTERING_LPDS,
+                         lpds_event, 0);
+    Power_registerNotify(&wake_notify, PowerCC32XX_AWAKE_LPDS,
+                         lpds_event, 0);
+}
+
+uint32_t Profile_cycles(void)
+{
+    uintptr_t key = HwiP_disable();
+    uint32_t cycles = carried + (uint32_t)HWREG(DWT_CYCCNT);
+    HwiP_restore(key);
+    return cycles;
+}
+
+void Profile_record(ProfileScope_t scope, uint32_t cycles)
+{
+    int bucket = 0;
+    uint32_t high = cycles >> PROFILE_HIST_SHIFT;
+    if (high != 0) bucket = 32 - __builtin_clz(high);
+    if (bucket >= PROFILE_BUCKETS) bucket = PROFILE_BUCKETS - 1;
+
+    uintptr_t key = HwiP_disable();
+    ProfileStats_t *s = &stats[scope];
+    if (s->count == 0 || cycles < s->min) s->min = cycles;
+    if (cycles > s->max) s->max = cycles;
+    s->sum += cycles;
+    s->count++;
+    s->hist[bucket]++;
+    HwiP_restore(key);
+}
+
+void Profile_get(ProfileScope_t scope, ProfileStats_t *out, const char **name)
+{
+    uintptr_t key = HwiP_disable();
+    *out = stats[scope];
+    HwiP_restore(key);
+    *name = names[scope];
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+/*
+ * Cycle profiling of the sensing and publish paths
+ *
+ * PROFILE_BEGIN(X) ... PROFILE_END(X) in one block times the code
+ * between them on the Cortex-M4 DWT cycle counter (80 MHz) into scope
+ * PROFILE_X: count, min, max, mean and a log2 histogram, kept in RAM
+ * since boot. CYCCNT only runs while the core is clocked, so a scope
+ * that blocks counts the cycles of whatever ran meanwhile (other tasks,
+ * interrupts) but not WFI or LPDS. LPDS also clears CYCCNT; the count
+ * reached before each LPDS entry is added back, so a scope spanning it
+ * does not wrap. With PROFILE_ENABLE 0 (the default)
+ * the macros are empty and nothing here is compiled in.
+ */
+
+typedef enum {
+    PROFILE_I2C_INIT,
+    PROFILE_SGP30_INIT,
+    PROFILE_BME280_INIT,
+    PROFILE_BH1750_INIT,
+    PROFILE_BMV080_INIT,
+    PROFILE_MQ7_INIT,
+    PROFILE_MIC_INIT,
+    PROFILE_SGP30_TICK,
+    PROFILE_SGP30_READ,
+    PROFILE_BME280_READ,
+    PROFILE_BH1750_READ,
+    PROFILE_BMV080_READ,
+    PROFILE_MQ7_READ,
+    PROFILE_MIC_READ_DB,
+    PROFILE_MIC_LEVELS,
+    PROFILE_PAYLOAD_BUILD,
+    PROFILE_MQTT_PUBLISH,
+    PROFILE_SCOPES
+} ProfileScope_t;
+
+/* Histogram bucket 0 holds runs under 2^PROFILE_HIST_SHIFT cycles
+ * (3.2 us), bucket i < PROFILE_BUCKETS - 1 those under
+ * 2^(PROFILE_HIST_SHIFT + i), the last one the rest (52 ms and up). */
+#define PROFILE_BUCKETS     16
+#define PROFILE_HIST_SHIFT  8
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;           /* Cycles */
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PROFILE_BUCKETS];
+} ProfileStats_t;
+
+#if PROFILE_ENABLE
+
+#define PROFILE_BEGIN(scope) \
+    uint32_t profile_##scope = Profile_cycles()
+#define PROFILE_END(scope) \
+    Profile_record(PROFILE_##scope, Profile_cycles() - profile_##scope)
+
+/* Start the cycle counter, and restart it after each LPDS. Call once,
+ * after Power_init(). */
+void Profile_init(void);
+
+/* Current cycle count. */
+uint32_t Profile_cycles(void);
+
+/* Add one run of `cycles` to scope. Safe from any task. */
+void Profile_record(ProfileScope_t scope, uint32_t cycles);
+
+/* Copy the statistics of scope; its name in *name. */
+void Profile_get(ProfileScope_t scope, ProfileStats_t *stats, const char **name);
+
+#else
+
+#define PROFILE_BEGIN(scope)
+#define PROFILE_END(scope)
+
+#endif
+
+#endif
@@ -0,0 +1,123 @@
+#include "report.h"
+#include "config.h"
+#include "payload.h"
+#include <ti/drivers/dpl/HwiP.h>
+#include <stdbool.h>
+
+#if REPORT_HEARTBEAT_MS < READ_INTERVAL_MS || \
+    (RATE_ADAPTIVE && REPORT_HEARTBEAT_MS < RATE_MAX_INTERVAL_MS)
+#error "REPORT_HEARTBEAT_MS must be at least the longest sampling interval"
+#endif
+
+#define NO_READING      INT32_MIN
+
+/* In ENV_FIELD_* bit order */
+static const uint32_t deadband[ENV_FIELD_COUNT] = {
+    REPORT_DB_TEMP_CC, REPORT_DB_HUM_MRH, REPORT_DB_PRESS_PA,
+    REPORT_DB_ECO2, REPORT_DB_TVOC, REPORT_DB_CO_MPPM, REPORT_DB_LUX,
+    REPORT_DB_PM_DUG, REPORT_DB_PM_DUG, REPORT_DB_PM_DUG,
+    REPORT_DB_NOISE_DDB, REPORT_DB_NOISE_DDB, REPORT_DB_NOISE_DDB,
+    REPORT_DB_NOISE_DDB, REPORT_DB_NOISE_DDB, REPORT_DB_NOISE_DDB,
+    0,                                          /* CO alarm: any change */
+};
+
+static int32_t sent[ENV_FIELD_COUNT];   /* Value last published */
+static uint32_t lost;                   /* Fields to send again */
+static bool started;
+static uint32_t full_ms;                /* Last complete sample */
+static ReportStats_t stats;
+
+static int32_t opt_u16(uint16_t v)
+{
+    return v == ENV_NO_READING ? NO_READING : v;
+}
+
+/* Field i (bit i of ENV_FIELD_*) of `d` in its env_data.h units, or
+ * NO_READING */
+static int32_t field(const EnvData_t *d, int i)
+{
+    switch (i) {
+    case 0:  return d->temp_cc;
+    case 1:  return (int32_t)d->hum_mrh;
+    case 2:  return (int32_t)d->press_pa;
+    case 3:  return opt_u16(d->eco2);
+    case 4:  return opt_u16(d->tvoc);
+    case 5:  return d->co_mppm < 0 ? NO_READING : d->co_mppm;
+    case 6:  return d->lux;
+    case 7:  return opt_u16(d->pm1_dug);
+    case 8:  return opt_u16(d->pm25_dug);
+    case 9:  return opt_u16(d->pm10_dug);
+    case 10: return d->noise_ddb;
+    case 11: return d->laeq_ddb;
+    case 12: return d->lamax_ddb;
+    case 13: return d->lamin_ddb;
+    case 14: return d->la10_ddb;
+    case 15: return d->la90_ddb;
+    default: return d->co_alarm;
+    }
+}
+
+static bool moved(int32_t now, int32_t ref, uint32_t band)
+{
+    if (now == NO_READING || ref == NO_READING) return now != ref;
+    uint32_t diff = now > ref ? (uint32_t)(now - ref) : (uint32_t)(ref - now);
+    return diff > band;
+}
+
+/* A spike within the window also counts: aggregated field i moved if
+ * any of its readings left the deadband around the value last sent */
+static bool spiked(const EnvData_t *d, int i, int32_t ref, uint32_t band)
+{
+    if (i >= ENV_AGG_COUNT || ref == NO_READING) return false;
+    const EnvSpread_t *s = &d->spread[i];
+    if (s->sd == ENV_NO_READING) return false;
+    return moved(Payload_spreadValue(i, s->min), ref, band) ||
+           moved(Payload_spreadValue(i, s->max), ref, band);
+}
+
+uint32_t Report_fields(const EnvData_t *data, uint32_t now_ms)
+{
+    bool full = !REPORT_BY_EXCEPTION || !started ||
+                now_ms - full_ms >= REPORT_HEARTBEAT_MS;
+    uintptr_t key = HwiP_disable();
+    uint32_t resend = lost;
+    lost = 0;
+    HwiP_restore(key);
+
+    uint32_t fields = 0;
+    for (int i = 0; i < ENV_FIELD_COUNT; i++) {
+        int32_t v = field(data, i);
+        if (full || (resend & (1UL << i)) || moved(v, sent[i], deadband[i]) ||
+            spiked(data, i, sent[i], deadband[i])) {
+            sent[i] = v;
+            fields |= 1UL << i;
+        }
+    }
+
+    if (full) {
+        started = true;
+        full_ms = now_ms;
+        stats.full++;
+    } else if (fields != 0) {
+        stats.partial++;
+    } else {
+        stats.suppressed++;
+    }
+    uint32_t n = 0;
+    for (uint32_t f = fields; f != 0; f &= f - 1) n++;
+    stats.fields_sent += n;
+    stats.fields_suppressed += ENV_FIELD_COUNT - n;
+    return fields;
+}
+
+void Report_lost(uint32_t fields)
+{
+    uintptr_t key = HwiP_disable();
+    lost |= fields;
+    HwiP_restore(key);
+}
+
+void Report_getStats(ReportStats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,43 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <stdint.h>
+#include "env_data.h"
+
+/*
+ * Report by exception
+ *
+ * Decides which fields of each sample are worth publishing. A field is
+ * sent when it has moved by more than its deadband (REPORT_DB_* in
+ * config.h) from the value last sent for it, or has gained or lost its
+ * reading, or when any reading of a window-averaged field did (a spike
+ * the mean smooths over); the JSON object leaves the others out. A
+ * sample with no such field is not published at all. Every
+ * REPORT_HEARTBEAT_MS a complete sample goes out regardless, so a
+ * quiet room still shows the device is alive. Binary records have a
+ * fixed layout: a sample there is sent whole or not at all. A sample
+ * lost on the way to the broker is reported back with Report_lost(),
+ * and its fields are sent again with the next sample.
+ * Report_fields() is called from one task only.
+ */
+
+typedef struct {
+    uint32_t full;              /* Complete samples: first, heartbeat */
+    uint32_t partial;           /* Samples sent with only some fields */
+    uint32_t suppressed;        /* Samples not sent at all */
+    uint32_t fields_sent;
+    uint32_t fields_suppressed;
+} ReportStats_t;
+
+/* ENV_FIELD_* bits of a sample taken at uptime now_ms to publish, or
+ * 0 to drop it. The values sent become the new references. */
+uint32_t Report_fields(const EnvData_t *data, uint32_t now_ms);
+
+/* A sample with these ENV_FIELD_* bits was dropped before reaching
+ * the broker: its values no longer count as sent, so the next sample
+ * carries these fields again. Safe from any task. */
+void Report_lost(uint32_t fields);
+
+void Report_getStats(ReportStats_t *stats);
+
+#endif
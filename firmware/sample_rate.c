@@ -0,0 +1,130 @@
+#include "sample_rate.h"
+#include "config.h"
+
+#if RATE_MIN_INTERVAL_MS < 1000 || RATE_MIN_INTERVAL_MS > RATE_MAX_INTERVAL_MS
+#error "RATE_MIN_INTERVAL_MS must be 1000..RATE_MAX_INTERVAL_MS"
+#endif
+#if RATE_SLEW_FASTER < 1 || RATE_QUIET_PCT >= 100 || RATE_SLOWER_PCT < 1
+#error "RATE_SLEW_FASTER must be >= 1, RATE_QUIET_PCT < 100, RATE_SLOWER_PCT >= 1"
+#endif
+
+#define NO_READING      INT32_MIN
+
+/* Per minute, in ENV_AGG_* order; 0 is not watched */
+static const uint32_t threshold[ENV_AGG_COUNT] = {
+    RATE_THR_TEMP_CC, RATE_THR_HUM_MRH, RATE_THR_PRESS_PA,
+    RATE_THR_ECO2, 0, RATE_THR_CO_MPPM, 0,
+    0, RATE_THR_PM_DUG, 0,
+};
+
+static int32_t prev[ENV_AGG_COUNT];
+static uint32_t prev_ms;
+static bool started;
+static uint32_t quiet_ms;           /* Last time a signal was not quiet */
+static SampleRateStats_t stats;
+
+static int32_t opt_u16(uint16_t v)
+{
+    return v == ENV_NO_READING ? NO_READING : v;
+}
+
+/* Signal i (ENV_AGG_*) of `d`, or NO_READING */
+static int32_t reading(const EnvData_t *d, int i)
+{
+    switch (i) {
+    case ENV_AGG_TEMP:  return d->temp_cc;
+    case ENV_AGG_HUM:   return (int32_t)d->hum_mrh;
+    case ENV_AGG_PRESS: return (int32_t)d->press_pa;
+    case ENV_AGG_ECO2:  return opt_u16(d->eco2);
+    case ENV_AGG_CO:    return d->co_mppm < 0 ? NO_READING : d->co_mppm;
+    case ENV_AGG_PM25:  return opt_u16(d->pm25_dug);
+    default:            return NO_READING;
+    }
+}
+
+/* Whole seconds, within the bounds */
+static uint32_t bound(uint64_t ms)
+{
+    ms = (ms + 500) / 1000 * 1000;
+    if (ms < RATE_MIN_INTERVAL_MS) return RATE_MIN_INTERVAL_MS;
+    if (ms > RATE_MAX_INTERVAL_MS) return RATE_MAX_INTERVAL_MS;
+    return (uint32_t)ms;
+}
+
+void SampleRate_init(uint32_t interval_ms)
+{
+    stats = (SampleRateStats_t){ .interval_ms = interval_ms, .min_ms = interval_ms };
+    started = false;
+}
+
+bool SampleRate_update(const EnvData_t *data, uint32_t now_ms,
+                       SampleRateDecision_t *decision)
+{
+    uint32_t dt = now_ms - prev_ms;
+
+    /* The fastest signal, as % of its threshold */
+    int cause = SAMPLE_RATE_QUIET;
+    uint32_t ratio = 0;
+    for (int i = 0; i < ENV_AGG_COUNT; i++) {
+        int32_t v = reading(data, i);
+        if (started && dt > 0 && threshold[i] != 0 &&
+            v != NO_READING && prev[i] != NO_READING) {
+            uint32_t diff = v > prev[i] ? (uint32_t)(v - prev[i]) : (uint32_t)(prev[i] - v);
+            uint64_t r = (uint64_t)diff * 60000U * 100U / ((uint64_t)threshold[i] * dt);
+            if (r > UINT16_MAX) r = UINT16_MAX;
+            if (r > ratio) {
+                ratio = (uint32_t)r;
+                cause = i;
+            }
+        }
+        prev[i] = v;
+    }
+    prev_ms = now_ms;
+    if (!started) {
+        started = true;
+        quiet_ms = now_ms;
+        return false;
+    }
+
+    uint32_t was = stats.interval_ms;
+    uint32_t next = was;
+    if (ratio >= 100) {
+        uint64_t floor = was / RATE_SLEW_FASTER;
+        uint64_t target = (uint64_t)was * 100U / ratio;
+        next = bound(target < floor ? floor : target);
+        if (next > was) next = was;
+        quiet_ms = now_ms;
+    } else if (ratio >= RATE_QUIET_PCT) {
+        quiet_ms = now_ms;
+    } else if (now_ms - quiet_ms >= RATE_HOLD_MS) {
+        next = bound((uint64_t)was * (100U + RATE_SLOWER_PCT) / 100U);
+        quiet_ms = now_ms;
+        cause = SAMPLE_RATE_QUIET;
+    }
+    if (next == was) return false;
+
+    if (next < was) {
+        stats.faster++;
+    } else {
+        stats.slower++;
+    }
+    if (next < stats.min_ms) stats.min_ms = next;
+    stats.interval_ms = next;
+
+    decision->interval_ms = next;
+    decision->was_ms = was;
+    decision->cause = (int8_t)cause;
+    decision->ratio_pct = (uint16_t)ratio;
+    decision->changes = stats.faster + stats.slower;
+    return true;
+}
+
+uint32_t SampleRate_interval(void)
+{
+    return stats.interval_ms;
+}
+
+void SampleRate_getStats(SampleRateStats_t *out)
+{
+    *out = stats;
+}
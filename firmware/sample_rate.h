@@ -0,0 +1,56 @@
+#ifndef SAMPLE_RATE_H
+#define SAMPLE_RATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "env_data.h"
+
+/*
+ * Adaptive sampling interval
+ *
+ * Every RATE_EVAL_MS the controller compares how fast each watched
+ * reading has moved since the last evaluation against its threshold
+ * (RATE_THR_*, per minute, in config.h). The fastest signal sets the
+ * pace: at k times its threshold the interval is cut to 1/k, by no
+ * more than a factor RATE_SLEW_FASTER per evaluation and never below
+ * RATE_MIN_INTERVAL_MS. Once every signal has stayed under
+ * RATE_QUIET_PCT of its threshold for RATE_HOLD_MS, the interval
+ * grows by RATE_SLOWER_PCT, and again after each further hold, up to
+ * RATE_MAX_INTERVAL_MS. In between, it holds. Called from one task
+ * only.
+ */
+
+#define SAMPLE_RATE_QUIET   (-1)    /* Cause of a slower interval */
+
+/* One change of interval */
+typedef struct {
+    uint32_t interval_ms;
+    uint32_t was_ms;
+    int8_t   cause;             /* ENV_AGG_* signal that set the pace, or
+                                 * SAMPLE_RATE_QUIET */
+    uint16_t ratio_pct;         /* Its rate as % of its threshold */
+    uint32_t changes;           /* Since boot, this one included */
+} SampleRateDecision_t;
+
+typedef struct {
+    uint32_t interval_ms;       /* Current */
+    uint32_t min_ms;            /* Shortest since boot */
+    uint32_t faster;            /* Changes to a shorter interval */
+    uint32_t slower;
+} SampleRateStats_t;
+
+/* Start at interval_ms. */
+void SampleRate_init(uint32_t interval_ms);
+
+/* Evaluate the latest readings (CO as co_mppm, negative: none) taken
+ * at uptime now_ms. Returns true, with the change in *decision, if
+ * the interval changed. */
+bool SampleRate_update(const EnvData_t *data, uint32_t now_ms,
+                       SampleRateDecision_t *decision);
+
+/* Current interval. */
+uint32_t SampleRate_interval(void);
+
+void SampleRate_getStats(SampleRateStats_t *stats);
+
+#endif
@@ -0,0 +1,66 @@
+#include "sample_ring.h"
+#include "config.h"
+#include <stddef.h>
+
+/*
+ * Fixed-depth ring of timestamped samples
+ *
+ * Statically allocated, single producer and consumer on the same
+ * thread. Samples stay queued until the publisher consumes them, so a
+ * failed publish keeps them for the next attempt.
+ */
+
+static EnvSample_t ring[SAMPLE_RING_DEPTH];
+static uint16_t head;       /* Index of the oldest sample */
+static uint16_t count;
+static SampleRingStats_t stats;
+
+void SampleRing_init(void)
+{
+    head = 0;
+    count = 0;
+    stats = (SampleRingStats_t){0};
+}
+
+uint32_t SampleRing_push(const EnvSample_t *sample)
+{
+    uint16_t tail = (uint16_t)((head + count) % SAMPLE_RING_DEPTH);
+    uint32_t lost = count == SAMPLE_RING_DEPTH ? ring[tail].fields : 0;
+    ring[tail] = *sample;
+
+    if (count == SAMPLE_RING_DEPTH) {
+        head = (uint16_t)((head + 1) % SAMPLE_RING_DEPTH);
+        stats.overwritten++;
+    } else {
+        count++;
+    }
+
+    stats.pushed++;
+    if (count > stats.high_water) stats.high_water = count;
+    return lost;
+}
+
+uint16_t SampleRing_count(void)
+{
+    return count;
+}
+
+const EnvSample_t *SampleRing_peek(uint16_t i)
+{
+    if (i >= count) return NULL;
+    return &ring[(head + i) % SAMPLE_RING_DEPTH];
+}
+
+void SampleRing_consume(uint16_t n)
+{
+    if (n > count) n = count;
+    head = (uint16_t)((head + n) % SAMPLE_RING_DEPTH);
+    count = (uint16_t)(count - n);
+    stats.consumed += n;
+}
+
+void SampleRing_getStats(SampleRingStats_t *out)
+{
+    *out = stats;
+    out->depth = count;
+}
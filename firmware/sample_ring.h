@@ -0,0 +1,36 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "env_data.h"
+
+typedef struct {
+    uint32_t pushed;        /* Samples added since boot */
+    uint32_t consumed;      /* Samples removed once published or spilled */
+    uint32_t overwritten;   /* Samples lost because the ring was full */
+    uint16_t depth;         /* Samples currently queued */
+    uint16_t high_water;    /* Largest depth seen since boot */
+} SampleRingStats_t;
+
+/* Empty the ring and reset its statistics. */
+void SampleRing_init(void);
+
+/* Queue a sample. When the ring is full the oldest sample is
+ * overwritten and counted in the statistics. Returns the ENV_FIELD_*
+ * bits of the overwritten sample, or 0 if none was. */
+uint32_t SampleRing_push(const EnvSample_t *sample);
+
+/* Number of queued samples. */
+uint16_t SampleRing_count(void);
+
+/* Return the i-th oldest queued sample, or NULL if i >= count. */
+const EnvSample_t *SampleRing_peek(uint16_t i);
+
+/* Drop the n oldest samples (after they were published or spilled). */
+void SampleRing_consume(uint16_t n);
+
+/* Copy the current statistics. */
+void SampleRing_getStats(SampleRingStats_t *stats);
+
+#endif
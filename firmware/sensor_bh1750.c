@@ -1,47 +1,49 @@
 #include "sensor_bh1750.h"
 #include "Board.h"
-#include <unistd.h>
+#include "i2c_bus.h"
 #include <stdbool.h>
 
 /* BH1750 Commands */
 #define BH1750_POWER_ON             0x01
 #define BH1750_CONTINUOUS_HIGH_RES  0x10  /* 1 lux resolution, typ 120ms / max 180ms */
 
-static bool bh1750_send_cmd(I2C_Handle i2c, uint8_t cmd)
-{
-    I2C_Transaction txn = {0};
-    txn.targetAddress = BH1750_I2C_ADDR;
-    txn.writeBuf = &cmd;
-    txn.writeCount = 1;
-    txn.readBuf = NULL;
-    txn.readCount = 0;
-    return I2C_transfer(i2c, &txn);
-}
+/* A 2-byte read is about 0.3 ms of bus time */
+#define BH1750_I2C_TIMEOUT_MS       50
+
+static I2CBusDevice bh1750 = I2CBUS_DEVICE("BH1750", BH1750_I2C_ADDR);
+
+static const uint8_t power_on_cmd = BH1750_POWER_ON;
+static const uint8_t high_res_cmd = BH1750_CONTINUOUS_HIGH_RES;
 
-void BH1750_init(I2C_Handle i2c)
+static I2CBusJob power_on_job = {
+    .dev = &bh1750, .writeBuf = &power_on_cmd, .writeCount = 1,
+    .settle_ms = 10,
+};
+
+/* First measurement takes up to 180ms */
+static I2CBusJob high_res_job = {
+    .dev = &bh1750, .writeBuf = &high_res_cmd, .writeCount = 1,
+    .settle_ms = 180,
+};
+
+void BH1750_init(void)
 {
-    bh1750_send_cmd(i2c, BH1750_POWER_ON);
-    usleep(10000);
-    bh1750_send_cmd(i2c, BH1750_CONTINUOUS_HIGH_RES);
-    usleep(180000);  /* First measurement takes up to 180ms */
+    /* Both commands run in the background; a read waits for the
+     * first measurement */
+    I2CBus_attach(&bh1750);
+    I2CBus_submit(&power_on_job);
+    I2CBus_submit(&high_res_job);
 }
 
-void BH1750_read(I2C_Handle i2c, uint16_t *lux)
+bool BH1750_read(uint16_t *lux)
 {
     uint8_t buf[2] = {0, 0};
-    I2C_Transaction txn = {0};
-    txn.targetAddress = BH1750_I2C_ADDR;
-    txn.writeBuf = NULL;
-    txn.writeCount = 0;
-    txn.readBuf = buf;
-    txn.readCount = 2;
-
-    if (!I2C_transfer(i2c, &txn)) {
-        *lux = 0;
-        return;
-    }
+    I2CBusJob job = { .dev = &bh1750, .readBuf = buf, .readCount = 2 };
+
+    if (!I2CBus_run(&job, BH1750_I2C_TIMEOUT_MS)) return false;
 
     /* Raw value / 1.2 = lux (per datasheet) */
     uint16_t raw = (uint16_t)((uint16_t)buf[0] << 8 | buf[1]);
     *lux = (uint16_t)((uint32_t)raw * 5 / 6);  /* Integer equivalent of raw/1.2 */
+    return true;
 }
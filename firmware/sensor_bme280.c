@@ -1,5 +1,6 @@
 #include "sensor_bme280.h"
 #include "Board.h"
+#include "i2c_bus.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -13,6 +14,9 @@
 /* Expected chip ID */
 #define BME280_CHIP_ID          0x60
 
+/* A register access is a few hundred us of bus time */
+#define BME280_I2C_TIMEOUT_MS   50
+
 /* Calibration data stored after reading from sensor */
 static struct {
     uint16_t dig_T1;
@@ -27,35 +31,30 @@ static struct {
 
 static int32_t t_fine;
 
-static bool i2c_write_reg(I2C_Handle i2c, uint8_t reg, uint8_t val)
+static I2CBusDevice bme280 = I2CBUS_DEVICE("BME280", BME280_I2C_ADDR);
+
+/* Register access waits for the transfer; other devices' jobs and
+ * other tasks run meanwhile */
+static bool i2c_write_reg(uint8_t reg, uint8_t val)
 {
     uint8_t txBuf[2] = {reg, val};
-    I2C_Transaction txn = {0};
-    txn.targetAddress = BME280_I2C_ADDR;
-    txn.writeBuf = txBuf;
-    txn.writeCount = 2;
-    txn.readBuf = NULL;
-    txn.readCount = 0;
-    return I2C_transfer(i2c, &txn);
+    I2CBusJob job = { .dev = &bme280, .writeBuf = txBuf, .writeCount = 2 };
+    return I2CBus_run(&job, BME280_I2C_TIMEOUT_MS);
 }
 
-static bool i2c_read_regs(I2C_Handle i2c, uint8_t reg, uint8_t *buf, uint8_t len)
+static bool i2c_read_regs(uint8_t reg, uint8_t *buf, uint8_t len)
 {
-    I2C_Transaction txn = {0};
-    txn.targetAddress = BME280_I2C_ADDR;
-    txn.writeBuf = &reg;
-    txn.writeCount = 1;
-    txn.readBuf = buf;
-    txn.readCount = len;
-    return I2C_transfer(i2c, &txn);
+    I2CBusJob job = { .dev = &bme280, .writeBuf = &reg, .writeCount = 1,
+                      .readBuf = buf, .readCount = len };
+    return I2CBus_run(&job, BME280_I2C_TIMEOUT_MS);
 }
 
-static void read_calibration(I2C_Handle i2c)
+static void read_calibration(void)
 {
     uint8_t buf[26];
 
     /* Temperature and pressure calibration: 0x88..0xA1 */
-    i2c_read_regs(i2c, 0x88, buf, 26);
+    i2c_read_regs(0x88, buf, 26);
     cal.dig_T1 = (uint16_t)((uint16_t)buf[1] << 8 | buf[0]);
     cal.dig_T2 = (int16_t)((uint16_t)buf[3] << 8 | buf[2]);
     cal.dig_T3 = (int16_t)((uint16_t)buf[5] << 8 | buf[4]);
@@ -70,10 +69,10 @@ static void read_calibration(I2C_Handle i2c)
     cal.dig_P9 = (int16_t)((uint16_t)buf[23] << 8 | buf[22]);
 
     /* Humidity calibration: 0xA1, then 0xE1..0xE7 */
-    i2c_read_regs(i2c, 0xA1, buf, 1);
+    i2c_read_regs(0xA1, buf, 1);
     cal.dig_H1 = buf[0];
 
-    i2c_read_regs(i2c, 0xE1, buf, 7);
+    i2c_read_regs(0xE1, buf, 7);
     cal.dig_H2 = (int16_t)((uint16_t)buf[1] << 8 | buf[0]);
     cal.dig_H3 = buf[2];
 
@@ -89,7 +88,11 @@ static void read_calibration(I2C_Handle i2c)
     cal.dig_H6 = (int8_t)buf[6];
 }
 
-static float compensate_temperature(int32_t adc_T)
+/* Bosch's integer compensation (datasheet section 4.2.3), kept in
+ * the integer units it produces */
+
+/* 0.01 C */
+static int32_t compensate_temperature(int32_t adc_T)
 {
     int32_t var1 = ((((adc_T >> 3) - ((int32_t)cal.dig_T1 << 1))) *
                     ((int32_t)cal.dig_T2)) >> 11;
@@ -97,10 +100,11 @@ static float compensate_temperature(int32_t adc_T)
                       ((adc_T >> 4) - ((int32_t)cal.dig_T1))) >> 12) *
                     ((int32_t)cal.dig_T3)) >> 14;
     t_fine = var1 + var2;
-    return (t_fine * 5 + 128) / 25600.0f;
+    return (t_fine * 5 + 128) >> 8;
 }
 
-static float compensate_pressure(int32_t adc_P)
+/* Pa */
+static uint32_t compensate_pressure(int32_t adc_P)
 {
     int64_t var1 = ((int64_t)t_fine) - 128000;
     int64_t var2 = var1 * var1 * (int64_t)cal.dig_P6;
@@ -116,10 +120,11 @@ static float compensate_pressure(int32_t adc_P)
     var1 = (((int64_t)cal.dig_P9) * (p >> 13) * (p >> 13)) >> 25;
     var2 = (((int64_t)cal.dig_P8) * p) >> 19;
     p = ((p + var1 + var2) >> 8) + (((int64_t)cal.dig_P7) << 4);
-    return (float)p / 25600.0f;  /* Pa -> hPa */
+    return (uint32_t)((p + 128) >> 8);     /* Q24.8 Pa -> Pa */
 }
 
-static float compensate_humidity(int32_t adc_H)
+/* 0.001 %RH */
+static uint32_t compensate_humidity(int32_t adc_H)
 {
     int32_t v = t_fine - 76800;
     v = (((((adc_H << 14) - (((int32_t)cal.dig_H4) << 20) -
@@ -130,39 +135,36 @@ static float compensate_humidity(int32_t adc_H)
     v = v - (((((v >> 15) * (v >> 15)) >> 7) * ((int32_t)cal.dig_H1)) >> 4);
     v = (v < 0) ? 0 : v;
     v = (v > 419430400) ? 419430400 : v;
-    return (float)(v >> 12) / 1024.0f;
+    return ((uint32_t)(v >> 12) * 1000 + 512) >> 10;   /* Q22.10 %RH */
 }
 
-void BME280_init(I2C_Handle i2c)
+void BME280_init(void)
 {
-    read_calibration(i2c);
+    I2CBus_attach(&bme280);
+    read_calibration();
 
     /* Humidity oversampling x1 */
-    i2c_write_reg(i2c, BME280_REG_CTRL_HUM, 0x01);
+    i2c_write_reg(BME280_REG_CTRL_HUM, 0x01);
 
     /* Config: standby 500ms, IIR filter coeff 16 */
-    i2c_write_reg(i2c, BME280_REG_CONFIG, 0x90);
+    i2c_write_reg(BME280_REG_CONFIG, 0x90);
 
     /* Ctrl_meas: temp x2, press x16, normal mode */
-    i2c_write_reg(i2c, BME280_REG_CTRL_MEAS, 0x57);
+    i2c_write_reg(BME280_REG_CTRL_MEAS, 0x57);
 }
 
-void BME280_read(I2C_Handle i2c, float *temp, float *hum, float *press)
+bool BME280_read(int16_t *temp_cc, uint32_t *hum_mrh, uint32_t *press_pa)
 {
     uint8_t buf[8];
-    if (!i2c_read_regs(i2c, BME280_REG_DATA_START, buf, 8)) {
-        *temp = 0.0f;
-        *hum = 0.0f;
-        *press = 0.0f;
-        return;
-    }
+    if (!i2c_read_regs(BME280_REG_DATA_START, buf, 8)) return false;
 
     int32_t adc_P = ((int32_t)buf[0] << 12) | ((int32_t)buf[1] << 4) | (buf[2] >> 4);
     int32_t adc_T = ((int32_t)buf[3] << 12) | ((int32_t)buf[4] << 4) | (buf[5] >> 4);
     int32_t adc_H = ((int32_t)buf[6] << 8) | buf[7];
 
     /* Temperature must be computed first — sets t_fine for pressure and humidity */
-    *temp  = compensate_temperature(adc_T);
-    *press = compensate_pressure(adc_P);
-    *hum   = compensate_humidity(adc_H);
+    *temp_cc  = (int16_t)compensate_temperature(adc_T);
+    *press_pa = compensate_pressure(adc_P);
+    *hum_mrh  = compensate_humidity(adc_H);
+    return true;
 }
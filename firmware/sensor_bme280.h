@@ -1,13 +1,15 @@
 #ifndef SENSOR_BME280_H
 #define SENSOR_BME280_H
 
-#include <ti/drivers/I2C.h>
+#include <stdint.h>
+#include <stdbool.h>
 
-/* Initialize BME280 sensor on I2C bus.
+/* Initialize BME280 sensor on the I2C bus engine (i2c_bus.h).
  * Configures oversampling and filter settings. */
-void BME280_init(I2C_Handle i2c);
+void BME280_init(void);
 
-/* Read temperature (C), humidity (%RH), and pressure (hPa). */
-void BME280_read(I2C_Handle i2c, float *temp, float *hum, float *press);
+/* Read temperature (0.01 C), humidity (0.001 %RH), and pressure (Pa).
+ * Returns false, leaving the outputs unchanged, if the read fails. */
+bool BME280_read(int16_t *temp_cc, uint32_t *hum_mrh, uint32_t *press_pa);
 
 #endif
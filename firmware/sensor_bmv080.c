@@ -1,5 +1,6 @@
 #include "sensor_bmv080.h"
 #include "Board.h"
+#include "env_data.h"
 #include <stdint.h>
 
 /*
@@ -13,26 +14,24 @@
  *   https://www.bosch-sensortec.com/software-tools/software/previous-sdk-bmv-080-versions/
  *
  * The SDK requires:
- *   1. I2C read/write callback shims wrapping TI I2C_transfer()
+ *   1. I2C read/write callback shims wrapping I2CBus_run() (i2c_bus.h)
  *   2. bmv080_init() with the I2C interface struct
  *   3. bmv080_serve_interrupt() called at least 1 Hz
  *   4. bmv080_get_data() to retrieve PM1/PM2.5/PM10 values
  *
- * Until the SDK is integrated, this driver returns -1.0 sentinel values
+ * Until the SDK is integrated, this driver returns ENV_NO_READING
  * so downstream code can detect that PM data is unavailable.
  */
 
-void BMV080_init(I2C_Handle i2c)
+void BMV080_init(void)
 {
-    (void)i2c;
     /* Stub — no hardware initialization without Bosch SDK */
 }
 
-void BMV080_read(I2C_Handle i2c, float *pm1, float *pm25, float *pm10)
+void BMV080_read(uint16_t *pm1_dug, uint16_t *pm25_dug, uint16_t *pm10_dug)
 {
-    (void)i2c;
     /* Return sentinel values indicating PM data is unavailable */
-    *pm1  = -1.0f;
-    *pm25 = -1.0f;
-    *pm10 = -1.0f;
+    *pm1_dug  = ENV_NO_READING;
+    *pm25_dug = ENV_NO_READING;
+    *pm10_dug = ENV_NO_READING;
 }
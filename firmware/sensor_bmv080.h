@@ -1,13 +1,14 @@
 #ifndef SENSOR_BMV080_H
 #define SENSOR_BMV080_H
 
-#include <ti/drivers/I2C.h>
+#include <stdint.h>
 
 /* Initialize BMV080 particulate matter sensor.
  * Configures continuous measurement mode via I2C. */
-void BMV080_init(I2C_Handle i2c);
+void BMV080_init(void);
 
-/* Read PM1, PM2.5, and PM10 concentrations in ug/m3. */
-void BMV080_read(I2C_Handle i2c, float *pm1, float *pm25, float *pm10);
+/* Read PM1, PM2.5, and PM10 concentrations in 0.1 ug/m3, or
+ * ENV_NO_READING (env_data.h) when unavailable. */
+void BMV080_read(uint16_t *pm1_dug, uint16_t *pm25_dug, uint16_t *pm10_dug);
 
 #endif
@@ -1,56 +1,483 @@
 #include "sensor_mic.h"
-#include <math.h>
+#include "Board.h"
+#include "config.h"
+#include "energy.h"
+#include <ti/drivers/ADCBuf.h>
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/drivers/dpl/SemaphoreP.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
 
 /*
  * MEMS Microphone Driver (SPH8878LR5H-1)
  *
  * The breakout board includes an op-amp that brings the mic output
  * to a usable level (~200mV peak-to-peak for normal speech).
- * We sample a window of ADC readings into a buffer, compute RMS
- * voltage over the same data set, and convert to approximate dB SPL.
+ * The ADCBuf driver captures the output continuously by uDMA into two
+ * buffers at the CC3220's fixed rate. As each buffer completes, the
+ * callback only hands it to the mic task (MIC_process), which has
+ * until the DMA comes back round to it, 10 ms later, to add its sum
+ * and sum of squares to the current window; at the end of a window
+ * the totals are handed over whole, so the DC offset and RMS still
+ * come from the same data set, and MIC_readDB converts the latest
+ * window to approximate dB SPL without touching the ADC.
+ *
+ * Each buffer also goes through an A-weighting filter. Every 100 ms
+ * block of its output gives a short A-weighted level, and these build
+ * up the statistics for the current sampling interval: total energy
+ * for LAeq, the loudest and quietest block, and a histogram of block
+ * levels for LA10/LA90. MIC_readLevels hands the interval over and
+ * starts the next, so no audio is ever stored.
+ *
+ * With MIC_CAPTURE_PERIOD_MS set, MIC_capture() starts the ADC for
+ * one window at a time and the mic task stops it when the window is
+ * complete, so the MCU can reach LPDS in between. The filter restarts
+ * from rest each time, and the first 100 ms only let it settle.
+ *
+ * The M4 has no FPU, so all of this is integer: the per-buffer sums
+ * use the DSP extension's dual 16-bit MAC where the compiler offers
+ * it, the filter is fixed point, and dB come from a log2 table, in
+ * hundredths of a dB.
  */
 
-#define ADC_VREF        1.4f        /* CC3220 ADC reference voltage */
-#define ADC_MAX         4095.0f     /* 12-bit ADC */
-#define MIC_SAMPLES     256         /* Samples per measurement window */
-#define MIC_REF_VRMS    0.00631f    /* Reference voltage for 0 dB (calibrate) */
-#define MIC_GAIN_DB     20.0f       /* Op-amp gain offset on breakout board */
+#define MIC_SAMPLE_HZ   62500       /* Per channel, fixed by the CC32xx ADC */
+#define MIC_BUF_SAMPLES 625         /* 10 ms per DMA buffer */
+#define MIC_WINDOW_BUFS 100         /* Buffers per measurement window (1 s) */
+#define MIC_CODE_MID    2048        /* Samples are centred on this before
+                                     * squaring, so a buffer's sum of
+                                     * squares fits in 32 bits */
+/* dB SPL = 20*log10(RMS in ADC codes) + MIC_OFFSET_CDB / 100, where
+ * the offset is 20*log10(1.4 V / 4095 / 6.31 mV) for the ADC reference
+ * and full scale and the 0 dB reference voltage (calibrate), plus
+ * 20 dB of op-amp gain on the breakout board. */
+#define MIC_OFFSET_CDB  (-532)
+#define MIC_MIN_RMS_CDB (-1068)     /* Below 0.1 mV (0.2925 codes) reads 0 */
+
+#define MIC_BLOCK_BUFS  10          /* Buffers per short A-weighted level (100 ms) */
+#define MIC_A_IN_SHIFT  12          /* Filter input scale; full scale peaks near 2^27 */
+#define MIC_A_SQ_SHIFT  10          /* Output shift before squaring, so an hour
+                                     * at full scale fits the 64-bit energy */
+/* A-weighted levels: MIC_OFFSET_CDB less the filter's 15.19 dB gain at
+ * 1 kHz and the 12 dB net scaling of the two shifts */
+#define MIC_A_OFFSET_CDB (-3256)
+#define MIC_HIST_BINS   256         /* Block levels, 0.5 dB bins from 0 dB */
+#define MIC_HIST_CDB    50
+#define MIC_SETTLE_BUFS 10          /* Discarded after each start (100 ms) */
+
+#if MIC_CAPTURE_PERIOD_MS > 0 && MIC_CAPTURE_PERIOD_MS < 2000
+#error "MIC_CAPTURE_PERIOD_MS must leave room for a 1.1 s capture"
+#endif
+#if POWER_LPDS && MIC_CAPTURE_PERIOD_MS == 0
+#error "Continuous mic capture (MIC_CAPTURE_PERIOD_MS 0) never lets the MCU into LPDS; set POWER_LPDS 0"
+#endif
+
+/* A-weighting (IEC 61672) at 62.5 kHz: the analogue poles at 20.6 Hz
+ * (x2), 107.7 Hz, 737.9 Hz and 12.2 kHz (x2) through the bilinear
+ * transform. Two high-pass sections have numerator 1 - 2z^-1 + z^-2
+ * and the low-pass section 1 + 2z^-1 + z^-2, so only the feedback
+ * taps multiply; they are -a1, -a2 in Q30. Matches the analogue curve
+ * within 0.05 dB up to 4 kHz, -0.3 dB at 8 kHz, -0.7 dB at 10 kHz. */
+static const int32_t a_weight[3][2] = {
+    { 2143041159, -1069303930 },
+    { 2059126098,  -986210958 },
+    {  515321825,   -61829710 },
+};
+static const int32_t a_weight_b1[3] = { -2, -2, 2 };
+
+/* log2(1 + i/64) in Q15, for i = 0..64 */
+static const uint16_t log2_table[65] = {
+        0,   733,  1455,  2166,  2866,  3556,  4236,  4907,
+     5568,  6220,  6863,  7498,  8124,  8742,  9352,  9954,
+    10549, 11136, 11716, 12289, 12855, 13415, 13968, 14514,
+    15055, 15589, 16117, 16639, 17156, 17667, 18173, 18673,
+    19168, 19658, 20143, 20623, 21098, 21568, 22034, 22495,
+    22952, 23404, 23852, 24296, 24736, 25172, 25604, 26031,
+    26455, 26876, 27292, 27705, 28114, 28520, 28922, 29321,
+    29717, 30109, 30498, 30884, 31267, 31647, 32024, 32397,
+    32768,
+};
+
+typedef struct {
+    int32_t  sum;
+    uint64_t sum_sq;
+    uint32_t n;
+} MicWindow;
+
+typedef struct {
+    int32_t x1, x2, y1, y2;
+} Biquad;
+
+/* A-weighted statistics for one sampling interval */
+typedef struct {
+    uint64_t energy;                /* Sum of squared filter output */
+    uint32_t n;                     /* Samples in energy */
+    uint32_t blocks;
+    int32_t  max_cdb;
+    int32_t  min_cdb;
+    uint16_t hist[MIC_HIST_BINS];
+} MicPeriod;
+
+/* Word aligned so the DSP path can load two samples at a time */
+static uint16_t buf_a[MIC_BUF_SAMPLES] __attribute__((aligned(4)));
+static uint16_t buf_b[MIC_BUF_SAMPLES] __attribute__((aligned(4)));
+static ADCBuf_Handle adcbuf;
+static ADCBuf_Conversion conversion;
+static SemaphoreP_Handle ready;
+static uint16_t *volatile pending;  /* Filled, waiting for the mic task */
+static const uint16_t *volatile busy;   /* Being processed */
+#if MIC_CAPTURE_PERIOD_MS > 0
+static volatile bool capturing;
+static volatile uint16_t settle_bufs;
+#endif
+static int32_t work[MIC_BUF_SAMPLES];   /* Filter pipeline, mic task only */
+
+static MicWindow acc;               /* Being accumulated, mic task only */
+static uint16_t acc_bufs;
+static MicWindow done[2];           /* Completed; the mic task writes the */
+static volatile uint8_t latest;     /* one readers are not using */
+
+static Biquad a_state[3];
+static uint64_t blk_energy;         /* Current 100 ms block */
+static uint32_t blk_n;
+static uint16_t blk_bufs;
+static MicPeriod periods[2];        /* The mic task fills periods[period_cur] */
+static uint8_t period_cur;
+
+static MICStats_t stats;
+
+/* Sum and sum of squares of one buffer, centred on MIC_CODE_MID */
+static void sum_buffer(const uint16_t *samples, int32_t *sum_out,
+                       uint32_t *sum_sq_out)
+{
+    int32_t sum = 0;
+    uint32_t sum_sq = 0;
+    int i = 0;
+
+#if defined(__ARM_FEATURE_SIMD32)
+    /* Two samples per word: SSUB16 centres both halves, then one SMLAD
+     * adds x0 + x1 and another x0^2 + x1^2. The squares fit in 32 bits
+     * unsigned, so SMLAD's signed overflow (Q flag) is harmless. */
+    for (; i + 1 < MIC_BUF_SAMPLES; i += 2) {
+        uint32_t pair;
+        memcpy(&pair, &samples[i], sizeof(pair));
+        int16x2_t x = __ssub16(pair, MIC_CODE_MID * 0x00010001U);
+        sum = __smlad(x, 0x00010001, sum);
+        sum_sq = (uint32_t)__smlad(x, x, (int32_t)sum_sq);
+    }
+#endif
+    for (; i < MIC_BUF_SAMPLES; i++) {
+        int32_t x = (int32_t)samples[i] - MIC_CODE_MID;
+        sum += x;
+        sum_sq += (uint32_t)(x * x);
+    }
+
+    *sum_out = sum;
+    *sum_sq_out = sum_sq;
+}
+
+/* log2(x) in Q16, x > 0: the leading bit gives the integer part, the
+ * next 16 bits index and interpolate the table. */
+static int32_t log2_q16(uint64_t x)
+{
+    uint32_t hi = (uint32_t)(x >> 32);
+    int msb = hi ? 63 - __builtin_clz(hi) : 31 - __builtin_clz((uint32_t)x);
+    uint32_t frac = (uint32_t)((msb >= 16) ? (x >> (msb - 16)) : (x << (16 - msb)));
+    frac &= 0xFFFF;
+
+    uint32_t i = frac >> 10;
+    uint32_t r = frac & 0x3FF;
+    uint32_t l2 = log2_table[i] +
+                  (((uint32_t)(log2_table[i + 1] - log2_table[i]) * r) >> 10);
+    return (msb << 16) + (int32_t)(l2 << 1);
+}
+
+/* 10*log10(x) in hundredths of a dB, x > 0: log2 times 3.0103 dB per
+ * octave, as a Q32 multiplier */
+static int32_t db10_centi(uint64_t x)
+{
+    return (int32_t)(((int64_t)log2_q16(x) * 19728302 + (1LL << 31)) >> 32);
+}
+
+/* One biquad section over n samples in place, direct form I with a
+ * 64-bit accumulator. b1 is the middle numerator tap (+-2). */
+static void biquad(int32_t *x, int n, Biquad *s, const int32_t a[2],
+                   int32_t b1)
+{
+    int32_t x1 = s->x1, x2 = s->x2, y1 = s->y1, y2 = s->y2;
+    int32_t a1 = a[0], a2 = a[1];
+
+    for (int i = 0; i < n; i++) {
+        int32_t x0 = x[i];
+        int64_t mac = (int64_t)(x0 + b1 * x1 + x2) * (1 << 30) + (1 << 29);
+        mac += (int64_t)a1 * y1;
+        mac += (int64_t)a2 * y2;
+        int32_t y0 = (int32_t)(mac >> 30);
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        x[i] = y0;
+    }
+
+    s->x1 = x1;
+    s->x2 = x2;
+    s->y1 = y1;
+    s->y2 = y2;
+}
 
-void MIC_init(ADC_Handle adc)
+/* A-weight one buffer into the current block */
+static void weigh_buffer(const uint16_t *samples)
 {
-    (void)adc;
+    for (int i = 0; i < MIC_BUF_SAMPLES; i++) {
+        work[i] = ((int32_t)samples[i] - MIC_CODE_MID) * (1 << MIC_A_IN_SHIFT);
+    }
+    for (int k = 0; k < 3; k++) {
+        biquad(work, MIC_BUF_SAMPLES, &a_state[k], a_weight[k], a_weight_b1[k]);
+    }
+
+    uint64_t energy = 0;
+    for (int i = 0; i < MIC_BUF_SAMPLES; i++) {
+        int32_t y = work[i] >> MIC_A_SQ_SHIFT;
+        energy += (uint64_t)((int64_t)y * y);
+    }
+    blk_energy += energy;
+    blk_n += MIC_BUF_SAMPLES;
+}
+
+/* Close a 100 ms block into the current interval's statistics */
+static void end_block(void)
+{
+    int32_t cdb = 0;
+    if (blk_energy != 0) {
+        cdb = db10_centi(blk_energy) - db10_centi(blk_n) + MIC_A_OFFSET_CDB;
+        if (cdb < 0) cdb = 0;
+    }
+
+    uint32_t bin = (uint32_t)cdb / MIC_HIST_CDB;
+    if (bin >= MIC_HIST_BINS) bin = MIC_HIST_BINS - 1;
+
+    /* MIC_readLevels may swap intervals from a higher-priority task */
+    uintptr_t key = HwiP_disable();
+    MicPeriod *p = &periods[period_cur];
+    p->energy += blk_energy;
+    p->n += blk_n;
+    if (p->blocks == 0 || cdb > p->max_cdb) p->max_cdb = cdb;
+    if (p->blocks == 0 || cdb < p->min_cdb) p->min_cdb = cdb;
+    if (p->hist[bin] < UINT16_MAX) p->hist[bin]++;
+    p->blocks++;
+    HwiP_restore(key);
+
+    blk_energy = 0;
+    blk_n = 0;
+    blk_bufs = 0;
 }
 
-float MIC_readDB(ADC_Handle adc)
+/* Level exceeded by `percent` of an interval's blocks, to the nearest
+ * histogram bin centre, kept within the interval's min and max */
+static int32_t level_exceeded(const MicPeriod *p, uint32_t percent)
 {
-    /* Capture all samples into a single buffer so DC offset and RMS
-     * are computed over the exact same data set. */
-    uint16_t samples[MIC_SAMPLES];
-    float dc_offset = 0.0f;
+    uint32_t target = (p->blocks * percent + 99) / 100;
+    if (target == 0) target = 1;
 
-    for (int i = 0; i < MIC_SAMPLES; i++) {
-        samples[i] = 0;
-        if (ADC_convert(adc, &samples[i]) != ADC_STATUS_SUCCESS) {
-            samples[i] = 0;
+    uint32_t count = 0;
+    int32_t cdb = p->min_cdb;
+    for (int bin = MIC_HIST_BINS - 1; bin >= 0; bin--) {
+        count += p->hist[bin];
+        if (count >= target) {
+            cdb = bin * MIC_HIST_CDB + MIC_HIST_CDB / 2;
+            break;
         }
-        dc_offset += (samples[i] / ADC_MAX) * ADC_VREF;
     }
-    dc_offset /= MIC_SAMPLES;
+    if (cdb > p->max_cdb) cdb = p->max_cdb;
+    if (cdb < p->min_cdb) cdb = p->min_cdb;
+    return cdb;
+}
+
+/* Runs in interrupt context as each buffer fills; the other buffer is
+ * already being captured into. Only hands the buffer over: if the mic
+ * task has not taken the previous one, or is still on the buffer the
+ * DMA has just moved to, that one is lost or overwritten. */
+static void buffer_done(ADCBuf_Handle handle, ADCBuf_Conversion *conv,
+                        void *buffer, uint32_t channel, int_fast16_t status)
+{
+    (void)handle;
+    (void)conv;
+    (void)channel;
+    if (status != ADCBuf_STATUS_SUCCESS) {
+        stats.errors++;
+        return;
+    }
+#if MIC_CAPTURE_PERIOD_MS > 0
+    if (!capturing) return;         /* Completed after the window ended */
+#endif
+
+    const uint16_t *next = buffer == buf_a ? buf_b : buf_a;
+    if (pending != NULL || busy == next) stats.overruns++;
+    pending = buffer;
+    SemaphoreP_post(ready);
+}
 
-    /* Compute RMS of AC component over the same samples */
-    float sum_sq = 0.0f;
-    for (int i = 0; i < MIC_SAMPLES; i++) {
-        float v = (samples[i] / ADC_MAX) * ADC_VREF;
-        float ac = v - dc_offset;
-        sum_sq += ac * ac;
+/* One completed buffer, in the mic task */
+static void process_buffer(uint16_t *samples)
+{
+    ADCBuf_adjustRawValues(adcbuf, samples, MIC_BUF_SAMPLES, conversion.adcChannel);
+
+#if MIC_CAPTURE_PERIOD_MS > 0
+    if (settle_bufs > 0) {
+        if (settle_bufs == MIC_SETTLE_BUFS) memset(a_state, 0, sizeof(a_state));
+        settle_bufs--;
+        weigh_buffer(samples);
+        blk_energy = 0;
+        blk_n = 0;
+        return;
     }
+#endif
+
+    int32_t sum;
+    uint32_t sum_sq;
+    sum_buffer(samples, &sum, &sum_sq);
+    acc.sum += sum;
+    acc.sum_sq += sum_sq;
+    acc.n += MIC_BUF_SAMPLES;
+    stats.buffers++;
 
-    float vrms = sqrtf(sum_sq / MIC_SAMPLES);
+    weigh_buffer(samples);
+    if (++blk_bufs >= MIC_BLOCK_BUFS) end_block();
 
-    /* Convert to dB SPL (approximate) */
-    if (vrms < 0.0001f) return 0.0f;
-    float db = 20.0f * log10f(vrms / MIC_REF_VRMS) + MIC_GAIN_DB;
+    if (++acc_bufs >= MIC_WINDOW_BUFS) {
+        uint8_t next = latest ^ 1U;
+        done[next] = acc;
+        latest = next;
+        acc = (MicWindow){0};
+        acc_bufs = 0;
+        stats.windows++;
+#if MIC_CAPTURE_PERIOD_MS > 0
+        capturing = false;
+        ADCBuf_convertCancel(adcbuf);
+        Energy_set(ENERGY_MIC, ENERGY_SLEEP);
+#endif
+    }
+}
 
-    return (db < 0.0f) ? 0.0f : db;
+void MIC_process(void)
+{
+    SemaphoreP_pend(ready, SemaphoreP_WAIT_FOREVER);
+
+    uintptr_t key = HwiP_disable();
+    uint16_t *samples = pending;
+    pending = NULL;
+#if MIC_CAPTURE_PERIOD_MS > 0
+    if (!capturing) samples = NULL;     /* The window ended meanwhile */
+#endif
+    busy = samples;
+    HwiP_restore(key);
+
+    if (samples != NULL) process_buffer(samples);
+    busy = NULL;
+}
+
+bool MIC_init(uint_least8_t adcbuf_index)
+{
+    ADCBuf_Params params;
+    ADCBuf_Params_init(&params);
+    params.returnMode = ADCBuf_RETURN_MODE_CALLBACK;
+    params.recurrenceMode = ADCBuf_RECURRENCE_MODE_CONTINUOUS;
+    params.callbackFxn = buffer_done;
+    params.samplingFrequency = MIC_SAMPLE_HZ;
+
+    ready = SemaphoreP_createBinary(0);
+    if (ready == NULL) return false;
+    adcbuf = ADCBuf_open(adcbuf_index, &params);
+    if (adcbuf == NULL) return false;
+
+    conversion.adcChannel = Board_ADCBUF0_MIC;
+    conversion.sampleBuffer = buf_a;
+    conversion.sampleBufferTwo = buf_b;
+    conversion.samplesRequestedCount = MIC_BUF_SAMPLES;
+
+#if MIC_CAPTURE_PERIOD_MS > 0
+    return true;
+#else
+    Energy_set(ENERGY_MIC, ENERGY_AWAKE);
+    return ADCBuf_convert(adcbuf, &conversion, 1) == ADCBuf_STATUS_SUCCESS;
+#endif
+}
+
+void MIC_capture(void)
+{
+#if MIC_CAPTURE_PERIOD_MS > 0
+    if (adcbuf == NULL || capturing) return;
+
+    /* The mic task restarts the filter on the first settling buffer */
+    settle_bufs = MIC_SETTLE_BUFS;
+    capturing = true;
+    Energy_set(ENERGY_MIC, ENERGY_AWAKE);
+    if (ADCBuf_convert(adcbuf, &conversion, 1) != ADCBuf_STATUS_SUCCESS) {
+        capturing = false;
+        Energy_set(ENERGY_MIC, ENERGY_SLEEP);
+        stats.errors++;
+    }
+#endif
+}
+
+/* Hundredths to tenths of a dB, rounded; cdb >= 0 */
+static uint16_t to_ddb(int32_t cdb)
+{
+    return (uint16_t)((cdb + 5) / 10);
+}
+
+uint16_t MIC_readDB(void)
+{
+    const MicWindow *w = &done[latest];
+    if (w->n == 0) return 0;        /* First window not complete yet */
+
+    /* Variance of the AC component over the window, exact in integers:
+     * (n * sum_sq - sum^2) / n^2, in ADC codes squared */
+    uint64_t n = w->n;
+    int64_t sum = w->sum;
+    uint64_t var_n2 = n * w->sum_sq - (uint64_t)(sum * sum);
+    if (var_n2 == 0) return 0;
+
+    int32_t rms_cdb = db10_centi(var_n2) - 2 * db10_centi(n);
+    if (rms_cdb < MIC_MIN_RMS_CDB) return 0;
+    int32_t cdb = rms_cdb + MIC_OFFSET_CDB;
+
+    return (cdb < 0) ? 0 : to_ddb(cdb);
+}
+
+void MIC_readLevels(MICLevels_t *out)
+{
+    /* Swap intervals between the mic task's blocks */
+    uintptr_t key = HwiP_disable();
+    MicPeriod *p = &periods[period_cur];
+    period_cur ^= 1U;
+    HwiP_restore(key);
+
+    if (p->blocks == 0) {
+        *out = (MICLevels_t){0};
+        return;
+    }
+
+    int32_t leq = 0;
+    if (p->energy != 0) {
+        leq = db10_centi(p->energy) - db10_centi(p->n) + MIC_A_OFFSET_CDB;
+        if (leq < 0) leq = 0;
+    }
+    out->leq  = to_ddb(leq);
+    out->lmax = to_ddb(p->max_cdb);
+    out->lmin = to_ddb(p->min_cdb);
+    out->l10  = to_ddb(level_exceeded(p, 10));
+    out->l90  = to_ddb(level_exceeded(p, 90));
+
+    memset(p, 0, sizeof(*p));
+}
+
+void MIC_getStats(MICStats_t *out)
+{
+    *out = stats;
 }
@@ -1,14 +1,53 @@
 #ifndef SENSOR_MIC_H
 #define SENSOR_MIC_H
 
-#include <ti/drivers/ADC.h>
+#include <stdint.h>
+#include <stdbool.h>
 
-/* Initialize MEMS microphone ADC channel. */
-void MIC_init(ADC_Handle adc);
+/* Open ADCBuf instance adcbuf_index and start continuous capture of
+ * the MEMS mic; with MIC_CAPTURE_PERIOD_MS (config.h) capture waits
+ * for MIC_capture(). Returns false if the driver cannot be opened.
+ * Call from the mic task before MIC_process. */
+bool MIC_init(uint_least8_t adcbuf_index);
 
-/* Read ambient noise level in dB SPL.
- * Samples the MEMS mic output over a short window
- * and converts RMS voltage to decibels. */
-float MIC_readDB(ADC_Handle adc);
+/* Wait for the next captured 10 ms buffer and fold it into the current
+ * window and A-weighted interval. Call in a loop from the mic task
+ * (app_tasks.h); each call must finish within 10 ms. */
+void MIC_process(void);
+
+/* With MIC_CAPTURE_PERIOD_MS, capture one 1 s window (after 100 ms of
+ * filter settling); the ADC stops again once it is complete. Does
+ * nothing while a window is in progress, before MIC_init, or when
+ * capture is continuous. */
+void MIC_capture(void);
+
+/* Ambient noise level in 0.1 dB SPL over the latest 1 s window, from
+ * the RMS of the mic's AC component. Constant time: capture and
+ * accumulation run in the background. 0 until the first window. */
+uint16_t MIC_readDB(void);
+
+/* A-weighted levels in 0.1 dB(A) over one sampling interval, from
+ * 100 ms blocks of the filtered mic signal */
+typedef struct {
+    uint16_t leq;           /* Equivalent continuous level (LAeq) */
+    uint16_t lmax;          /* Loudest block */
+    uint16_t lmin;          /* Quietest block */
+    uint16_t l10;           /* Exceeded 10% of the time (0.5 dB steps) */
+    uint16_t l90;           /* Exceeded 90% of the time: background */
+} MICLevels_t;
+
+/* Levels since the previous call (or MIC_init), then start a new
+ * interval. All zero if no block has completed. */
+void MIC_readLevels(MICLevels_t *levels);
+
+typedef struct {
+    uint32_t buffers;       /* DMA buffers accumulated */
+    uint32_t windows;       /* Measurement windows completed */
+    uint32_t errors;        /* Buffers the driver reported as failed,
+                             * and captures it would not start */
+    uint32_t overruns;      /* Buffers the mic task was too late for */
+} MICStats_t;
+
+void MIC_getStats(MICStats_t *stats);
 
 #endif
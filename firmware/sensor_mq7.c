@@ -13,6 +13,11 @@
  *
  * Rs/R0 ratio is converted to ppm using the power curve from
  * the MQ-7 datasheet. R0 must be calibrated in clean air.
+ *
+ * The curve depends only on the 12-bit ADC code once R0 is fixed, so
+ * MQ7_init evaluates it once per code into a table (in 0.1 ppm, the
+ * binary payload's resolution) and each reading is a lookup instead
+ * of soft-float divisions and a powf. MQ7_setR0 rebuilds the table.
  */
 
 #define MQ7_R0          10000.0f    /* Sensor resistance in clean air (calibrate!) */
@@ -21,19 +26,16 @@
 #define DIVIDER_RATIO   (10.0f / 36.0f)  /* 10k / (10k + 26k) voltage divider */
 #define MQ7_VCC         5.0f        /* MQ-7 supply voltage */
 
-void MQ7_init(ADC_Handle adc)
-{
-    /* No special initialization needed for the ADC channel.
-     * The MQ-7 heater needs ~60s warmup after power-on. */
-    (void)adc;
-}
+#define MQ7_CODES       4096        /* 12-bit ADC */
+#define MQ7_TABLE_SCALE 10.0f       /* Table entries are 0.1 ppm */
+#define MQ7_TABLE_MAX   0xFFFF      /* Saturates at 6553.5 ppm, far past the
+                                     * sensor's 2000 ppm range */
 
-float MQ7_readPPM(ADC_Handle adc)
-{
-    uint16_t adcRaw = 0;
-    int_fast16_t status = ADC_convert(adc, &adcRaw);
-    if (status != ADC_STATUS_SUCCESS) return -1.0f;
+static uint16_t ppm_table[MQ7_CODES];
 
+/* The datasheet curve for one ADC code */
+static float code_to_ppm(uint16_t adcRaw, float r0)
+{
     /* Convert ADC to actual sensor voltage (pre-divider) */
     float vAdc = (adcRaw / 4095.0f) * ADC_VREF;
     float vSensor = vAdc / DIVIDER_RATIO;
@@ -48,8 +50,32 @@ float MQ7_readPPM(ADC_Handle adc)
     if (rs < 0.0f) return 0.0f;
 
     /* Rs/R0 ratio to ppm (power curve from datasheet) */
-    float ratio = rs / MQ7_R0;
-    float ppm = 98.322f * powf(ratio, -1.458f);
+    float ratio = rs / r0;
+    return 98.322f * powf(ratio, -1.458f);
+}
+
+void MQ7_setR0(float r0_ohms)
+{
+    for (uint32_t code = 0; code < MQ7_CODES; code++) {
+        float t = code_to_ppm((uint16_t)code, r0_ohms) * MQ7_TABLE_SCALE + 0.5f;
+        /* Written as !(t < max) so the infinity at rs == 0 saturates too */
+        ppm_table[code] = !(t < (float)MQ7_TABLE_MAX) ? MQ7_TABLE_MAX : (uint16_t)t;
+    }
+}
+
+void MQ7_init(ADC_Handle adc)
+{
+    /* No special initialization needed for the ADC channel.
+     * The heater runs from power-on; see MQ7_WARMUP_MS. */
+    (void)adc;
+    MQ7_setR0(MQ7_R0);
+}
+
+int32_t MQ7_readCO(ADC_Handle adc)
+{
+    uint16_t adcRaw = 0;
+    int_fast16_t status = ADC_convert(adc, &adcRaw);
+    if (status != ADC_STATUS_SUCCESS) return -1;
 
-    return ppm;
+    return (int32_t)ppm_table[adcRaw & (MQ7_CODES - 1)] * 100;
 }
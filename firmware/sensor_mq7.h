@@ -2,12 +2,23 @@
 #define SENSOR_MQ7_H
 
 #include <ti/drivers/ADC.h>
+#include <stdint.h>
 
-/* Initialize MQ-7 CO sensor ADC channel. */
+/* Heater warm-up after power-on; earlier readings are unreliable */
+#define MQ7_WARMUP_MS       60000
+
+/* Initialize MQ-7 CO sensor ADC channel and build the ppm table for
+ * the default R0. */
 void MQ7_init(ADC_Handle adc);
 
-/* Read CO concentration in ppm from ADC via voltage divider.
- * Uses the MQ-7 sensitivity curve for Rs/R0 -> ppm conversion. */
-float MQ7_readPPM(ADC_Handle adc);
+/* Read CO concentration in 0.001 ppm from ADC via voltage divider,
+ * or -1 if the conversion fails. Uses the MQ-7 sensitivity curve for
+ * Rs/R0 -> ppm conversion, tabulated per ADC code to 0.1 ppm. */
+int32_t MQ7_readCO(ADC_Handle adc);
+
+/* Rebuild the table for a recalibrated clean-air resistance R0 (ohms).
+ * Evaluates the curve for all 4096 codes, so call it from the task
+ * that reads the sensor, not per sample. */
+void MQ7_setR0(float r0_ohms);
 
 #endif
@@ -0,0 +1,156 @@
+#include "sensor_sched.h"
+#include <time.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*
+ * Earliest-deadline-first release of sensor readings
+ *
+ * Each entry has an absolute release time in RTOS ticks. Its next
+ * release is the previous one plus the period, not the time it
+ * actually ran, so lateness never accumulates. If an entry falls a
+ * whole period behind (a long stall elsewhere), the missed releases
+ * are dropped rather than run back to back.
+ *
+ * The task sleeps with vTaskDelayUntil() from the release it last
+ * woke for, so a preemption between reading the clock and blocking
+ * cannot push the wake-up back. The start of every run is timed on
+ * CLOCK_MONOTONIC for the period statistics.
+ */
+
+typedef struct {
+    TickType_t release;
+    TickType_t last;            /* Release it last ran for */
+    TickType_t period;
+    bool       done;            /* One-shot entry has run */
+    uint64_t   last_start_us;
+    SensorSchedStats_t stats;
+} SensorSlot;
+
+static const SensorDesc_t *sensors;
+static SensorSlot slots[SENSOR_SCHED_MAX];
+static uint8_t sensor_count;
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000U + (uint64_t)(ts.tv_nsec / 1000);
+}
+
+static void record_start(SensorSlot *s)
+{
+    uint64_t start = now_us();
+    if (s->stats.runs > 0) {
+        uint32_t period = (uint32_t)(start - s->last_start_us);
+        SensorSchedPeriod_t *p = &s->stats.period;
+        if (p->count == 0 || period < p->min_us) p->min_us = period;
+        if (period > p->max_us) p->max_us = period;
+        p->sum_us += period;
+        p->count++;
+    }
+    s->last_start_us = start;
+}
+
+/* Released entry with the earliest deadline, or -1 with *wait set to
+ * the time until the next release */
+static int pick(TickType_t now, TickType_t *wait)
+{
+    int best = -1;
+    int32_t best_deadline = 0;
+    int32_t soonest = INT32_MAX;
+
+    for (uint8_t i = 0; i < sensor_count; i++) {
+        if (slots[i].done) continue;
+        int32_t until = (int32_t)(slots[i].release - now);
+        if (until > 0) {
+            if (until < soonest) soonest = until;
+            continue;
+        }
+        /* Relative to now, so the comparison survives wrap-around */
+        int32_t deadline = until + (int32_t)slots[i].period;
+        if (best < 0 || deadline < best_deadline) {
+            best = i;
+            best_deadline = deadline;
+        }
+    }
+    *wait = (TickType_t)soonest;
+    return best;
+}
+
+void SensorSched_run(const SensorDesc_t *table, uint8_t count)
+{
+    if (count > SENSOR_SCHED_MAX) count = SENSOR_SCHED_MAX;
+
+    /* Reference for vTaskDelayUntil(): always a tick already passed */
+    TickType_t woke = xTaskGetTickCount();
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (table[i].init != NULL) table[i].init();
+        slots[i].release = xTaskGetTickCount() + pdMS_TO_TICKS(table[i].conversion_ms);
+        slots[i].last = slots[i].release;
+        slots[i].period = pdMS_TO_TICKS(table[i].period_ms);
+        slots[i].stats.name = table[i].name;
+    }
+    sensors = table;
+    sensor_count = count;
+
+    while (1) {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait;
+        int i = pick(now, &wait);
+        if (i < 0) {
+            /* Sleep to the next release, measured from the last one */
+            TickType_t next = now + wait;
+            vTaskDelayUntil(&woke, next - woke);
+            continue;
+        }
+
+        SensorSlot *s = &slots[i];
+        uint32_t late = (uint32_t)(now - s->release) * portTICK_PERIOD_MS;
+        if (late > s->stats.late_max_ms) s->stats.late_max_ms = late;
+
+        record_start(s);
+        s->last = s->release;
+        sensors[i].sample();
+        s->stats.runs++;
+
+        /* The period may have changed during the run */
+        TickType_t period = s->period;
+        if (period == 0) {
+            s->done = true;
+            continue;
+        }
+        s->release = s->last + period;
+        while ((int32_t)(xTaskGetTickCount() - s->release) >= (int32_t)period) {
+            s->release += period;
+            s->stats.skipped++;
+        }
+    }
+}
+
+void SensorSched_setPeriod(uint8_t index, uint32_t period_ms)
+{
+    if (index >= sensor_count || slots[index].done || period_ms == 0) return;
+    SensorSlot *s = &slots[index];
+    s->period = pdMS_TO_TICKS(period_ms);
+    if (s->stats.runs == 0) return;     /* First release unchanged */
+    s->release = s->last + s->period;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(s->release - now) < 0) s->release = now;
+}
+
+void SensorSched_release(uint8_t index)
+{
+    if (index >= sensor_count || slots[index].done) return;
+    if (slots[index].stats.runs == 0) return;   /* First release unchanged */
+    slots[index].release = xTaskGetTickCount();
+}
+
+bool SensorSched_getStats(uint8_t index, SensorSchedStats_t *stats)
+{
+    if (index >= sensor_count) return false;
+    *stats = slots[index].stats;
+    return true;
+}
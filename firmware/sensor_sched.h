@@ -0,0 +1,65 @@
+#ifndef SENSOR_SCHED_H
+#define SENSOR_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Sensor scheduler for the sensing task
+ *
+ * Each sensor is a descriptor: how to start it, how to take a reading,
+ * how often, and how long after start its first reading is valid. The
+ * scheduler releases every entry at fixed multiples of its period and
+ * runs released entries earliest deadline first (deadline = release +
+ * period), so a sensor with a short period is never held behind one
+ * with a long period. Releases are absolute RTOS tick times, so the
+ * period does not drift with the work done in each run. Adding a
+ * sensor means adding a table entry.
+ */
+
+typedef struct {
+    const char *name;
+    void      (*init)(void);        /* May be NULL */
+    void      (*sample)(void);      /* Take (or start) one reading */
+    uint32_t    period_ms;          /* 0: run once */
+    uint32_t    conversion_ms;      /* From init to the first valid reading */
+} SensorDesc_t;
+
+#define SENSOR_SCHED_MAX    10
+
+/* Start-to-start intervals between runs of one entry */
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;        /* Mean = sum_us / count */
+} SensorSchedPeriod_t;
+
+typedef struct {
+    const char *name;
+    uint32_t    runs;
+    uint32_t    skipped;        /* Releases missed after an overrun */
+    uint32_t    late_max_ms;    /* Longest start after release */
+    SensorSchedPeriod_t period;
+} SensorSchedStats_t;
+
+/* Initialise the `count` sensors in table order, then run them. The
+ * table must outlive the call. Does not return. */
+void SensorSched_run(const SensorDesc_t *table, uint8_t count);
+
+/* Change the period (> 0) of periodic table entry `index` from the
+ * sensing task, e.g. from another entry's sample(). Once the entry
+ * has run, its next release becomes its last one plus period_ms, or
+ * now if that has passed. */
+void SensorSched_setPeriod(uint8_t index, uint32_t period_ms);
+
+/* Release periodic table entry `index` now, from the sensing task;
+ * later releases follow from this one. No effect before its first
+ * release. */
+void SensorSched_release(uint8_t index);
+
+/* Copy the statistics of table entry `index`. Returns false past the
+ * end of the table or before SensorSched_run(). */
+bool SensorSched_getStats(uint8_t index, SensorSchedStats_t *stats);
+
+#endif
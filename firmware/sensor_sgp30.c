@@ -1,6 +1,10 @@
 #include "sensor_sgp30.h"
 #include "Board.h"
-#include <unistd.h>
+#include "energy.h"
+#include "env_data.h"
+#include "i2c_bus.h"
+#include <ti/drivers/dpl/ClockP.h>
+#include <ti/drivers/dpl/HwiP.h>
 
 /* SGP30 I2C Commands (2-byte command words) */
 #define SGP30_CMD_IAQ_INIT_H    0x20
@@ -8,32 +12,42 @@
 #define SGP30_CMD_MEASURE_H     0x20
 #define SGP30_CMD_MEASURE_L     0x08
 
-/* Cached values from the most recent tick */
+/* Cached values from the most recent measurement */
 static uint16_t cached_eco2 = 400;  /* SGP30 default */
 static uint16_t cached_tvoc = 0;
 
-static bool sgp30_send_cmd(I2C_Handle i2c, uint8_t cmd_h, uint8_t cmd_l)
-{
-    uint8_t txBuf[2] = {cmd_h, cmd_l};
-    I2C_Transaction txn = {0};
-    txn.targetAddress = SGP30_I2C_ADDR;
-    txn.writeBuf = txBuf;
-    txn.writeCount = 2;
-    txn.readBuf = NULL;
-    txn.readCount = 0;
-    return I2C_transfer(i2c, &txn);
-}
+/* For SGP30_WARMUP_MS after iaq_init the sensor returns fixed
+ * 400 ppm / 0 ppb; results measured before then are not cached */
+static uint32_t init_tick;
+static volatile bool warmed_up;
 
-static bool sgp30_read_data(I2C_Handle i2c, uint8_t *buf, uint8_t len)
-{
-    I2C_Transaction txn = {0};
-    txn.targetAddress = SGP30_I2C_ADDR;
-    txn.writeBuf = NULL;
-    txn.writeCount = 0;
-    txn.readBuf = buf;
-    txn.readCount = len;
-    return I2C_transfer(i2c, &txn);
-}
+static I2CBusDevice sgp30 = I2CBUS_DEVICE("SGP30", SGP30_I2C_ADDR);
+
+static const uint8_t iaq_init_cmd[2] = {SGP30_CMD_IAQ_INIT_H, SGP30_CMD_IAQ_INIT_L};
+static const uint8_t measure_cmd[2] = {SGP30_CMD_MEASURE_H, SGP30_CMD_MEASURE_L};
+
+/* [CO2_H, CO2_L, CRC, TVOC_H, TVOC_L, CRC] */
+static uint8_t result[6];
+
+static void measure_done(I2CBusJob *job, bool ok);
+static void read_done(I2CBusJob *job, bool ok);
+
+/* iaq_init takes 10 ms; the engine holds the first measure_iaq back */
+static I2CBusJob init_job = {
+    .dev = &sgp30, .writeBuf = iaq_init_cmd, .writeCount = 2,
+    .settle_ms = 10,
+};
+
+/* measure_iaq, then the read once the 12 ms conversion is done (13 ms
+ * with a tick of margin). Other devices use the bus in between. */
+static I2CBusJob measure_job = {
+    .dev = &sgp30, .writeBuf = measure_cmd, .writeCount = 2,
+    .settle_ms = 13, .done = measure_done,
+};
+
+static I2CBusJob read_job = {
+    .dev = &sgp30, .readBuf = result, .readCount = 6, .done = read_done,
+};
 
 /* CRC-8 per SGP30 datasheet: polynomial 0x31, init 0xFF */
 static uint8_t sgp30_crc(const uint8_t *data, uint8_t len)
@@ -49,41 +63,68 @@ static uint8_t sgp30_crc(const uint8_t *data, uint8_t len)
     return crc;
 }
 
-void SGP30_init(I2C_Handle i2c)
+/* The sensor draws its measuring current from the command until the
+ * result is read */
+static void measure_done(I2CBusJob *job, bool ok)
 {
-    /* Send iaq_init to start continuous measurement mode.
-     * The sensor needs ~15s to produce first valid readings. */
-    sgp30_send_cmd(i2c, SGP30_CMD_IAQ_INIT_H, SGP30_CMD_IAQ_INIT_L);
-    usleep(10000);  /* 10ms for iaq_init to complete */
+    (void)job;
+    if (!ok) return;
+    Energy_set(ENERGY_SGP30, ENERGY_AWAKE);
+    I2CBus_submit(&read_job);
 }
 
-bool SGP30_tick(I2C_Handle i2c)
+static void read_done(I2CBusJob *job, bool ok)
 {
-    /* Send measure_iaq command */
-    if (!sgp30_send_cmd(i2c, SGP30_CMD_MEASURE_H, SGP30_CMD_MEASURE_L)) {
-        return false;
-    }
+    (void)job;
+    Energy_set(ENERGY_SGP30, ENERGY_SLEEP);
+    if (!ok) return;
 
-    /* Wait 13ms: 12ms max conversion + 1ms margin for RTOS tick */
-    usleep(13000);
+    /* Validate CRC for each 2-byte word */
+    if (sgp30_crc(&result[0], 2) != result[2]) return;
+    if (sgp30_crc(&result[3], 2) != result[5]) return;
 
-    /* Read 6 bytes: [CO2_H, CO2_L, CRC, TVOC_H, TVOC_L, CRC] */
-    uint8_t buf[6];
-    if (!sgp30_read_data(i2c, buf, 6)) {
-        return false;
+    if (!warmed_up) {
+        uint32_t age = (ClockP_getSystemTicks() - init_tick) *
+                       (ClockP_getSystemTickPeriod() / 1000);
+        if (age < SGP30_WARMUP_MS) return;
+        warmed_up = true;
     }
+    cached_eco2 = (uint16_t)((uint16_t)result[0] << 8 | result[1]);
+    cached_tvoc = (uint16_t)((uint16_t)result[3] << 8 | result[4]);
+}
 
-    /* Validate CRC for each 2-byte word */
-    if (sgp30_crc(&buf[0], 2) != buf[2]) return false;
-    if (sgp30_crc(&buf[3], 2) != buf[5]) return false;
+void SGP30_init(void)
+{
+    /* Send iaq_init to start continuous measurement mode.
+     * The sensor needs ~15s to produce first valid readings. */
+    I2CBus_attach(&sgp30);
+    init_tick = ClockP_getSystemTicks();
+    I2CBus_submit(&init_job);
+}
 
-    cached_eco2 = (uint16_t)((uint16_t)buf[0] << 8 | buf[1]);
-    cached_tvoc = (uint16_t)((uint16_t)buf[3] << 8 | buf[4]);
-    return true;
+bool SGP30_tick(void)
+{
+    /* Still converting or reading from the previous tick */
+    if (measure_job.pending || read_job.pending) return false;
+    return I2CBus_submit(&measure_job);
+}
+
+bool SGP30_ready(void)
+{
+    return warmed_up;
 }
 
 void SGP30_read(uint16_t *eco2, uint16_t *tvoc)
 {
+    if (!warmed_up) {
+        *eco2 = ENV_NO_READING;
+        *tvoc = ENV_NO_READING;
+        return;
+    }
+
+    /* The pair is updated from the bus interrupt */
+    uintptr_t key = HwiP_disable();
     *eco2 = cached_eco2;
     *tvoc = cached_tvoc;
+    HwiP_restore(key);
 }
@@ -1,21 +1,29 @@
 #ifndef SENSOR_SGP30_H
 #define SENSOR_SGP30_H
 
-#include <ti/drivers/I2C.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+/* iaq_init to the first real measurement (datasheet: 15 s) */
+#define SGP30_WARMUP_MS     15000
+
 /* Initialize SGP30 air quality sensor.
- * Sends iaq_init command to start measurement mode. */
-void SGP30_init(I2C_Handle i2c);
+ * Queues the iaq_init command to start measurement mode. */
+void SGP30_init(void);
 
 /* Must be called every 1 second to maintain the SGP30's on-chip
- * baseline compensation algorithm. Sends measure_iaq and caches
- * the latest eCO2/TVOC values internally. */
-bool SGP30_tick(I2C_Handle i2c);
+ * baseline compensation algorithm. Queues measure_iaq and returns
+ * at once; the result is read 13 ms later in the background and
+ * cached. Returns false if the previous measurement is unfinished
+ * or the command cannot be queued. */
+bool SGP30_tick(void);
+
+/* True once a measurement has completed after the warm-up. */
+bool SGP30_ready(void);
 
 /* Return the most recently cached eCO2 (ppm) and TVOC (ppb) values
- * from the last SGP30_tick() call. */
+ * from the last completed measurement, or ENV_NO_READING (env_data.h)
+ * for both until SGP30_ready(). */
 void SGP30_read(uint16_t *eco2, uint16_t *tvoc);
 
 #endif
@@ -1,21 +1,49 @@
 /*
- * sl_event_handlers.c - SimpleLink Wi-Fi event handler stubs
+ * sl_event_handlers.c - SimpleLink Wi-Fi event handlers
  *
  * The SimpleLink host driver requires the application to define these
- * callbacks. For this project, we use minimal stubs — expand as needed
- * for production error handling.
+ * callbacks. Link and NWP events are passed to the connection manager
+ * (wifi_mqtt.h), which acts on them from the network task; the rest
+ * are minimal stubs.
  */
 
 #include <ti/drivers/net/wifi/simplelink.h>
 
+#include "wifi_mqtt.h"
+
 void SimpleLinkWlanEventHandler(SlWlanEvent_t *pWlanEvent)
 {
-    (void)pWlanEvent;
+    if (pWlanEvent == NULL) return;
+
+    switch (pWlanEvent->Id) {
+    case SL_WLAN_EVENT_CONNECT:
+        Conn_event(CONN_EV_WLAN_UP);
+        break;
+    case SL_WLAN_EVENT_DISCONNECT:
+        /* Also reported for a failed join */
+        Conn_event(CONN_EV_WLAN_DOWN);
+        break;
+    default:
+        break;
+    }
 }
 
 void SimpleLinkNetAppEventHandler(SlNetAppEvent_t *pNetAppEvent)
 {
-    (void)pNetAppEvent;
+    if (pNetAppEvent == NULL) return;
+
+    switch (pNetAppEvent->Id) {
+    case SL_NETAPP_EVENT_IPV4_ACQUIRED:
+        Conn_event(CONN_EV_IP_ACQUIRED);
+        break;
+    case SL_NETAPP_EVENT_IP_COLLISION:
+    case SL_NETAPP_EVENT_DHCP_IPV4_ACQUIRE_TIMEOUT:
+        /* No usable address: rejoin */
+        Conn_event(CONN_EV_WLAN_DOWN);
+        break;
+    default:
+        break;
+    }
 }
 
 void SimpleLinkGeneralEventHandler(SlDeviceEvent_t *pDevEvent)
@@ -26,8 +54,8 @@ void SimpleLinkGeneralEventHandler(SlDeviceEvent_t *pDevEvent)
 void SimpleLinkFatalErrorEventHandler(SlDeviceFatal_t *slFatalErrorEvent)
 {
     (void)slFatalErrorEvent;
-    /* In production, log error and reset device */
-    while (1) {}
+    /* The NWP must be restarted; the driver cannot be called from here */
+    Conn_event(CONN_EV_NWP_FATAL);
 }
 
 void SimpleLinkSockEventHandler(SlSockEvent_t *pSock)
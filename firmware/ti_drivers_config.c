@@ -2,7 +2,7 @@
  * ti_drivers_config.c - Manual driver configuration for CC3220SF
  *
  * This file replaces the SysConfig-generated configuration.
- * It defines the hardware config tables for I2C, ADC, and GPIO
+ * It defines the hardware config tables for I2C, ADC, ADCBuf and GPIO
  * used by the TI SimpleLink SDK drivers.
  */
 
@@ -15,6 +15,8 @@
 #include <ti/drivers/i2c/I2CCC32XX.h>
 #include <ti/drivers/ADC.h>
 #include <ti/drivers/adc/ADCCC32XX.h>
+#include <ti/drivers/ADCBuf.h>
+#include <ti/drivers/adcbuf/ADCBufCC32XX.h>
 #include <ti/drivers/SPI.h>
 #include <ti/drivers/spi/SPICC32XXDMA.h>
 #include <ti/drivers/power/PowerCC32XX.h>
@@ -30,6 +32,7 @@
 #include <queue.h>
 
 #include "ti_drivers_config.h"
+#include "config.h"
 
 /*
  * ======== GPIO ========
@@ -86,29 +89,52 @@ const uint_least8_t I2C_count = 1;
  * ======== ADC ========
  *
  * Channel 0: P59 / ADC CH2 - MQ-7 CO sensor
- * Channel 1: P60 / ADC CH3 - MEMS microphone
  */
-const ADCCC32XX_HWAttrsV1 adcCC32XXHWAttrs[2] = {
+const ADCCC32XX_HWAttrsV1 adcCC32XXHWAttrs[1] = {
     { .adcPin = ADCCC32XX_PIN_59_CH_2 },
-    { .adcPin = ADCCC32XX_PIN_60_CH_3 },
 };
 
-ADCCC32XX_Object adcCC32XXObjects[2];
+ADCCC32XX_Object adcCC32XXObjects[1];
 
-const ADC_Config ADC_config[2] = {
+const ADC_Config ADC_config[1] = {
     {
         .fxnTablePtr = &ADCCC32XX_fxnTable,
         .object  = &adcCC32XXObjects[0],
         .hwAttrs = &adcCC32XXHWAttrs[0],
     },
+};
+
+const uint_least8_t ADC_count = 1;
+
+/*
+ * ======== ADCBuf ========
+ *
+ * Channel 0: P60 / ADC CH3 - MEMS microphone, captured continuously
+ * by uDMA at the fixed 62.5 ksps per channel. CH2 stays on the ADC
+ * driver; both drivers share the one ADC module, which neither closes.
+ */
+ADCBufCC32XX_Object adcbufCC32XXObjects[1];
+
+static ADCBufCC32XX_Channels adcBuf0CC32XXChannelLookup[1] = {
+    { .adcPin = ADCBufCC32XX_PIN_60_CH_3 },
+};
+
+const ADCBufCC32XX_HWAttrsV1 adcbufCC32XXHWAttrs[1] = {
     {
-        .fxnTablePtr = &ADCCC32XX_fxnTable,
-        .object  = &adcCC32XXObjects[1],
-        .hwAttrs = &adcCC32XXHWAttrs[1],
+        .intPriority    = (~0),
+        .channelSetting = adcBuf0CC32XXChannelLookup,
     },
 };
 
-const uint_least8_t ADC_count = 2;
+const ADCBuf_Config ADCBuf_config[1] = {
+    {
+        .fxnTablePtr = &ADCBufCC32XX_fxnTable,
+        .object  = &adcbufCC32XXObjects[0],
+        .hwAttrs = &adcbufCC32XXHWAttrs[0],
+    },
+};
+
+const uint_least8_t ADCBuf_count = 1;
 
 /*
  * ======== GPIO upper bound (used by GPIOCC32XX driver) ========
@@ -116,7 +142,7 @@ const uint_least8_t ADC_count = 2;
 const uint_least8_t GPIO_pinUpperBound = CONFIG_GPIO_COUNT - 1;
 
 /*
- * ======== UDMA (required by SPI DMA driver) ========
+ * ======== UDMA (required by the SPI DMA and ADCBuf drivers) ========
  */
 static tDMAControlTable dmaControlTable[64] __attribute__((aligned(1024)));
 
@@ -177,28 +203,34 @@ const uint_least8_t SPI_count = 1;
 
 /*
  * ======== Power ========
+ *
+ * The sleep policy runs from the idle task: LPDS when the next wake-up
+ * is further off than latencyForLPDS and no driver holds the
+ * DISALLOW_LPDS constraint, else WFI (POWER_LPDS in config.h). All of
+ * SRAM is retained, and the NWP's host interrupt wakes the MCU.
  */
 const PowerCC32XX_ConfigV1 PowerCC32XX_config = {
-    .policyInitFxn             = NULL,
-    .policyFxn                 = NULL,
+    .policyInitFxn             = PowerCC32XX_initPolicy,
+    .policyFxn                 = PowerCC32XX_sleepPolicy,
     .enterLPDSHookFxn          = NULL,
     .resumeLPDSHookFxn         = NULL,
-    .enablePolicy              = false,
+    .enablePolicy              = POWER_LPDS,
     .enableGPIOWakeupLPDS      = false,
     .enableGPIOWakeupShutdown  = false,
-    .enableNetworkWakeupLPDS   = false,
+    .enableNetworkWakeupLPDS   = true,
     .wakeupGPIOSourceLPDS      = 0,
     .wakeupGPIOTypeLPDS        = 0,
     .wakeupGPIOFxnLPDS         = NULL,
     .wakeupGPIOFxnLPDSArg      = 0,
     .wakeupGPIOSourceShutdown  = 0,
     .wakeupGPIOTypeShutdown    = 0,
-    .ramRetentionMaskLPDS      = 0,
+    .ramRetentionMaskLPDS      = PRCM_SRAM_COL_1 | PRCM_SRAM_COL_2 |
+                                 PRCM_SRAM_COL_3 | PRCM_SRAM_COL_4,
     .ioRetentionShutdown       = 0,
     .pinParkDefs               = NULL,
     .numPins                   = 0,
     .keepDebugActiveDuringLPDS = false,
-    .latencyForLPDS            = 20000,
+    .latencyForLPDS            = POWER_LPDS_LATENCY_US,
 };
 
 /*
@@ -224,5 +256,6 @@ void Board_init(void)
     GPIO_init();
     I2C_init();
     ADC_init();
+    ADCBuf_init();
     SPI_init();
 }
@@ -14,7 +14,8 @@
 /* Board indices (these map to the config array positions) */
 #define CONFIG_I2C_0        0
 #define CONFIG_ADC_CO       0
-#define CONFIG_ADC_MIC      1
+#define CONFIG_ADCBUF_0     0
+#define CONFIG_ADCBUF_0_MIC 0
 #define CONFIG_GPIO_LED_0   0
 #define CONFIG_GPIO_LED_1   1
 #define CONFIG_GPIO_BUZZER  2
@@ -1,10 +1,14 @@
 #include "wifi_mqtt.h"
+#include "boot_time.h"
 #include "config.h"
+#include "energy.h"
+#include "profile.h"
 
+#include <ti/drivers/dpl/HwiP.h>
 #include <ti/drivers/net/wifi/simplelink.h>
 #include <ti/net/mqtt/mqttclient.h>
 #include <string.h>
-#include <unistd.h>
+#include <time.h>
 
 /*
  * Wi-Fi + MQTT connectivity for CC3220SF
@@ -13,23 +17,155 @@
  * Import that example in Code Composer Studio for the full
  * Wi-Fi provisioning and TLS infrastructure.
  *
- * This file provides the simplified interface used by main.c.
+ * Events only set bits in `events`; all state changes happen in
+ * Conn_poll(), on the owning task, so the NWP and the MQTT client are
+ * never called from the SimpleLink event context.
+ *
+ * For the energy account the NWP is awake while it starts, joins,
+ * connects or sends, and asleep (low-power policy, waking for
+ * beacons) while associated with nothing to do.
+ *
+ * Each broker connect creates the MQTT client and a lost or failed
+ * session deletes it again. With STATIC_ALLOCATION the client from the
+ * first connect is kept and reconnected instead, so the heap does not
+ * change after it.
  */
 
+#define EV_BIT(ev)      (1U << (ev))
+
 static MQTTClient_Handle mqttClient;
+static bool session;                /* mqttClient connected to the broker */
+static ConnNotifyFxn notify;
+static volatile uint32_t events;    /* EV_BIT per pending ConnEvent_t */
+static volatile uint32_t event_ms[CONN_EV_NWP_FATAL + 1];   /* Latest of each */
 
-/* Store connection params for reconnect */
-static const char *stored_broker;
-static uint16_t stored_port;
-static const char *stored_client_id;
+static ConnState_t state;
+static bool nwp_on;
+static uint32_t due_ms;             /* Next try, or the join timeout */
+static uint32_t tries;              /* Failed tries since the last success */
+static bool dropped;                /* Down after having been up */
+static uint32_t down_ms;
+static uint32_t rng;
+static ConnStats_t stats;
 
-bool WiFi_connect(const char *ssid, const char *password)
+static ConnPhases_t cur;            /* Phases of the connect in progress */
+static uint32_t seq_ms;             /* Down (or boot) */
+static uint32_t joined_ms;          /* Current join requested */
+static uint32_t assoc_ms;           /* Current join associated; 0 if not yet */
+static bool fast;                   /* Current join is from the profile */
+#if WIFI_FAST_CONNECT
+static bool profile_stale;          /* Explicit join needed: rewrite the profile */
+#endif
+static char broker_ip[16];          /* MQTT_BROKER looked up; "" if not yet */
+
+static uint32_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000U + (uint32_t)(ts.tv_nsec / 1000000);
+}
+
+/* xorshift32; the jitter only has to keep devices that lost the broker
+ * together from retrying in step */
+static uint32_t random32(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static int16_t join_explicit(void)
+{
+    SlWlanSecParams_t secParams;
+    secParams.Type = SL_WLAN_SEC_TYPE_WPA_WPA2;
+    secParams.Key = (signed char *)WIFI_PASS;
+    secParams.KeyLen = strlen(WIFI_PASS);
+
+    return sl_WlanConnect((signed char *)WIFI_SSID, strlen(WIFI_SSID),
+                          NULL, &secParams, NULL);
+}
+
+#if WIFI_FAST_CONNECT
+/* Make the credentials the NWP's only profile */
+static void store_profile(void)
 {
     SlWlanSecParams_t secParams;
     secParams.Type = SL_WLAN_SEC_TYPE_WPA_WPA2;
-    secParams.Key = (signed char *)password;
-    secParams.KeyLen = strlen(password);
+    secParams.Key = (signed char *)WIFI_PASS;
+    secParams.KeyLen = strlen(WIFI_PASS);
 
+    sl_WlanProfileDel(SL_WLAN_DEL_ALL_PROFILES);
+    sl_WlanProfileAdd((signed char *)WIFI_SSID, strlen(WIFI_SSID),
+                      NULL, &secParams, NULL, 0, 0);
+}
+#endif
+
+/* Bring the NWP's stored profile, connection policy and address mode
+ * in line with config.h. They persist in its flash, so this writes only
+ * when they differ (first boot, changed config). The profile's key
+ * cannot be read back; a changed password shows up as a failed fast
+ * join and the profile is rewritten after the explicit one. Returns
+ * true if the NWP must restart to apply a change. */
+static bool nwp_configure(void)
+{
+    bool changed = false;
+
+    uint8_t policy = 0;
+    uint8_t len = 0;
+    sl_WlanPolicyGet(SL_WLAN_POLICY_CONNECTION, &policy, NULL, &len);
+#if WIFI_FAST_CONNECT
+    uint8_t want = SL_WLAN_CONNECTION_POLICY(1, 1, 0, 0);
+    signed char name[32];
+    int16_t name_len = 0;
+    SlWlanSecParams_t sec;
+    uint32_t priority;
+    bool have = sl_WlanProfileGet(0, name, &name_len, NULL, &sec, NULL, &priority) >= 0 &&
+                name_len == (int16_t)strlen(WIFI_SSID) &&
+                memcmp(name, WIFI_SSID, (size_t)name_len) == 0;
+    if (!have) {
+        store_profile();
+        changed = true;
+    }
+#else
+    uint8_t want = SL_WLAN_CONNECTION_POLICY(0, 0, 0, 0);
+    if (policy != want) sl_WlanProfileDel(SL_WLAN_DEL_ALL_PROFILES);
+#endif
+    if (policy != want) {
+        sl_WlanPolicySet(SL_WLAN_POLICY_CONNECTION, want, NULL, 0);
+        changed = true;
+    }
+
+    /* Sleep between beacons while connected; applies without a restart */
+    uint8_t pm = 0;
+    sl_WlanPolicyGet(SL_WLAN_POLICY_PM, &pm, NULL, &len);
+    if (pm != SL_WLAN_LOW_POWER_POLICY) {
+        sl_WlanPolicySet(SL_WLAN_POLICY_PM, SL_WLAN_LOW_POWER_POLICY, NULL, 0);
+    }
+
+    SlNetCfgIpV4Args_t ip = {0};
+    uint16_t ip_len = sizeof(ip);
+    uint16_t dhcp = 1;
+    sl_NetCfgGet(SL_NETCFG_IPV4_STA_ADDR_MODE, &dhcp, &ip_len, (uint8_t *)&ip);
+#ifdef WIFI_STATIC_IP
+    SlNetCfgIpV4Args_t want_ip = { WIFI_STATIC_IP, WIFI_STATIC_MASK,
+                                   WIFI_STATIC_GATEWAY, WIFI_STATIC_DNS };
+    if (dhcp != 0 || memcmp(&ip, &want_ip, sizeof(ip)) != 0) {
+        sl_NetCfgSet(SL_NETCFG_IPV4_STA_ADDR_MODE, SL_NETCFG_ADDR_STATIC,
+                     sizeof(want_ip), (uint8_t *)&want_ip);
+        changed = true;
+    }
+#else
+    if (dhcp == 0) {
+        sl_NetCfgSet(SL_NETCFG_IPV4_STA_ADDR_MODE, SL_NETCFG_ADDR_DHCP, 0, NULL);
+        changed = true;
+    }
+#endif
+    return changed;
+}
+
+static bool nwp_start(void)
+{
     /* Set device to station mode */
     int16_t role = sl_Start(NULL, NULL, NULL);
     if (role < 0) return false;
@@ -39,91 +175,380 @@ bool WiFi_connect(const char *ssid, const char *password)
         sl_Stop(200);
         if (sl_Start(NULL, NULL, NULL) < 0) return false;
     }
+    if (nwp_configure()) {
+        sl_Stop(200);
+        if (sl_Start(NULL, NULL, NULL) < 0) return false;
+    }
+    nwp_on = true;
+    return true;
+}
 
-    /* Connect to AP */
-    int16_t ret = sl_WlanConnect((signed char *)ssid, strlen(ssid),
-                                 NULL, &secParams, NULL);
-    if (ret < 0) return false;
+static void delete_client(void)
+{
+#if !STATIC_ALLOCATION
+    MQTTClient_delete(mqttClient);
+    mqttClient = NULL;
+#endif
+}
 
-    /* Wait for IP acquired using proper buffer */
-    int retries = 30;
-    while (retries-- > 0) {
-        SlNetCfgIpV4Args_t ipV4 = {0};
-        uint16_t len = sizeof(ipV4);
-        uint16_t dhcpIsOn = 0;
-        int16_t status = sl_NetCfgGet(SL_NETCFG_IPV4_STA_ADDR_MODE,
-                                       &dhcpIsOn, &len, (uint8_t *)&ipV4);
-        if (status >= 0 && ipV4.Ip != 0) return true;
-        sleep(1);
+static void drop_session(void)
+{
+    if (session) {
+        MQTTClient_disconnect(mqttClient);
+        session = false;
+        delete_client();
     }
+}
 
-    return false;  /* Timed out waiting for IP */
+static void nwp_stop(void)
+{
+    drop_session();
+    if (nwp_on) {
+        sl_Stop(200);
+        nwp_on = false;
+        stats.nwp_restarts++;
+    }
 }
 
-bool MQTT_connect(const char *broker, uint16_t port, const char *client_id)
+static void nwp_energy(void)
 {
-    /* Store for reconnect */
-    stored_broker = broker;
-    stored_port = port;
-    stored_client_id = client_id;
+    EnergyState_t s = ENERGY_OFF;
+    if (nwp_on) {
+        s = (state == CONN_UP || state == CONN_BROKER) ? ENERGY_SLEEP : ENERGY_AWAKE;
+    }
+    Energy_set(ENERGY_NWP, s);
+}
 
-    MQTTClient_ConnParams connParams = {0};
-    connParams.serverAddr = broker;
-    connParams.port = port;
+/* A try failed: make the next one in state `next` after the backoff */
+static void retry(ConnState_t next)
+{
+    uint32_t delay = CONN_BACKOFF_MIN_MS;
+    for (uint32_t i = 0; i < tries && delay < CONN_BACKOFF_MAX_MS; i++) {
+        delay *= 2;
+    }
+    if (delay > CONN_BACKOFF_MAX_MS) delay = CONN_BACKOFF_MAX_MS;
+    delay = delay / 2 + random32() % (delay / 2 + 1);
 
-    MQTTClient_Params mqttParams;
-    mqttParams.clientId = (char *)client_id;
-    mqttParams.connParams = &connParams;
+    tries++;
+    stats.failures++;
+    stats.backoff_ms = delay;
+    state = next;
+    due_ms = now_ms() + delay;
+}
 
-    mqttClient = MQTTClient_create(NULL, &mqttParams);
-    if (mqttClient == NULL) return false;
+/* Leaving CONN_UP: start timing the outage and try again at once */
+static void went_down(void)
+{
+    dropped = true;
+    down_ms = now_ms();
+    tries = 0;
+    due_ms = down_ms;
+    seq_ms = down_ms;
+    cur = (ConnPhases_t){0};
+}
 
-    /* Set optional username/password */
-    MQTTClient_set(mqttClient, MQTTClient_USER_NAME,
-                   MQTT_USER, strlen(MQTT_USER));
-    MQTTClient_set(mqttClient, MQTTClient_PASSWORD,
-                   MQTT_PASS, strlen(MQTT_PASS));
+static void went_up(void)
+{
+    state = CONN_UP;
+    tries = 0;
+    BootTime_mark(BOOT_MQTT_UP);
+    cur.total_ms = now_ms() - seq_ms;
+    stats.phases = cur;
+    if (dropped) {
+        uint32_t ms = now_ms() - down_ms;
+        dropped = false;
+        stats.reconnects++;
+        stats.latency_last_ms = ms;
+        if (ms > stats.latency_max_ms) stats.latency_max_ms = ms;
+        stats.latency_sum_ms += ms;
+    }
+}
 
-    /* Connect (retry on failure) */
-    int retries = 5;
-    while (retries-- > 0) {
-        if (MQTTClient_connect(mqttClient) == 0) return true;
-        sleep(2);
+/* Get the NWP joining the AP; the result arrives as an event */
+static bool join(void)
+{
+    stats.attempts++;
+    cur = (ConnPhases_t){0};
+    Energy_set(ENERGY_NWP, ENERGY_AWAKE);
+    if (!nwp_on) {
+        uint32_t t = now_ms();
+        if (!nwp_start()) return false;
+        cur.nwp_ms = now_ms() - t;
     }
 
-    /* All retries failed — clean up */
-    MQTTClient_delete(mqttClient);
-    mqttClient = NULL;
+#if WIFI_FAST_CONNECT
+    /* The NWP rejoins from its profile by itself after a start or a
+     * drop; join explicitly only once that has failed */
+    fast = (tries == 0);
+    if (!fast) {
+        if (join_explicit() < 0) return false;
+        profile_stale = true;
+    }
+#else
+    fast = false;
+    if (join_explicit() < 0) return false;
+#endif
+
+    joined_ms = now_ms();
+    assoc_ms = 0;
+    state = CONN_JOINING;
+    due_ms = joined_ms + CONN_JOIN_TIMEOUT_MS;
+    return true;
+}
+
+static bool is_ipv4(const char *s)
+{
+    for (; *s != '\0'; s++) {
+        if ((*s < '0' || *s > '9') && *s != '.') return false;
+    }
+    return true;
+}
+
+static char *put_octet(char *p, uint32_t v)
+{
+    if (v >= 100) *p++ = (char)('0' + v / 100);
+    if (v >= 10)  *p++ = (char)('0' + v / 10 % 10);
+    *p++ = (char)('0' + v % 10);
+    return p;
+}
+
+/* Broker address for the MQTT client: MQTT_BROKER if it is already an
+ * address, else the cached lookup (NULL if the lookup fails) */
+static const char *broker_addr(void)
+{
+    if (is_ipv4(MQTT_BROKER)) return MQTT_BROKER;
+    if (broker_ip[0] != '\0') return broker_ip;
+
+    uint32_t t = now_ms();
+    uint32_t ip;
+    stats.dns_lookups++;
+    if (sl_NetAppDnsGetHostByName((signed char *)MQTT_BROKER, strlen(MQTT_BROKER),
+                                  &ip, SL_AF_INET) < 0) {
+        return NULL;
+    }
+    cur.dns_ms = now_ms() - t;
+
+    char *p = broker_ip;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        p = put_octet(p, (ip >> shift) & 0xFF);
+        *p++ = shift ? '.' : '\0';
+    }
+    return broker_ip;
+}
+
+static bool broker_connect(void)
+{
+    stats.attempts++;
+    Energy_set(ENERGY_NWP, ENERGY_AWAKE);
+
+    const char *addr = broker_addr();
+    if (addr == NULL) return false;
+
+    /* Static: a kept client may refer to them */
+    static MQTTClient_ConnParams connParams;
+    connParams.serverAddr = addr;
+    connParams.port = MQTT_PORT;
+
+    if (mqttClient == NULL) {
+        static MQTTClient_Params mqttParams;
+        mqttParams.clientId = MQTT_CLIENT_ID;
+        mqttParams.connParams = &connParams;
+
+        mqttClient = MQTTClient_create(NULL, &mqttParams);
+        if (mqttClient == NULL) return false;
+
+        /* Set optional username/password */
+        MQTTClient_set(mqttClient, MQTTClient_USER_NAME,
+                       MQTT_USER, strlen(MQTT_USER));
+        MQTTClient_set(mqttClient, MQTTClient_PASSWORD,
+                       MQTT_PASS, strlen(MQTT_PASS));
+    }
+
+    uint32_t t = now_ms();
+    int16_t ret = MQTTClient_connect(mqttClient);
+    cur.broker_ms = now_ms() - t;
+    if (ret == 0) {
+        session = true;
+        return true;
+    }
+
+    /* After two failures in a row the broker may have moved: look it
+     * up again */
+    if (tries > 0) broker_ip[0] = '\0';
+    delete_client();
     return false;
 }
 
-bool MQTT_publish(const char *topic, const char *payload)
+/* The link went away (or the NWP must restart) */
+static void link_lost(bool restart)
 {
-    if (mqttClient == NULL) return false;
+    if (state == CONN_UP) {
+        stats.wlan_drops++;
+        went_down();
+    }
+    drop_session();
+    if (restart) nwp_stop();
 
-    int ret = MQTTClient_publish(mqttClient,
-                                  (char *)topic, strlen(topic),
-                                  (char *)payload, strlen(payload),
-                                  MQTT_QOS_0);
-    return (ret == 0);
+    if (state == CONN_JOINING) {
+        retry(CONN_START);
+    } else {
+        state = CONN_START;     /* Keeping any backoff already due */
+    }
 }
 
-bool MQTT_reconnect(void)
+void Conn_start(ConnNotifyFxn fxn)
 {
-    if (mqttClient != NULL) {
-        MQTTClient_disconnect(mqttClient);
-        MQTTClient_delete(mqttClient);
-        mqttClient = NULL;
+    notify = fxn;
+    rng = now_ms() * 2654435761U | 1;
+    state = CONN_START;
+    seq_ms = now_ms();
+    stats.latency_last_ms = CONN_NO_LATENCY;
+#ifdef WIFI_STATIC_IP
+    stats.static_ip = true;
+#endif
+
+    /* Start joining now rather than after the caller's own start-up;
+     * a failure is retried from Conn_poll() */
+    if (!join()) retry(CONN_START);
+    nwp_energy();
+}
+
+uint32_t Conn_poll(void)
+{
+    uintptr_t key = HwiP_disable();
+    uint32_t ev = events;
+    events = 0;
+    HwiP_restore(key);
+
+    /* Events left over from before the stop mean nothing now */
+    if (state == CONN_OFF) return UINT32_MAX;
+
+    if (ev & EV_BIT(CONN_EV_NWP_FATAL)) {
+        link_lost(true);
+    } else if (ev & EV_BIT(CONN_EV_WLAN_DOWN)) {
+        link_lost(false);
+    } else if (state == CONN_JOINING) {
+        if (ev & EV_BIT(CONN_EV_WLAN_UP)) assoc_ms = event_ms[CONN_EV_WLAN_UP];
     }
-    return MQTT_connect(stored_broker, stored_port, stored_client_id);
+
+    if ((ev & EV_BIT(CONN_EV_IP_ACQUIRED)) && state == CONN_JOINING) {
+        BootTime_mark(BOOT_WIFI_UP);
+        uint32_t ip_ms = event_ms[CONN_EV_IP_ACQUIRED];
+        if (assoc_ms == 0) assoc_ms = ip_ms;
+        cur.assoc_ms = assoc_ms - joined_ms;
+        cur.ip_ms = ip_ms - assoc_ms;
+        stats.fast_connect = fast;
+#if WIFI_FAST_CONNECT
+        if (profile_stale) {
+            store_profile();
+            profile_stale = false;
+        }
+#endif
+        tries = 0;
+        state = CONN_BROKER;
+        due_ms = now_ms();
+    }
+
+    if (state != CONN_UP && (int32_t)(now_ms() - due_ms) >= 0) {
+        switch (state) {
+        case CONN_START:
+            if (!join()) retry(CONN_START);
+            break;
+        case CONN_JOINING:
+            /* No address in time: start over with a fresh NWP */
+            nwp_stop();
+            retry(CONN_START);
+            break;
+        case CONN_BROKER:
+            if (broker_connect()) {
+                went_up();
+            } else {
+                retry(CONN_BROKER);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    nwp_energy();
+    if (state == CONN_UP) return UINT32_MAX;
+    int32_t left = (int32_t)(due_ms - now_ms());
+    return left > 0 ? (uint32_t)left : 0;
 }
 
-void MQTT_disconnect(void)
+bool Conn_isUp(void)
 {
-    if (mqttClient != NULL) {
-        MQTTClient_disconnect(mqttClient);
-        MQTTClient_delete(mqttClient);
-        mqttClient = NULL;
+    return state == CONN_UP;
+}
+
+void Conn_lost(void)
+{
+    if (state != CONN_UP) return;
+    stats.mqtt_drops++;
+    drop_session();
+    went_down();
+    state = CONN_BROKER;
+    nwp_energy();
+}
+
+void Conn_sleep(void)
+{
+    if (state == CONN_OFF) return;
+    drop_session();
+    if (nwp_on) {
+        sl_Stop(200);
+        nwp_on = false;
     }
-    sl_Stop(200);
+    /* An outage still in progress ends here as far as the reconnect
+     * latency goes; the next wake starts afresh */
+    state = CONN_OFF;
+    dropped = false;
+    tries = 0;
+    nwp_energy();
+}
+
+void Conn_wake(void)
+{
+    if (state != CONN_OFF) return;
+    stats.wakes++;
+    state = CONN_START;
+    seq_ms = now_ms();
+    if (!join()) retry(CONN_START);
+    nwp_energy();
+}
+
+bool Conn_isOff(void)
+{
+    return state == CONN_OFF;
+}
+
+void Conn_event(ConnEvent_t ev)
+{
+    event_ms[ev] = now_ms();
+    uintptr_t key = HwiP_disable();
+    events |= EV_BIT(ev);
+    HwiP_restore(key);
+    if (notify != NULL) notify();
+}
+
+void Conn_getStats(ConnStats_t *out)
+{
+    *out = stats;
+    out->state = state;
+}
+
+bool MQTT_publish(const char *topic, const void *payload, size_t len)
+{
+    if (!session || state != CONN_UP) return false;
+
+    Energy_set(ENERGY_NWP, ENERGY_AWAKE);
+    PROFILE_BEGIN(MQTT_PUBLISH);
+    int ret = MQTTClient_publish(mqttClient,
+                                  (char *)topic, strlen(topic),
+                                  (char *)payload, (uint16_t)len,
+                                  MQTT_QOS_0);
+    PROFILE_END(MQTT_PUBLISH);
+    nwp_energy();
+    return (ret == 0);
 }
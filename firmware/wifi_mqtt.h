@@ -1,27 +1,120 @@
 #ifndef WIFI_MQTT_H
 #define WIFI_MQTT_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
-/* Connect to Wi-Fi access point.
- * Returns true on success, false if connection failed after retries. */
-bool WiFi_connect(const char *ssid, const char *password);
+/*
+ * Wi-Fi + MQTT connection manager
+ *
+ * A state machine that brings up the NWP, joins the access point and
+ * connects to the broker, then keeps it that way. Link changes arrive
+ * as SimpleLink events (sl_event_handlers.c) instead of being polled.
+ * Every failure is followed by an exponential backoff with jitter,
+ * from CONN_BACKOFF_MIN_MS up to CONN_BACKOFF_MAX_MS, which the caller
+ * waits out in its own loop: nothing here sleeps. The one blocking call
+ * left is the broker CONNECT itself, made only once the station has an
+ * address.
+ *
+ * With WIFI_FAST_CONNECT the credentials live in an NWP profile, and
+ * the NWP rejoins by itself (fast connect, no scan) when started or
+ * dropped; the manager only joins explicitly once that has failed.
+ * WIFI_STATIC_IP skips DHCP. A broker host name is looked up once and
+ * the address reused until connects to it fail twice in a row. Each
+ * connection records how long its phases took (ConnPhases_t).
+ *
+ * For radio duty cycling the owner can stop the NWP between flushes
+ * with Conn_sleep() and bring the link back with Conn_wake(), which
+ * rejoins the same way as after a reset. A planned stop is not a drop.
+ */
 
-/* Connect to MQTT broker.
- * Returns true on success, false if connection failed after retries. */
-bool MQTT_connect(const char *broker, uint16_t port, const char *client_id);
+typedef enum {
+    CONN_START,         /* Start the NWP and join the AP when due */
+    CONN_JOINING,       /* Waiting for association and a DHCP lease */
+    CONN_BROKER,        /* Have an address; connect to the broker when due */
+    CONN_UP,            /* Broker session established */
+    CONN_OFF            /* NWP stopped by Conn_sleep() */
+} ConnState_t;
 
-/* Publish a message to an MQTT topic.
- * Returns true on success, false on failure. */
-bool MQTT_publish(const char *topic, const char *payload);
+/* SimpleLink events the manager acts on */
+typedef enum {
+    CONN_EV_WLAN_UP,    /* Associated with the AP */
+    CONN_EV_IP_ACQUIRED,
+    CONN_EV_WLAN_DOWN,  /* Disconnected from the AP, or failed to join */
+    CONN_EV_NWP_FATAL   /* NWP needs a restart */
+} ConnEvent_t;
 
-/* Attempt to reconnect to the MQTT broker using previously stored params.
- * Call this after MQTT_publish returns false.
- * Returns true on success, false if reconnect failed. */
-bool MQTT_reconnect(void);
+#define CONN_NO_LATENCY     UINT32_MAX
 
-/* Disconnect from MQTT broker and Wi-Fi. */
-void MQTT_disconnect(void);
+/* Milliseconds spent in each phase of the latest successful connect,
+ * counted from the try that succeeded; phases it did not need are 0 */
+typedef struct {
+    uint32_t nwp_ms;            /* sl_Start, with any reconfiguration */
+    uint32_t assoc_ms;          /* Join (or NWP start) to association */
+    uint32_t ip_ms;             /* Association to address: DHCP */
+    uint32_t dns_ms;            /* Broker name lookup */
+    uint32_t broker_ms;         /* MQTT CONNECT */
+    uint32_t total_ms;          /* Going down (or boot) to broker session */
+} ConnPhases_t;
+
+typedef struct {
+    ConnState_t state;
+    bool     fast_connect;      /* Joined from the stored profile */
+    bool     static_ip;
+    uint32_t attempts;          /* Joins and broker connects started */
+    uint32_t failures;          /* Of those, failed or timed out */
+    uint32_t wlan_drops;        /* Link lost while up */
+    uint32_t mqtt_drops;        /* Broker session lost, link still up */
+    uint32_t nwp_restarts;
+    uint32_t reconnects;        /* Back up after a drop */
+    uint32_t latency_last_ms;   /* Drop to back up, or CONN_NO_LATENCY */
+    uint32_t latency_max_ms;
+    uint64_t latency_sum_ms;
+    uint32_t backoff_ms;        /* Delay chosen for the latest retry */
+    uint32_t dns_lookups;
+    uint32_t wakes;             /* Conn_wake() calls that started the NWP */
+    ConnPhases_t phases;
+} ConnStats_t;
+
+/* Called from the SimpleLink event context after each event, so the
+ * owner of the connection can run Conn_poll() promptly. Must not block. */
+typedef void (*ConnNotifyFxn)(void);
+
+/* Start the NWP (the serial flash needs it too) and begin joining.
+ * Call once, from the task that will call Conn_poll(). */
+void Conn_start(ConnNotifyFxn notify);
+
+/* Act on pending events and due retries. Returns the milliseconds
+ * until it next needs calling; UINT32_MAX if only an event can
+ * change anything. */
+uint32_t Conn_poll(void);
+
+/* True while the broker session is up. */
+bool Conn_isUp(void);
+
+/* Report a failed publish: the session is dropped and reconnected. */
+void Conn_lost(void);
+
+/* Close the broker session and stop the NWP until Conn_wake(). The
+ * serial flash is unreachable meanwhile. */
+void Conn_sleep(void);
+
+/* Start the NWP again and begin joining; like Conn_start(), it returns
+ * with the NWP started (the serial flash usable) unless that failed.
+ * Does nothing unless stopped by Conn_sleep(). */
+void Conn_wake(void);
+
+/* True while stopped by Conn_sleep(). */
+bool Conn_isOff(void);
+
+/* Deliver a SimpleLink event. Safe from the SimpleLink event context. */
+void Conn_event(ConnEvent_t ev);
+
+void Conn_getStats(ConnStats_t *stats);
+
+/* Publish len bytes of payload to an MQTT topic.
+ * Returns true on success, false on failure (or if not connected). */
+bool MQTT_publish(const char *topic, const void *payload, size_t len);
 
 #endif
@@ -0,0 +1,63 @@
+#include "window_stat.h"
+
+void WindowStat_reset(WindowStat_t *s)
+{
+    *s = (WindowStat_t){0};
+}
+
+void WindowStat_add(WindowStat_t *s, int32_t x)
+{
+    if (s->n == 0) {
+        s->ref = x;
+        s->min = x;
+        s->max = x;
+    }
+    if (s->n == WINDOW_STAT_MAX_N) return;
+    int64_t d = (int64_t)x - s->ref;
+    s->n++;
+    s->sum += d;
+    s->sumsq += (uint64_t)(d * d);
+    if (x < s->min) s->min = x;
+    if (x > s->max) s->max = x;
+}
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t r = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > v) bit >>= 2;
+    while (bit != 0) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+/* a / b rounded to nearest, halves away from zero; b > 0 */
+static int64_t div_round64(int64_t a, int64_t b)
+{
+    return (a >= 0 ? a + b / 2 : a - b / 2) / b;
+}
+
+bool WindowStat_result(const WindowStat_t *s, int32_t *mean, WindowSpread_t *spread)
+{
+    if (s->n == 0) return false;
+    int64_t n = s->n;
+
+    *mean = (int32_t)(s->ref + div_round64(s->sum, n));
+
+    /* n * variance = sumsq - sum^2 / n, with sum^2 / n split so no
+     * product leaves 64 bits */
+    int64_t q = s->sum / n;
+    int64_t r = s->sum % n;
+    uint64_t m2 = s->sumsq - (uint64_t)(q * s->sum + r * s->sum / n);
+    spread->min = s->min;
+    spread->max = s->max;
+    spread->sd = isqrt64((m2 + (uint64_t)n / 2) / (uint64_t)n);
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef WINDOW_STAT_H
+#define WINDOW_STAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Streaming statistics of one reading over a sampling window
+ *
+ * Constant memory and no floating point: the sums are kept exactly,
+ * in 64-bit integers, relative to the window's first value. Shifting
+ * the data this way gives the same protection as Welford's update
+ * against the cancellation in sum(x^2) - sum(x)^2 / n, and being exact
+ * it needs none of Welford's per-sample division. Exact for readings
+ * within 2^24 of the first and windows of up to 2^14 readings.
+ */
+
+#define WINDOW_STAT_MAX_N   16384
+
+typedef struct {
+    uint32_t n;
+    int32_t  ref;           /* First reading */
+    int32_t  min;
+    int32_t  max;
+    int64_t  sum;           /* Of (x - ref) */
+    uint64_t sumsq;         /* Of (x - ref)^2 */
+} WindowStat_t;
+
+/* Spread of the window, in the readings' units */
+typedef struct {
+    int32_t  min;
+    int32_t  max;
+    uint32_t sd;            /* Standard deviation */
+} WindowSpread_t;
+
+/* Start a new window. */
+void WindowStat_reset(WindowStat_t *s);
+
+/* Fold one reading in. */
+void WindowStat_add(WindowStat_t *s, int32_t x);
+
+/* Mean, rounded, and the spread (population standard deviation,
+ * rounded) of the window. Returns false, leaving both untouched, if it
+ * has no readings. */
+bool WindowStat_result(const WindowStat_t *s, int32_t *mean, WindowSpread_t *spread);
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * envdecode.c - Turn binary environment frames into Influx line protocol
+ *
+ * Reads one hex-encoded frame per line from stdin, as printed by
+ *
+ *   mosquitto_sub -t home/env/bin -F %x | envdecode | influx write ...
+ *
+ * or, with -r, a single raw frame (e.g. from mosquitto_sub -N). Each
+ * record is timestamped with the receive time minus its age.
+ *
+ *   envdecode [-r] [-m MEASUREMENT] [-t TAGS]
+ */
+
+#include "envframe.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_FRAME   (ENVFRAME_HEADER_LEN + ENVFRAME_MAX_RECORDS * ENVFRAME_RECORD_LEN)
+
+static const char *measurement = "environment";
+static const char *tags = NULL;
+
+static int hex_nibble(int c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* Returns decoded length, or -1 on a malformed line */
+static long parse_hex(const char *line, uint8_t *out, size_t max)
+{
+    size_t n = 0;
+    while (*line && *line != '\n' && *line != '\r') {
+        if (*line == ' ') { line++; continue; }
+        int hi = hex_nibble(line[0]);
+        int lo = (hi >= 0) ? hex_nibble(line[1]) : -1;
+        if (lo < 0 || n >= max) return -1;
+        out[n++] = (uint8_t)(hi << 4 | lo);
+        line += 2;
+    }
+    return (long)n;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int emit(const uint8_t *frame, size_t len)
+{
+    static EnvFrameRecord recs[ENVFRAME_MAX_RECORDS];
+    size_t count;
+    EnvFrameStatus st = EnvFrame_decode(frame, len, recs, ENVFRAME_MAX_RECORDS, &count);
+    if (st != ENVFRAME_OK) {
+        fprintf(stderr, "envdecode: %s (%zu bytes)\n", EnvFrame_strerror(st), len);
+        return 1;
+    }
+
+    int64_t t_rx = now_ns();
+    char line[1024];
+    for (size_t i = 0; i < count; i++) {
+        int64_t ts = t_rx - (int64_t)recs[i].age_s * 1000000000LL;
+        if (EnvFrame_toLineProtocol(&recs[i], measurement, tags, ts, line, sizeof(line))) {
+            fputs(line, stdout);
+        }
+    }
+    fflush(stdout);
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: envdecode [-r] [-m MEASUREMENT] [-t TAGS]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int raw = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0) {
+            raw = 1;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            measurement = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            tags = argv[++i];
+        } else {
+            usage();
+        }
+    }
+
+    static uint8_t frame[MAX_FRAME];
+    int errors = 0;
+
+    if (raw) {
+        size_t len = fread(frame, 1, sizeof(frame), stdin);
+        return emit(frame, len);
+    }
+
+    static char line[2 * MAX_FRAME + 16];
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        long len = parse_hex(line, frame, sizeof(frame));
+        if (len < 0) {
+            fprintf(stderr, "envdecode: malformed hex line\n");
+            errors++;
+            continue;
+        }
+        if (len > 0) errors += emit(frame, (size_t)len);
+    }
+    return errors ? 1 : 0;
+}
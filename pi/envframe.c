@@ -0,0 +1,155 @@
+/*
+ * envframe.c - Decoder for the environment monitor's binary MQTT frames
+ */
+
+#include "envframe.h"
+
+#include <stdio.h>
+
+#define INVALID_U16     0xFFFF
+
+static uint16_t get_u16le(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static double opt_fixed(uint16_t raw, double scale)
+{
+    return (raw == INVALID_U16) ? -1.0 : raw / scale;
+}
+
+/* Scale of each spread, in record order; temp is signed */
+static const double spread_scale[ENVFRAME_SPREADS] = {
+    100.0, 100.0, 10.0, 1.0, 1.0, 10.0, 1.0, 10.0, 10.0, 10.0,
+};
+
+/* Line protocol names and decimals of the spread fields */
+static const char *const spread_name[ENVFRAME_SPREADS] = {
+    "temp", "hum", "press", "eco2", "tvoc", "co_ppm", "lux", "pm1", "pm25", "pm10",
+};
+static const int spread_prec[ENVFRAME_SPREADS] = { 2, 2, 1, 0, 0, 1, 0, 1, 1, 1 };
+
+static double spread_value(int i, uint16_t raw)
+{
+    return (i == 0 ? (int16_t)raw : raw) / spread_scale[i];
+}
+
+EnvFrameStatus EnvFrame_decode(const uint8_t *buf, size_t len,
+                               EnvFrameRecord *out, size_t max,
+                               size_t *count)
+{
+    *count = 0;
+    if (len < ENVFRAME_HEADER_LEN)             return ENVFRAME_ERR_SHORT;
+    if (buf[0] != ENVFRAME_MAGIC)              return ENVFRAME_ERR_MAGIC;
+    if (buf[1] < 1 || buf[1] > ENVFRAME_VERSION) return ENVFRAME_ERR_VERSION;
+
+    bool levels = buf[1] >= 2;
+    bool spreads = buf[1] >= 3;
+    size_t rec_len = spreads ? ENVFRAME_RECORD_LEN
+                   : levels ? ENVFRAME_RECORD_LEN_V2 : ENVFRAME_RECORD_LEN_V1;
+    size_t n = buf[2];
+    if (len != ENVFRAME_HEADER_LEN + n * rec_len) {
+        return ENVFRAME_ERR_LENGTH;
+    }
+    if (n > max) return ENVFRAME_ERR_SPACE;
+
+    const uint8_t *p = buf + ENVFRAME_HEADER_LEN;
+    for (size_t i = 0; i < n; i++, p += rec_len) {
+        EnvFrameRecord *r = &out[i];
+        r->age_s    = get_u16le(&p[0]);
+        r->temp     = (int16_t)get_u16le(&p[2]) / 100.0;
+        r->hum      = get_u16le(&p[4]) / 100.0;
+        r->press    = get_u16le(&p[6]) / 10.0;
+        r->eco2     = opt_fixed(get_u16le(&p[8]), 1.0);
+        r->tvoc     = opt_fixed(get_u16le(&p[10]), 1.0);
+        r->co_ppm   = opt_fixed(get_u16le(&p[12]), 10.0);
+        r->lux      = get_u16le(&p[14]);
+        r->pm1      = opt_fixed(get_u16le(&p[16]), 10.0);
+        r->pm25     = opt_fixed(get_u16le(&p[18]), 10.0);
+        r->pm10     = opt_fixed(get_u16le(&p[20]), 10.0);
+        r->noise_db = get_u16le(&p[22]) / 10.0;
+        r->co_alarm = (p[24] & 0x01) != 0;
+        r->has_levels = levels;
+        if (levels) {
+            r->laeq  = get_u16le(&p[25]) / 10.0;
+            r->lamax = get_u16le(&p[27]) / 10.0;
+            r->lamin = get_u16le(&p[29]) / 10.0;
+            r->la10  = get_u16le(&p[31]) / 10.0;
+            r->la90  = get_u16le(&p[33]) / 10.0;
+        } else {
+            r->laeq = r->lamax = r->lamin = r->la10 = r->la90 = 0.0;
+        }
+        r->has_spread = spreads;
+        for (int k = 0; k < ENVFRAME_SPREADS; k++) {
+            EnvFrameSpread *s = &r->spread[k];
+            const uint8_t *q = &p[35 + 6 * k];
+            s->valid = spreads && get_u16le(&q[4]) != INVALID_U16;
+            if (s->valid) {
+                s->min = spread_value(k, get_u16le(&q[0]));
+                s->max = spread_value(k, get_u16le(&q[2]));
+                s->sd  = spread_value(k, get_u16le(&q[4]));
+            } else {
+                s->min = s->max = s->sd = 0.0;
+            }
+        }
+    }
+    *count = n;
+    return ENVFRAME_OK;
+}
+
+const char *EnvFrame_strerror(EnvFrameStatus status)
+{
+    switch (status) {
+    case ENVFRAME_OK:           return "ok";
+    case ENVFRAME_ERR_SHORT:    return "frame too short";
+    case ENVFRAME_ERR_MAGIC:    return "bad magic";
+    case ENVFRAME_ERR_VERSION:  return "unsupported version";
+    case ENVFRAME_ERR_LENGTH:   return "length does not match record count";
+    case ENVFRAME_ERR_SPACE:    return "too many records";
+    }
+    return "unknown error";
+}
+
+size_t EnvFrame_toLineProtocol(const EnvFrameRecord *r,
+                               const char *measurement, const char *tags,
+                               int64_t timestamp_ns, char *buf, size_t size)
+{
+    int n = snprintf(buf, size,
+        "%s%s%s "
+        "temp=%.2f,hum=%.2f,press=%.1f,eco2=%.0f,tvoc=%.0f,"
+        "co_ppm=%.1f,lux=%.0f,pm1=%.1f,pm25=%.1f,pm10=%.1f,"
+        "noise_db=%.1f,",
+        measurement, (tags && *tags) ? "," : "", (tags && *tags) ? tags : "",
+        r->temp, r->hum, r->press, r->eco2, r->tvoc,
+        r->co_ppm, r->lux, r->pm1, r->pm25, r->pm10,
+        r->noise_db);
+    if (n < 0 || (size_t)n >= size) return 0;
+    size_t len = (size_t)n;
+
+    /* Version 1 frames have no levels; leave the fields out rather
+     * than write zeros */
+    if (r->has_levels) {
+        n = snprintf(buf + len, size - len,
+            "laeq=%.1f,lamax=%.1f,lamin=%.1f,la10=%.1f,la90=%.1f,",
+            r->laeq, r->lamax, r->lamin, r->la10, r->la90);
+        if (n < 0 || (size_t)n >= size - len) return 0;
+        len += (size_t)n;
+    }
+
+    /* Spreads only for windows that had readings, as in the JSON */
+    for (int k = 0; k < ENVFRAME_SPREADS; k++) {
+        const EnvFrameSpread *s = &r->spread[k];
+        if (!s->valid) continue;
+        int prec = spread_prec[k];
+        n = snprintf(buf + len, size - len, "%s_min=%.*f,%s_max=%.*f,%s_sd=%.*f,",
+                     spread_name[k], prec, s->min, spread_name[k], prec, s->max,
+                     spread_name[k], prec, s->sd);
+        if (n < 0 || (size_t)n >= size - len) return 0;
+        len += (size_t)n;
+    }
+
+    n = snprintf(buf + len, size - len, "co_alert=\"%s\" %lld\n",
+                 r->co_alarm ? "true" : "false", (long long)timestamp_ns);
+    if (n < 0 || (size_t)n >= size - len) return 0;
+    return len + (size_t)n;
+}
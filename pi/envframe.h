@@ -0,0 +1,97 @@
+/*
+ * envframe.h - Decoder for the environment monitor's binary MQTT frames
+ *
+ * Mirrors the layout documented in firmware/payload.h. Usable from C
+ * and C++ on the Raspberry Pi (or any little- or big-endian host).
+ */
+
+#ifndef ENVFRAME_H
+#define ENVFRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ENVFRAME_MAGIC          0x45
+#define ENVFRAME_VERSION        3     /* Newest layout understood */
+#define ENVFRAME_HEADER_LEN     4
+#define ENVFRAME_RECORD_LEN_V1  25
+#define ENVFRAME_RECORD_LEN_V2  35
+#define ENVFRAME_RECORD_LEN     95    /* Largest record */
+#define ENVFRAME_SPREADS        10
+#define ENVFRAME_MAX_RECORDS    255
+
+typedef enum {
+    ENVFRAME_OK = 0,
+    ENVFRAME_ERR_SHORT,         /* Shorter than a header */
+    ENVFRAME_ERR_MAGIC,         /* Not an environment monitor frame */
+    ENVFRAME_ERR_VERSION,       /* Newer layout than this decoder knows */
+    ENVFRAME_ERR_LENGTH,        /* Length does not match record count */
+    ENVFRAME_ERR_SPACE          /* More records than the caller's array */
+} EnvFrameStatus;
+
+/* Spread of a field's readings over the sampling window, in the
+ * field's units */
+typedef struct {
+    bool     valid;         /* False: no readings in the window */
+    double   min;
+    double   max;
+    double   sd;            /* Standard deviation */
+} EnvFrameSpread;
+
+/* One decoded sample in engineering units. Readings the device could
+ * not take (co, eco2, tvoc, pm*) are reported as -1, as in the JSON
+ * payload. */
+typedef struct {
+    uint32_t age_s;         /* Seconds before the frame was sent */
+    double   temp;          /* C */
+    double   hum;           /* %RH */
+    double   press;         /* hPa */
+    double   eco2;          /* ppm */
+    double   tvoc;          /* ppb */
+    double   co_ppm;        /* ppm */
+    double   lux;           /* lux */
+    double   pm1;           /* ug/m3 */
+    double   pm25;          /* ug/m3 */
+    double   pm10;          /* ug/m3 */
+    double   noise_db;      /* dB */
+    bool     co_alarm;
+    bool     has_levels;    /* Version 2: the A-weighted levels below */
+    double   laeq;          /* dB(A) */
+    double   lamax;         /* dB(A) */
+    double   lamin;         /* dB(A) */
+    double   la10;          /* dB(A) */
+    double   la90;          /* dB(A) */
+    bool     has_spread;    /* Version 3: the window spreads below */
+    EnvFrameSpread spread[ENVFRAME_SPREADS];    /* temp, hum, press, eco2,
+                                                 * tvoc, co_ppm, lux, pm1,
+                                                 * pm25, pm10 */
+} EnvFrameRecord;
+
+/* Decode a frame (version 1 to 3) into at most max records; *count
+ * receives the number decoded. */
+EnvFrameStatus EnvFrame_decode(const uint8_t *buf, size_t len,
+                               EnvFrameRecord *out, size_t max,
+                               size_t *count);
+
+/* Human-readable name for a status code. */
+const char *EnvFrame_strerror(EnvFrameStatus status);
+
+/* Format one record as an Influx line protocol line (with trailing
+ * newline). tags may be NULL or "k=v[,k=v...]". Fields use the same
+ * names and float types Telegraf's JSON parser produces for the JSON
+ * payload, so both paths can share a measurement. Returns the length
+ * written, or 0 if it does not fit. */
+size_t EnvFrame_toLineProtocol(const EnvFrameRecord *rec,
+                               const char *measurement, const char *tags,
+                               int64_t timestamp_ns, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
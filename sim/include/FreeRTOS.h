@@ -0,0 +1,42 @@
+/*
+ * FreeRTOS.h - Host simulation stand-in for the FreeRTOS kernel header
+ *
+ * Only the types and macros the firmware uses. Ticks are 1 ms, as in
+ * the CC3220 FreeRTOSConfig.h; tasks run on the sim scheduler. The
+ * heap functions (portable.h on the target) keep heap_4's accounting
+ * over a configTOTAL_HEAP_SIZE budget (sim_rtos.c).
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t      TickType_t;
+typedef long          BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t      StackType_t;
+
+#define pdFALSE             ((BaseType_t)0)
+#define pdTRUE              ((BaseType_t)1)
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define errQUEUE_EMPTY      ((BaseType_t)0)
+#define errQUEUE_FULL       ((BaseType_t)0)
+
+#define configTICK_RATE_HZ  1000
+#define configTOTAL_HEAP_SIZE               ((size_t)32768)
+#define configSUPPORT_STATIC_ALLOCATION     1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+#define INCLUDE_xTaskGetCurrentTaskHandle   1
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS  ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000U))
+
+void *pvPortMalloc(size_t xSize);
+void vPortFree(void *pv);
+size_t xPortGetFreeHeapSize(void);
+size_t xPortGetMinimumEverFreeHeapSize(void);
+
+#endif
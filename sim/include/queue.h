@@ -0,0 +1,35 @@
+/*
+ * queue.h - Host simulation stand-in for FreeRTOS queues
+ *
+ * Copy-in/copy-out queues with blocking timeouts in virtual time
+ * (sim_rtos.c). A send or receive that unblocks a higher-priority task
+ * switches to it immediately, as in FreeRTOS.
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+/* Holds a statically allocated queue; its contents are private. */
+typedef struct {
+    void       *dummy[6];
+} StaticQueue_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+QueueHandle_t xQueueCreateStatic(UBaseType_t uxQueueLength, UBaseType_t uxItemSize,
+                                 uint8_t *pucQueueStorageBuffer,
+                                 StaticQueue_t *pxStaticQueue);
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue,
+                      TickType_t xTicksToWait);
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue,
+                             TickType_t xTicksToWait);
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer,
+                         TickType_t xTicksToWait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue);
+
+#define xQueueSendToBack    xQueueSend
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ * task.h - Host simulation stand-in for the FreeRTOS task API
+ *
+ * The tick count, absolute-time delays and stack watermarks
+ * (sim_rtos.c). A delay sleeps the calling task in virtual time and
+ * counts as idle, like sleep(). Watermarks measure the task's host
+ * stack, so they show x86-64 frame sizes, not the target's.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+
+TickType_t xTaskGetTickCount(void);
+
+/* Block until *pxPreviousWakeTime + xTimeIncrement, then advance
+ * *pxPreviousWakeTime by xTimeIncrement. Returns at once if that
+ * time has already passed. */
+void vTaskDelayUntil(TickType_t *pxPreviousWakeTime, TickType_t xTimeIncrement);
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+/* Least free stack space the task has had, in StackType_t words;
+ * NULL for the calling task. */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
+
+#endif
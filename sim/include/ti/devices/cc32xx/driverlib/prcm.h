@@ -0,0 +1,12 @@
+/*
+ * prcm.h - Host simulation stand-in for the CC32xx driverlib power,
+ * reset and clock module: the 32.768 kHz slow clock counter, read
+ * from the virtual clock (sim_power.c)
+ */
+
+#ifndef __PRCM_H__
+#define __PRCM_H__
+
+unsigned long long PRCMSlowClkCtrGet(void);
+
+#endif
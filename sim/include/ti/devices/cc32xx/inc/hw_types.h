@@ -0,0 +1,18 @@
+/*
+ * hw_types.h - Host simulation stand-in for the CC32xx driverlib
+ * register access types. Only the DWT cycle counter is modelled
+ * (sim_clock.c); other registers read back what was written.
+ */
+
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+#include <stdbool.h>
+
+typedef bool tBoolean;
+
+volatile unsigned long *SimReg(unsigned long addr);
+
+#define HWREG(x)    (*SimReg(x))
+
+#endif
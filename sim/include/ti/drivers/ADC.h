@@ -0,0 +1,30 @@
+/*
+ * ADC.h - Host simulation stand-in for the TI SimpleLink ADC driver
+ *
+ * Each channel index is backed by a sample function registered with
+ * SimADC_attach() (see sim.h). A conversion consumes virtual time.
+ */
+
+#ifndef ti_drivers_ADC__include
+#define ti_drivers_ADC__include
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ADC_STATUS_SUCCESS      0
+#define ADC_STATUS_ERROR        (-1)
+
+typedef struct ADC_Config_ *ADC_Handle;
+
+typedef struct {
+    void *custom;
+    bool  isProtected;
+} ADC_Params;
+
+void         ADC_init(void);
+void         ADC_Params_init(ADC_Params *params);
+ADC_Handle   ADC_open(uint_least8_t index, ADC_Params *params);
+void         ADC_close(ADC_Handle handle);
+int_fast16_t ADC_convert(ADC_Handle handle, uint16_t *value);
+
+#endif
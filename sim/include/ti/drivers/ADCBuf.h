@@ -0,0 +1,69 @@
+/*
+ * ADCBuf.h - Host simulation stand-in for the TI SimpleLink ADCBuf driver
+ *
+ * Only callback mode is modelled, as used with the CC32xx uDMA: each
+ * channel samples at the fixed 62.5 ksps and completed buffers are
+ * handed to the callback from a simulated interrupt. Sample data comes
+ * from the fill function registered with SimADCBuf_attach() (see
+ * sim.h).
+ */
+
+#ifndef ti_drivers_ADCBuf__include
+#define ti_drivers_ADCBuf__include
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ADCBuf_STATUS_SUCCESS       0
+#define ADCBuf_STATUS_ERROR         (-1)
+#define ADCBuf_STATUS_UNDEFINEDCMD  (-2)
+#define ADCBuf_STATUS_TIMEOUT       (-3)
+
+typedef struct ADCBuf_Config_ *ADCBuf_Handle;
+
+typedef struct {
+    uint16_t  samplesRequestedCount;
+    void     *sampleBuffer;
+    void     *sampleBufferTwo;
+    void     *arg;
+    uint32_t  adcChannel;
+} ADCBuf_Conversion;
+
+typedef void (*ADCBuf_Callback)(ADCBuf_Handle handle,
+                                ADCBuf_Conversion *conversion,
+                                void *completedADCBuffer,
+                                uint32_t completedChannel,
+                                int_fast16_t status);
+
+typedef enum {
+    ADCBuf_RECURRENCE_MODE_ONE_SHOT,
+    ADCBuf_RECURRENCE_MODE_CONTINUOUS,
+} ADCBuf_Recurrence_Mode;
+
+typedef enum {
+    ADCBuf_RETURN_MODE_BLOCKING,
+    ADCBuf_RETURN_MODE_CALLBACK,
+} ADCBuf_Return_Mode;
+
+typedef struct {
+    ADCBuf_Return_Mode     returnMode;
+    uint32_t               blockingTimeout;
+    ADCBuf_Callback        callbackFxn;
+    ADCBuf_Recurrence_Mode recurrenceMode;
+    uint32_t               samplingFrequency;
+    void                  *custom;
+} ADCBuf_Params;
+
+void          ADCBuf_init(void);
+void          ADCBuf_Params_init(ADCBuf_Params *params);
+ADCBuf_Handle ADCBuf_open(uint_least8_t index, ADCBuf_Params *params);
+void          ADCBuf_close(ADCBuf_Handle handle);
+int_fast16_t  ADCBuf_convert(ADCBuf_Handle handle,
+                             ADCBuf_Conversion conversions[],
+                             uint_fast8_t channelCount);
+int_fast16_t  ADCBuf_convertCancel(ADCBuf_Handle handle);
+int_fast16_t  ADCBuf_adjustRawValues(ADCBuf_Handle handle, void *sampleBuffer,
+                                     uint_fast16_t sampleCount,
+                                     uint32_t adcChannel);
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ * GPIO.h - Host simulation stand-in for the TI SimpleLink GPIO driver
+ *
+ * Output writes are recorded with their virtual timestamp so the
+ * simulator can report alarm behaviour (see SimGPIO_watch()).
+ */
+
+#ifndef ti_drivers_GPIO__include
+#define ti_drivers_GPIO__include
+
+#include <stdint.h>
+
+typedef uint32_t GPIO_PinConfig;
+
+#define GPIO_CFG_OUTPUT         0x00000001
+#define GPIO_CFG_OUT_STD        0x00000001
+#define GPIO_CFG_OUT_LOW        0x00000000
+#define GPIO_CFG_OUT_HIGH       0x00000010
+
+void GPIO_init(void);
+int_fast16_t GPIO_setConfig(uint_least8_t index, GPIO_PinConfig pinConfig);
+void GPIO_write(uint_least8_t index, unsigned int value);
+unsigned int GPIO_read(uint_least8_t index);
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * I2C.h - Host simulation stand-in for the TI SimpleLink I2C driver
+ *
+ * Declares the subset of <ti/drivers/I2C.h> used by the firmware.
+ * Transfers are routed to simulated devices registered with
+ * SimI2C_attach() (see sim.h) and consume virtual bus time.
+ */
+
+#ifndef ti_drivers_I2C__include
+#define ti_drivers_I2C__include
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define I2C_STATUS_SUCCESS      0
+#define I2C_STATUS_INCOMPLETE   1
+#define I2C_STATUS_ERROR        (-1)
+#define I2C_STATUS_ADDR_NACK    (-5)
+#define I2C_STATUS_CANCEL       (-10)
+
+typedef struct I2C_Config_ *I2C_Handle;
+
+typedef enum {
+    I2C_MODE_BLOCKING,
+    I2C_MODE_CALLBACK
+} I2C_TransferMode;
+
+typedef enum {
+    I2C_100kHz = 0,
+    I2C_400kHz = 1,
+    I2C_1000kHz = 2
+} I2C_BitRate;
+
+typedef struct {
+    const void     *writeBuf;
+    size_t          writeCount;
+    void           *readBuf;
+    size_t          readCount;
+    void           *arg;
+    void           *nextPtr;
+    uint_least8_t   targetAddress;
+    volatile int_fast16_t status;
+} I2C_Transaction;
+
+typedef void (*I2C_CallbackFxn)(I2C_Handle handle, I2C_Transaction *transaction,
+                                bool transferStatus);
+
+typedef struct {
+    I2C_TransferMode transferMode;
+    I2C_CallbackFxn  transferCallbackFxn;
+    I2C_BitRate      bitRate;
+    void            *custom;
+} I2C_Params;
+
+void       I2C_init(void);
+void       I2C_Params_init(I2C_Params *params);
+I2C_Handle I2C_open(uint_least8_t index, I2C_Params *params);
+void       I2C_close(I2C_Handle handle);
+bool       I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction);
+void       I2C_cancel(I2C_Handle handle);
+
+#endif
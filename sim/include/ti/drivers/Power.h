@@ -0,0 +1,37 @@
+/*
+ * Power.h - Host simulation stand-in for the TI Power driver
+ *
+ * Constraints and notifications only. The sleep policy itself runs in
+ * sim_power.c whenever the scheduler finds every task blocked.
+ */
+
+#ifndef ti_drivers_Power__include
+#define ti_drivers_Power__include
+
+#include <stdint.h>
+
+#define Power_SOK               0
+#define Power_EFAIL             (-1)
+#define Power_NOTIFYDONE        0
+
+typedef int_fast16_t (*Power_NotifyFxn)(uint_fast16_t eventType,
+                                        uintptr_t eventArg,
+                                        uintptr_t clientArg);
+
+typedef struct Power_NotifyObj {
+    struct Power_NotifyObj *next;
+    uint_fast16_t           eventTypes;
+    Power_NotifyFxn         notifyFxn;
+    uintptr_t               clientArg;
+} Power_NotifyObj;
+
+void         Power_init(void);
+int_fast16_t Power_registerNotify(Power_NotifyObj *notifyObj,
+                                  uint_fast16_t eventTypes,
+                                  Power_NotifyFxn notifyFxn,
+                                  uintptr_t clientArg);
+void         Power_unregisterNotify(Power_NotifyObj *notifyObj);
+int_fast16_t Power_setConstraint(uint_fast16_t constraintId);
+int_fast16_t Power_releaseConstraint(uint_fast16_t constraintId);
+
+#endif
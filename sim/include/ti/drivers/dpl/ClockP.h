@@ -0,0 +1,36 @@
+/*
+ * ClockP.h - Host simulation stand-in for the TI driver porting layer
+ * clock
+ *
+ * Declares the subset of <ti/drivers/dpl/ClockP.h> used by the
+ * firmware: one-shot clocks and the system tick. Ticks are 1 ms of
+ * virtual time, as with the target's 1 kHz FreeRTOS tick; a clock
+ * function runs as a simulated interrupt (see sim_dpl.c).
+ */
+
+#ifndef ti_dpl_ClockP__include
+#define ti_dpl_ClockP__include
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef void *ClockP_Handle;
+
+typedef void (*ClockP_Fxn)(uintptr_t arg);
+
+typedef struct {
+    bool      startFlag;
+    uint32_t  period;           /* Only 0 (one-shot) is modelled */
+    uintptr_t arg;
+} ClockP_Params;
+
+void          ClockP_Params_init(ClockP_Params *params);
+ClockP_Handle ClockP_create(ClockP_Fxn clockFxn, uint32_t timeout,
+                            ClockP_Params *params);
+void          ClockP_setTimeout(ClockP_Handle handle, uint32_t timeout);
+void          ClockP_start(ClockP_Handle handle);
+void          ClockP_stop(ClockP_Handle handle);
+uint32_t      ClockP_getSystemTicks(void);
+uint32_t      ClockP_getSystemTickPeriod(void);
+
+#endif
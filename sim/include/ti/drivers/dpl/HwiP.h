@@ -0,0 +1,25 @@
+/*
+ * HwiP.h - Host simulation stand-in for the TI driver porting layer
+ * interrupt lock
+ *
+ * Simulated interrupts run only between task switches (see
+ * sim_clock.c), never in the middle of task code, so masking them is
+ * a no-op.
+ */
+
+#ifndef ti_dpl_HwiP__include
+#define ti_dpl_HwiP__include
+
+#include <stdint.h>
+
+static inline uintptr_t HwiP_disable(void)
+{
+    return 0;
+}
+
+static inline void HwiP_restore(uintptr_t key)
+{
+    (void)key;
+}
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * SemaphoreP.h - Host simulation stand-in for the TI driver porting
+ * layer semaphore
+ *
+ * Binary semaphores on the sim task scheduler (see sim_dpl.c).
+ * Timeouts are in ClockP ticks; posting is allowed from simulated
+ * interrupts.
+ */
+
+#ifndef ti_dpl_SemaphoreP__include
+#define ti_dpl_SemaphoreP__include
+
+#include <stdint.h>
+
+#define SemaphoreP_WAIT_FOREVER     (~(0U))
+
+typedef enum {
+    SemaphoreP_OK = 0,
+    SemaphoreP_TIMEOUT = -1
+} SemaphoreP_Status;
+
+typedef void *SemaphoreP_Handle;
+
+SemaphoreP_Handle SemaphoreP_createBinary(unsigned int count);
+SemaphoreP_Status SemaphoreP_pend(SemaphoreP_Handle handle, uint32_t timeout);
+void              SemaphoreP_post(SemaphoreP_Handle handle);
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ * simplelink.h - Host simulation stand-in for the SimpleLink Wi-Fi host driver
+ *
+ * Declares the subset of the NWP API used by wifi_mqtt.c and
+ * sl_event_handlers.c. The simulated NWP associates and obtains an
+ * address after a fixed virtual delay (see sim_net.c).
+ */
+
+#ifndef __SIMPLELINK_H__
+#define __SIMPLELINK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Device roles */
+#define ROLE_STA                        0
+#define ROLE_AP                         2
+
+/* Error codes */
+#define SL_RET_CODE_OK                  0
+#define SL_ERROR_BSD_EALREADY           (-114)
+#define SL_RET_CODE_DEV_NOT_STARTED     (-2018)
+
+/* Security types */
+#define SL_WLAN_SEC_TYPE_OPEN           0
+#define SL_WLAN_SEC_TYPE_WEP            1
+#define SL_WLAN_SEC_TYPE_WPA_WPA2       2
+
+/* Network configuration IDs */
+#define SL_NETCFG_IPV4_STA_ADDR_MODE    1
+
+/* SL_NETCFG_IPV4_STA_ADDR_MODE options */
+#define SL_NETCFG_ADDR_STATIC           0
+#define SL_NETCFG_ADDR_DHCP             1
+
+#define SL_IPV4_VAL(a, b, c, d)         (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | \
+                                         ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+/* WLAN policies */
+#define SL_WLAN_POLICY_CONNECTION       0x10
+#define SL_WLAN_POLICY_PM               0x20
+#define SL_WLAN_CONNECTION_POLICY(Auto, Fast, anyP2P, autoProvisioning) \
+    (((Auto) << 0) | ((Fast) << 1) | ((anyP2P) << 3) | ((autoProvisioning) << 4))
+
+/* SL_WLAN_POLICY_PM options */
+#define SL_WLAN_NORMAL_POLICY           0
+#define SL_WLAN_LOW_POWER_POLICY        2
+
+#define SL_WLAN_DEL_ALL_PROFILES        0xFF
+#define SL_WLAN_MAX_PROFILES            7
+
+#define SL_AF_INET                      2
+
+typedef struct {
+    uint8_t      Type;
+    signed char *Key;
+    uint8_t      KeyLen;
+} SlWlanSecParams_t;
+
+typedef struct {
+    signed char *User;
+    uint8_t      UserLen;
+    signed char *AnonUser;
+    uint8_t      AnonUserLen;
+    uint8_t      CertIndex;
+    uint32_t     EapMethod;
+} SlWlanSecParamsExt_t;
+
+typedef struct {
+    signed char *User;
+    uint8_t      UserLen;
+    signed char *AnonUser;
+    uint8_t      AnonUserLen;
+    uint8_t      CertIndex;
+    uint32_t     EapMethod;
+} SlWlanGetSecParamsExt_t;
+
+typedef struct {
+    uint32_t Ip;
+    uint32_t IpMask;
+    uint32_t IpGateway;
+    uint32_t IpDnsServer;
+} SlNetCfgIpV4Args_t;
+
+/* ---- Asynchronous events ---- */
+
+#define SL_WLAN_EVENT_CONNECT           1
+#define SL_WLAN_EVENT_DISCONNECT        2
+
+#define SL_NETAPP_EVENT_IPV4_ACQUIRED   1
+#define SL_NETAPP_EVENT_IP_COLLISION    4
+#define SL_NETAPP_EVENT_DHCP_IPV4_ACQUIRE_TIMEOUT 9
+
+typedef struct {
+    uint8_t SsidLen;
+    uint8_t SsidName[32];
+    uint8_t Bssid[6];
+} SlWlanEventConnect_t;
+
+typedef struct {
+    uint8_t SsidLen;
+    uint8_t SsidName[32];
+    uint8_t Bssid[6];
+    uint8_t ReasonCode;
+} SlWlanEventDisconnect_t;
+
+typedef union {
+    SlWlanEventConnect_t    Connect;
+    SlWlanEventDisconnect_t Disconnect;
+} SlWlanEventData_u;
+
+typedef struct {
+    uint32_t          Id;
+    SlWlanEventData_u Data;
+} SlWlanEvent_t;
+
+typedef struct {
+    uint32_t Ip;
+    uint32_t Gateway;
+    uint32_t Dns;
+} SlIpV4AcquiredAsync_t;
+
+typedef union {
+    SlIpV4AcquiredAsync_t IpAcquiredV4;
+} SlNetAppEventData_u;
+
+typedef struct {
+    uint32_t            Id;
+    SlNetAppEventData_u Data;
+} SlNetAppEvent_t;
+
+typedef struct {
+    uint32_t Id;
+    int16_t  Status;
+} SlDeviceEvent_t;
+
+typedef struct {
+    uint32_t Id;
+} SlDeviceFatal_t;
+
+typedef struct {
+    uint32_t Event;
+} SlSockEvent_t;
+
+typedef struct {
+    uint32_t Event;
+} SlNetAppHttpServerEvent_t;
+
+typedef struct {
+    uint32_t Response;
+} SlNetAppHttpServerResponse_t;
+
+typedef struct {
+    uint8_t AppId;
+    uint8_t Type;
+} SlNetAppRequest_t;
+
+typedef struct {
+    uint16_t Status;
+} SlNetAppResponse_t;
+
+/* ---- Application callbacks (defined in sl_event_handlers.c) ---- */
+
+void SimpleLinkWlanEventHandler(SlWlanEvent_t *pWlanEvent);
+void SimpleLinkNetAppEventHandler(SlNetAppEvent_t *pNetAppEvent);
+void SimpleLinkGeneralEventHandler(SlDeviceEvent_t *pDevEvent);
+void SimpleLinkFatalErrorEventHandler(SlDeviceFatal_t *slFatalErrorEvent);
+void SimpleLinkSockEventHandler(SlSockEvent_t *pSock);
+
+/* ---- Device / WLAN / NetCfg API ---- */
+
+int16_t sl_Start(const void *pIfHdl, signed char *pDevName, const void *pInitCallBack);
+int16_t sl_Stop(const uint16_t Timeout);
+int16_t sl_WlanSetMode(const uint8_t Mode);
+int16_t sl_WlanConnect(const signed char *pName, const int16_t NameLen,
+                       const uint8_t *pMacAddr,
+                       const SlWlanSecParams_t *pSecParams,
+                       const SlWlanSecParamsExt_t *pSecExtParams);
+int16_t sl_WlanDisconnect(void);
+int16_t sl_WlanProfileAdd(const signed char *pName, const int16_t NameLen,
+                          const uint8_t *pMacAddr,
+                          const SlWlanSecParams_t *pSecParams,
+                          const SlWlanSecParamsExt_t *pSecExtParams,
+                          const uint32_t Priority, const uint32_t Options);
+int16_t sl_WlanProfileGet(const int16_t Index, signed char *pName,
+                          int16_t *pNameLen, uint8_t *pMacAddr,
+                          SlWlanSecParams_t *pSecParams,
+                          SlWlanGetSecParamsExt_t *pSecExtParams,
+                          uint32_t *pPriority);
+int16_t sl_WlanProfileDel(const int16_t Index);
+int16_t sl_WlanPolicySet(const uint8_t Type, const uint8_t Policy,
+                         uint8_t *pVal, const uint8_t ValLen);
+int16_t sl_WlanPolicyGet(const uint8_t Type, uint8_t *pPolicy,
+                         uint8_t *pVal, uint8_t *pValLen);
+int16_t sl_NetCfgGet(const uint16_t ConfigId, uint16_t *pConfigOpt,
+                     uint16_t *pConfigLen, uint8_t *pValues);
+int16_t sl_NetCfgSet(const uint16_t ConfigId, const uint16_t ConfigOpt,
+                     const uint16_t ConfigLen, const uint8_t *pValues);
+int16_t sl_NetAppDnsGetHostByName(signed char *pHostName,
+                                  const uint16_t NameLen,
+                                  uint32_t *OutIpAddr, const uint8_t Family);
+
+/* ---- Serial flash file system ---- */
+
+#define SL_FS_READ                      0x00000000
+#define SL_FS_WRITE                     0x01000000
+#define SL_FS_CREATE                    0x02000000
+#define SL_FS_OVERWRITE                 0x04000000
+#define SL_FS_CREATE_FAILSAFE           0x00010000
+#define SL_FS_CREATE_NOSIGNATURE        0x00020000
+#define SL_FS_CREATE_MAX_SIZE(size)     ((((uint32_t)(size) + 255) / 256) & 0xFFFF)
+
+#define SL_ERROR_FS_FILE_NOT_EXISTS    (-10341)
+
+int32_t sl_FsOpen(const uint8_t *pFileName, const uint32_t AccessModeAndMaxSize,
+                  uint32_t *pToken);
+int16_t sl_FsClose(const int32_t FileHdl, const uint8_t *pCeritificateFileName,
+                   const uint8_t *pSignature, const uint32_t SignatureLen);
+int32_t sl_FsRead(const int32_t FileHdl, uint32_t Offset, uint8_t *pData,
+                  uint32_t Len);
+int32_t sl_FsWrite(const int32_t FileHdl, uint32_t Offset, uint8_t *pData,
+                   uint32_t Len);
+int16_t sl_FsDel(const uint8_t *pFileName, const uint32_t Token);
+
+#endif
@@ -0,0 +1,18 @@
+/*
+ * PowerCC32XX.h - Host simulation stand-in for the CC32xx Power
+ * driver's constraint and event IDs
+ */
+
+#ifndef ti_drivers_power_PowerCC32XX__include
+#define ti_drivers_power_PowerCC32XX__include
+
+#include <ti/drivers/Power.h>
+
+/* Constraints */
+#define PowerCC32XX_DISALLOW_LPDS       0
+
+/* Notification events */
+#define PowerCC32XX_ENTERING_LPDS       0x1
+#define PowerCC32XX_AWAKE_LPDS          0x4
+
+#endif
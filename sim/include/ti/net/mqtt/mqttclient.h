@@ -0,0 +1,61 @@
+/*
+ * mqttclient.h - Host simulation stand-in for the TI MQTT client library
+ *
+ * Publishes are delivered to the simulated broker in sim_net.c, which
+ * records their virtual timestamps and can inject outages.
+ */
+
+#ifndef ti_net_mqtt_mqttclient__include
+#define ti_net_mqtt_mqttclient__include
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MQTT_QOS_0      0x00
+#define MQTT_QOS_1      0x02
+#define MQTT_QOS_2      0x04
+#define MQTT_RETAIN     0x08
+
+typedef void *MQTTClient_Handle;
+
+typedef enum {
+    MQTTClient_USER_NAME = 1,
+    MQTTClient_PASSWORD  = 2,
+    MQTTClient_WILL_PARAM = 3,
+    MQTTClient_KEEPALIVE_TIME = 4,
+    MQTTClient_CLEAN_CONNECT = 5
+} MQTTClient_Option;
+
+typedef struct {
+    uint32_t           netconnFlags;
+    const char        *serverAddr;
+    uint16_t           port;
+    uint8_t            method;
+    uint32_t           cipher;
+    uint8_t            nFiles;
+    char * const      *secureFiles;
+} MQTTClient_ConnParams;
+
+typedef struct {
+    char                  *clientId;
+    MQTTClient_ConnParams *connParams;
+    bool                   mqttMode31;
+    bool                   blockingSend;
+} MQTTClient_Params;
+
+typedef void (*MQTTClient_EventCB)(int32_t event, void *metaData,
+                                   uint32_t metaDateLen, void *data,
+                                   uint32_t dataLen);
+
+MQTTClient_Handle MQTTClient_create(MQTTClient_EventCB defaultCallback,
+                                    MQTTClient_Params *attrib);
+int16_t MQTTClient_delete(MQTTClient_Handle handle);
+int16_t MQTTClient_connect(MQTTClient_Handle handle);
+int16_t MQTTClient_disconnect(MQTTClient_Handle handle);
+int16_t MQTTClient_set(MQTTClient_Handle handle, MQTTClient_Option option,
+                       void *value, uint32_t valueLength);
+int16_t MQTTClient_publish(MQTTClient_Handle handle, char *topic,
+                           uint16_t topicLen, char *msg, uint16_t msgLen,
+                           uint32_t flags);
+
+#endif
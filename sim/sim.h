@@ -0,0 +1,232 @@
+/*
+ * sim.h - Host-native simulation harness for the environment monitor
+ *
+ * The firmware sources in firmware/ are compiled unmodified for the
+ * host. The TI driver, SimpleLink and MQTT headers they include are
+ * replaced by the stand-ins in sim/include, which route every call to
+ * the pluggable backends declared here. All time is virtual: blocking
+ * calls (sleep, usleep, I2C and ADC transfers) advance a simulated
+ * clock instead of waiting, and CLOCK_MONOTONIC reads it, so days of
+ * loop time run in seconds. Firmware tasks are scheduled by priority
+ * on that clock, one at a time, as on the single-core target.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SIM_US_PER_SEC      1000000ULL
+
+/* ---- Virtual clock (sim_clock.c) ---- */
+
+/* Current virtual time in microseconds since power-on. */
+uint64_t SimClock_nowUs(void);
+
+/* Block the calling task inside a driver call (bus transfers,
+ * conversions); other tasks may run meanwhile. Counted as busy time. */
+void SimClock_busy(uint64_t us);
+
+/* Block the calling task in a sleep. Counted as idle time. */
+void SimClock_idle(uint64_t us);
+
+/* Stop the simulation at end_us and call on_end() (which must not
+ * return) once no task can run before it. */
+void SimClock_setLimit(uint64_t end_us, void (*on_end)(void));
+
+typedef struct {
+    uint64_t busy_us;           /* Virtual time blocked in drivers */
+    uint64_t idle_us;           /* Virtual time sleeping */
+    uint32_t wakeups;           /* Number of sleep calls */
+    uint32_t irqs;              /* Interrupt handlers run */
+    uint64_t host_ns_total;     /* Host CPU time spent between sleeps */
+    uint64_t host_ns_max;       /* Longest host CPU stretch between sleeps */
+} SimClockStats_t;
+
+void SimClock_getStats(SimClockStats_t *stats);
+
+/* ---- Tasks (sim_clock.c) ---- */
+
+/* Create a task; higher priority runs first. Call before SimTask_run. */
+void SimTask_create(const char *name, int priority, void *(*entry)(void *));
+
+/* Start scheduling. Does not return; the run ends via the limit. */
+void SimTask_run(void);
+
+/* Index of the calling task. */
+int SimTask_self(void);
+
+/* Block the calling task until wake_us (UINT64_MAX: indefinitely) or
+ * an earlier SimTask_wake(). Returns the virtual time on waking. */
+uint64_t SimTask_wait(uint64_t wake_us);
+
+/* Make a blocked task ready; switches to it if it has higher priority. */
+void SimTask_wake(int task);
+
+/* Bytes of the task's host stack never yet used. Stacks are
+ * SIM_TASK_STACK bytes, filled with a pattern at creation. */
+#define SIM_TASK_STACK  (256 * 1024)
+size_t SimTask_stackFree(int task);
+
+/* ---- Interrupts (sim_clock.c) ---- */
+
+/* A peripheral interrupt handler. It runs at the virtual time given to
+ * SimIrq_schedule(), ahead of every task, and must not block; a
+ * SimTask_wake() from it takes effect when it returns. */
+typedef void (*SimIrqFxn)(void *arg);
+
+int  SimIrq_create(SimIrqFxn fxn, void *arg);
+
+/* Fire once at at_us (UINT64_MAX: cancel). */
+void SimIrq_schedule(int irq, uint64_t at_us);
+
+/* ---- Cortex-M registers (sim_clock.c) ---- */
+
+/* Clear the DWT cycle counter as LPDS does; it counts on from 0. */
+void SimReg_resetCycles(void);
+
+/* ---- Power: LPDS sleep policy (sim_power.c) ---- */
+
+/* Called by the scheduler with every task blocked, before the clock
+ * jumps ahead to wake_us. Applies the sleep policy of config.h. If it
+ * enters LPDS it runs the ENTERING_LPDS notifications and returns the
+ * time the MCU wakes again (wake_us less the exit latency); the
+ * scheduler then calls SimPower_wake() at that time. Returns 0 if the
+ * MCU waits in WFI sleep instead. */
+uint64_t SimPower_sleep(uint64_t wake_us);
+void SimPower_wake(void);
+
+typedef struct {
+    uint32_t lpds_entries;
+    uint64_t lpds_us;           /* Virtual time in LPDS */
+    uint64_t wfi_us;            /* Idle but awake */
+    uint64_t held_us;           /* Of that, idle long enough for LPDS
+                                 * while a constraint held it off */
+} SimPowerStats_t;
+
+void SimPower_getStats(SimPowerStats_t *stats);
+
+/* ---- I2C bus (sim_i2c.c) ---- */
+
+typedef struct SimI2CDevice SimI2CDevice;
+
+struct SimI2CDevice {
+    const char *name;
+    uint8_t     addr;
+    /* Handle a write phase; return false to NACK. */
+    bool (*write)(SimI2CDevice *dev, const uint8_t *buf, size_t len);
+    /* Fill a read phase; return false to NACK. */
+    bool (*read)(SimI2CDevice *dev, uint8_t *buf, size_t len);
+    void       *ctx;
+    uint32_t    transfers;
+    uint32_t    errors;
+    SimI2CDevice *next;
+};
+
+void SimI2C_attach(SimI2CDevice *dev);
+SimI2CDevice *SimI2C_devices(void);
+
+/* ---- ADC channels (sim_adc.c) ---- */
+
+/* Return a 12-bit code for channel `index` at virtual time now_us. */
+typedef uint16_t (*SimADCSampleFxn)(uint_least8_t index, uint64_t now_us);
+
+void SimADC_attach(uint_least8_t index, SimADCSampleFxn fxn);
+
+/* ---- ADCBuf continuous capture (sim_adcbuf.c) ---- */
+
+/* Fill n 12-bit codes for ADCBuf channel `channel`, the first sampled
+ * at start_us and the rest every period_us. */
+typedef void (*SimADCBufFillFxn)(uint_least8_t channel, uint64_t start_us,
+                                 uint32_t period_us, uint16_t *codes, size_t n);
+
+void SimADCBuf_attach(uint_least8_t channel, SimADCBufFillFxn fxn);
+
+/* ---- GPIO outputs (sim_gpio.c) ---- */
+
+typedef void (*SimGPIOWatchFxn)(uint_least8_t index, unsigned int value,
+                                uint64_t now_us);
+
+void SimGPIO_watch(SimGPIOWatchFxn fxn);
+
+/* ---- Network: NWP + MQTT broker (sim_net.c) ---- */
+
+typedef void (*SimMQTTSinkFxn)(const char *topic, const char *msg,
+                               size_t len, uint64_t now_us);
+
+/* Broker is unreachable in [start_us, start_us + len_us). */
+void SimNet_setOutage(uint64_t start_us, uint64_t len_us);
+
+/* Access point is gone in [start_us, start_us + len_us): the link
+ * drops and joins fail. */
+void SimNet_setApOutage(uint64_t start_us, uint64_t len_us);
+void SimNet_setSink(SimMQTTSinkFxn fxn);
+
+/* True between sl_Start and sl_Stop. */
+bool SimNet_nwpStarted(void);
+
+typedef struct {
+    uint32_t connects;
+    uint32_t connect_failures;
+    uint32_t publishes;
+    uint32_t publish_failures;
+    uint32_t wlan_drops;        /* Links dropped by an AP outage */
+    uint64_t bytes;
+} SimNetStats_t;
+
+void SimNet_getStats(SimNetStats_t *stats);
+
+/* ---- Serial flash file system (sim_fs.c) ---- */
+
+typedef struct {
+    uint32_t files;             /* Files currently stored */
+    uint32_t blocks;            /* 4 KB blocks they occupy */
+    uint32_t peak_files;
+    uint32_t peak_blocks;
+    uint32_t commits;           /* Files written (closed after writing) */
+    uint32_t aborts;
+    uint32_t deletes;
+    uint32_t blocks_programmed; /* Erase/program cycles, summed over files */
+    uint64_t bytes_written;
+    uint64_t bytes_read;
+} SimFsStats_t;
+
+void SimFs_getStats(SimFsStats_t *stats);
+
+/* NWP system files (names under "/sys/", e.g. Wi-Fi profiles): the NWP
+ * reads and writes them itself, so these cost no virtual time, may be
+ * called from interrupts, and are left out of the stats. Get returns
+ * false unless the file exists with exactly len bytes. */
+bool SimFs_getSystem(const char *name, void *buf, size_t len);
+void SimFs_putSystem(const char *name, const void *buf, size_t len);
+
+/* Load or save every file, to carry flash contents across runs (a
+ * simulated reset). Load returns false if the image does not exist. */
+bool SimFs_load(const char *path);
+bool SimFs_save(const char *path);
+
+/* ---- Device models (sim_devices.c) ---- */
+
+typedef struct {
+    uint64_t co_event_start_us;     /* 0 = no CO event */
+    uint64_t co_event_len_us;
+    uint64_t co_event_ramp_us;      /* Rise and fall time; 0 = step */
+    double   co_event_peak_ppm;
+    double   co_baseline_ppm;
+} SimScenario_t;
+
+/* Attach BME280, SGP30, BH1750, MQ-7 and microphone models. */
+void SimDevices_attach(const SimScenario_t *scenario);
+
+/* Ground-truth CO concentration the MQ-7 model is exposed to. */
+double SimDevices_coPPM(uint64_t now_us);
+
+typedef struct {
+    uint64_t sgp30_max_gap_us;  /* Longest interval between measure_iaq */
+} SimDeviceStats_t;
+
+void SimDevices_getStats(SimDeviceStats_t *stats);
+
+#endif
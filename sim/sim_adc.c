@@ -0,0 +1,67 @@
+/*
+ * sim_adc.c - Simulated CC32xx ADC
+ *
+ * The CC3220 ADC samples each channel every 16 us (62.5 ksps per
+ * channel in the round-robin), so every ADC_convert() blocks for at
+ * least that long, out of LPDS. Channels without a model read as
+ * zero.
+ */
+
+#include <ti/drivers/ADC.h>
+#include <ti/drivers/power/PowerCC32XX.h>
+
+#include "sim.h"
+
+#define SIM_ADC_CHANNELS    4
+#define SIM_ADC_CONVERT_US  16
+
+struct ADC_Config_ {
+    uint_least8_t   index;
+    bool            open;
+    SimADCSampleFxn sample;
+};
+
+static struct ADC_Config_ channels[SIM_ADC_CHANNELS];
+
+void SimADC_attach(uint_least8_t index, SimADCSampleFxn fxn)
+{
+    if (index < SIM_ADC_CHANNELS) channels[index].sample = fxn;
+}
+
+void ADC_init(void)
+{
+}
+
+void ADC_Params_init(ADC_Params *params)
+{
+    params->custom = NULL;
+    params->isProtected = true;
+}
+
+ADC_Handle ADC_open(uint_least8_t index, ADC_Params *params)
+{
+    (void)params;
+    if (index >= SIM_ADC_CHANNELS || channels[index].open) return NULL;
+    channels[index].index = index;
+    channels[index].open = true;
+    return &channels[index];
+}
+
+void ADC_close(ADC_Handle handle)
+{
+    handle->open = false;
+}
+
+int_fast16_t ADC_convert(ADC_Handle handle, uint16_t *value)
+{
+    Power_setConstraint(PowerCC32XX_DISALLOW_LPDS);
+    SimClock_busy(SIM_ADC_CONVERT_US);
+    Power_releaseConstraint(PowerCC32XX_DISALLOW_LPDS);
+    if (handle->sample == NULL) {
+        *value = 0;
+        return ADC_STATUS_SUCCESS;
+    }
+    uint16_t code = handle->sample(handle->index, SimClock_nowUs());
+    *value = (code > 4095) ? 4095 : code;
+    return ADC_STATUS_SUCCESS;
+}
@@ -0,0 +1,149 @@
+/*
+ * sim_adcbuf.c - Simulated CC32xx ADCBuf driver
+ *
+ * One ADCBuf instance converting one channel at the CC3220's fixed
+ * 62.5 ksps (one sample per channel every 16 us). In continuous mode
+ * the two buffers alternate: when one fills, a simulated uDMA
+ * interrupt fills it from the channel model and calls the callback,
+ * while capture carries on into the other. Capture takes no task
+ * time, but keeps the MCU out of LPDS while it runs. Channels without
+ * a model read as zero.
+ */
+
+#include <ti/drivers/ADCBuf.h>
+#include <ti/drivers/power/PowerCC32XX.h>
+
+#include "sim.h"
+
+#include <string.h>
+
+#define SIM_ADCBUF_CHANNELS     4
+#define SIM_ADCBUF_PERIOD_US    16
+
+struct ADCBuf_Config_ {
+    bool               open;
+    bool               running;
+    ADCBuf_Params      params;
+    ADCBuf_Conversion *conversion;
+    void              *filling;         /* Buffer being captured into */
+    uint64_t           start_us;        /* When its first sample is taken */
+    int                irq;
+};
+
+static struct ADCBuf_Config_ adcbuf = { .irq = -1 };
+static SimADCBufFillFxn fills[SIM_ADCBUF_CHANNELS];
+
+void SimADCBuf_attach(uint_least8_t channel, SimADCBufFillFxn fxn)
+{
+    if (channel < SIM_ADCBUF_CHANNELS) fills[channel] = fxn;
+}
+
+static uint64_t buffer_us(const ADCBuf_Conversion *conv)
+{
+    return (uint64_t)conv->samplesRequestedCount * SIM_ADCBUF_PERIOD_US;
+}
+
+static void buffer_done(void *arg)
+{
+    ADCBuf_Handle h = arg;
+    ADCBuf_Conversion *conv = h->conversion;
+    void *done = h->filling;
+    uint32_t ch = conv->adcChannel;
+
+    if (fills[ch] != NULL) {
+        fills[ch](ch, h->start_us, SIM_ADCBUF_PERIOD_US, done,
+                  conv->samplesRequestedCount);
+    } else {
+        memset(done, 0, conv->samplesRequestedCount * sizeof(uint16_t));
+    }
+
+    /* DMA moves on to the other buffer before the callback runs */
+    h->start_us += buffer_us(conv);
+    if (h->params.recurrenceMode == ADCBuf_RECURRENCE_MODE_CONTINUOUS) {
+        h->filling = (done == conv->sampleBuffer) ? conv->sampleBufferTwo
+                                                  : conv->sampleBuffer;
+        SimIrq_schedule(h->irq, h->start_us + buffer_us(conv));
+    } else {
+        h->running = false;
+        Power_releaseConstraint(PowerCC32XX_DISALLOW_LPDS);
+    }
+
+    h->params.callbackFxn(h, conv, done, ch, ADCBuf_STATUS_SUCCESS);
+}
+
+void ADCBuf_init(void)
+{
+}
+
+void ADCBuf_Params_init(ADCBuf_Params *params)
+{
+    params->returnMode = ADCBuf_RETURN_MODE_BLOCKING;
+    params->blockingTimeout = UINT32_MAX;
+    params->callbackFxn = NULL;
+    params->recurrenceMode = ADCBuf_RECURRENCE_MODE_ONE_SHOT;
+    params->samplingFrequency = 10000;
+    params->custom = NULL;
+}
+
+ADCBuf_Handle ADCBuf_open(uint_least8_t index, ADCBuf_Params *params)
+{
+    if (index != 0 || adcbuf.open || params == NULL) return NULL;
+    /* Only callback mode is modelled */
+    if (params->returnMode != ADCBuf_RETURN_MODE_CALLBACK ||
+        params->callbackFxn == NULL) {
+        return NULL;
+    }
+    if (adcbuf.irq < 0) adcbuf.irq = SimIrq_create(buffer_done, &adcbuf);
+    adcbuf.params = *params;
+    adcbuf.open = true;
+    return &adcbuf;
+}
+
+void ADCBuf_close(ADCBuf_Handle handle)
+{
+    ADCBuf_convertCancel(handle);
+    handle->open = false;
+}
+
+int_fast16_t ADCBuf_convert(ADCBuf_Handle handle,
+                            ADCBuf_Conversion conversions[],
+                            uint_fast8_t channelCount)
+{
+    ADCBuf_Conversion *conv = &conversions[0];
+    if (handle->running || channelCount != 1 ||
+        conv->adcChannel >= SIM_ADCBUF_CHANNELS ||
+        conv->samplesRequestedCount == 0 || conv->sampleBuffer == NULL ||
+        (handle->params.recurrenceMode == ADCBuf_RECURRENCE_MODE_CONTINUOUS &&
+         conv->sampleBufferTwo == NULL)) {
+        return ADCBuf_STATUS_ERROR;
+    }
+
+    handle->conversion = conv;
+    handle->filling = conv->sampleBuffer;
+    handle->start_us = SimClock_nowUs();
+    handle->running = true;
+    Power_setConstraint(PowerCC32XX_DISALLOW_LPDS);
+    SimIrq_schedule(handle->irq, handle->start_us + buffer_us(conv));
+    return ADCBuf_STATUS_SUCCESS;
+}
+
+int_fast16_t ADCBuf_convertCancel(ADCBuf_Handle handle)
+{
+    if (!handle->running) return ADCBuf_STATUS_ERROR;
+    handle->running = false;
+    SimIrq_schedule(handle->irq, UINT64_MAX);
+    Power_releaseConstraint(PowerCC32XX_DISALLOW_LPDS);
+    return ADCBuf_STATUS_SUCCESS;
+}
+
+int_fast16_t ADCBuf_adjustRawValues(ADCBuf_Handle handle, void *sampleBuffer,
+                                    uint_fast16_t sampleCount,
+                                    uint32_t adcChannel)
+{
+    /* The model writes plain 12-bit codes */
+    (void)handle;
+    (void)sampleBuffer;
+    (void)sampleCount;
+    (void)adcChannel;
+    return ADCBuf_STATUS_SUCCESS;
+}
@@ -0,0 +1,386 @@
+/*
+ * sim_clock.c - Virtual clock, task scheduler and sleep/usleep/
+ * clock_gettime replacements
+ *
+ * Firmware tasks run on host threads, but only one at a time, as on
+ * the single-core target: the highest-priority ready task runs until
+ * it blocks (sleep, a driver call, a queue wait), and when every task
+ * is blocked the clock jumps to the earliest wake-up or interrupt,
+ * the MCU idling meanwhile as the sleep policy decides (sim_power.c).
+ * Interrupts run between task switches, ahead of any task. Task code takes
+ * no virtual time between blocking calls, so a run is deterministic.
+ *
+ * Defining sleep(), usleep() and clock_gettime() here overrides the C
+ * library versions for the simulator executable, so the unmodified
+ * firmware sleeps and reads CLOCK_MONOTONIC in virtual time. Other
+ * clocks still reach the kernel; host CPU time is sampled at every
+ * sleep boundary to measure the real work done per wake-up.
+ */
+
+#include "sim.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_MAX_TASKS   8
+#define SIM_MAX_IRQS    8
+#define SIM_STACK_FILL  0xA5        /* As tskSTACK_FILL_BYTE */
+
+typedef struct {
+    const char     *name;
+    int             priority;
+    void         *(*entry)(void *);
+    pthread_t       thread;
+    uint8_t        *stack;          /* Lowest address; grows down */
+    pthread_cond_t  cond;
+    bool            ready;
+    uint64_t        wake_us;        /* UINT64_MAX: until SimTask_wake() */
+} SimTask;
+
+typedef struct {
+    SimIrqFxn       fxn;
+    void           *arg;
+    uint64_t        due_us;         /* UINT64_MAX: not scheduled */
+} SimIrq;
+
+static uint64_t now_us;
+static uint64_t limit_us = UINT64_MAX;
+static void (*limit_fxn)(void);
+static SimClockStats_t stats;
+static uint64_t host_mark_ns;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;
+static SimTask tasks[SIM_MAX_TASKS];
+static int task_count;
+static int current = -1;
+static SimIrq irqs[SIM_MAX_IRQS];
+static int irq_count;
+static bool in_isr;
+
+static uint64_t host_cpu_ns(void)
+{
+    struct timespec ts;
+    syscall(SYS_clock_gettime, CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int self(void)
+{
+    pthread_t me = pthread_self();
+    for (int i = 0; i < task_count; i++) {
+        if (pthread_equal(tasks[i].thread, me)) return i;
+    }
+    fprintf(stderr, "sim: blocking call outside a task\n");
+    abort();
+}
+
+/* Run every interrupt due by now. Called with the lock held; handlers
+ * run without it, as only the dispatching thread is active. */
+static void run_irqs(void)
+{
+    for (int i = 0; i < irq_count; i++) {
+        if (irqs[i].due_us > now_us) continue;
+        irqs[i].due_us = UINT64_MAX;
+        stats.irqs++;
+        in_isr = true;
+        pthread_mutex_unlock(&lock);
+        irqs[i].fxn(irqs[i].arg);
+        pthread_mutex_lock(&lock);
+        in_isr = false;
+    }
+}
+
+/* Pick the next task to run, advancing the clock while none is ready.
+ * Called with the lock held; returns once `me` is running again. */
+static void dispatch(int me)
+{
+    for (;;) {
+        run_irqs();
+
+        int best = -1;
+        for (int i = 0; i < task_count; i++) {
+            if (tasks[i].ready && (best < 0 || tasks[i].priority > tasks[best].priority)) {
+                best = i;
+            }
+        }
+        if (best >= 0) {
+            current = best;
+            break;
+        }
+
+        uint64_t next = UINT64_MAX;
+        for (int i = 0; i < task_count; i++) {
+            if (tasks[i].wake_us < next) next = tasks[i].wake_us;
+        }
+        for (int i = 0; i < irq_count; i++) {
+            if (irqs[i].due_us < next) next = irqs[i].due_us;
+        }
+        if (next == UINT64_MAX) {
+            fprintf(stderr, "sim: all tasks blocked forever\n");
+            abort();
+        }
+        if (next >= limit_us) {
+            now_us = limit_us;
+            if (limit_fxn != NULL) limit_fxn();
+        }
+
+        /* The MCU idles until then: LPDS or WFI, per the sleep policy */
+        in_isr = true;
+        pthread_mutex_unlock(&lock);
+        uint64_t lpds_end = SimPower_sleep(next);
+        if (lpds_end != 0) {
+            now_us = lpds_end;
+            SimPower_wake();
+        }
+        pthread_mutex_lock(&lock);
+        in_isr = false;
+        now_us = next;
+        for (int i = 0; i < task_count; i++) {
+            if (tasks[i].wake_us <= now_us) {
+                tasks[i].ready = true;
+                tasks[i].wake_us = UINT64_MAX;
+            }
+        }
+    }
+
+    if (current != me) {
+        pthread_cond_signal(&tasks[current].cond);
+        while (current != me) pthread_cond_wait(&tasks[me].cond, &lock);
+    }
+}
+
+static void block_until(uint64_t wake_us)
+{
+    pthread_mutex_lock(&lock);
+    int me = self();
+    tasks[me].ready = false;
+    tasks[me].wake_us = wake_us;
+    dispatch(me);
+    pthread_mutex_unlock(&lock);
+}
+
+uint64_t SimClock_nowUs(void)
+{
+    return now_us;
+}
+
+void SimClock_busy(uint64_t us)
+{
+    stats.busy_us += us;
+    block_until(now_us + us);
+}
+
+void SimClock_idle(uint64_t us)
+{
+    /* Close the host CPU measurement for the work since the last wake */
+    uint64_t host_now = host_cpu_ns();
+    if (host_mark_ns != 0) {
+        uint64_t work = host_now - host_mark_ns;
+        stats.host_ns_total += work;
+        if (work > stats.host_ns_max) stats.host_ns_max = work;
+    }
+    stats.wakeups++;
+
+    stats.idle_us += us;
+    block_until(now_us + us);
+    host_mark_ns = host_cpu_ns();
+}
+
+void SimClock_setLimit(uint64_t end_us, void (*on_end)(void))
+{
+    limit_us = end_us;
+    limit_fxn = on_end;
+}
+
+void SimClock_getStats(SimClockStats_t *out)
+{
+    *out = stats;
+}
+
+/* ---- Tasks ---- */
+
+static void *task_start(void *arg)
+{
+    SimTask *t = arg;
+    int me = (int)(t - tasks);
+
+    pthread_mutex_lock(&lock);
+    while (current != me) pthread_cond_wait(&t->cond, &lock);
+    pthread_mutex_unlock(&lock);
+
+    t->entry(NULL);
+
+    /* Task returned: never run it again */
+    pthread_mutex_lock(&lock);
+    t->ready = false;
+    t->wake_us = UINT64_MAX;
+    dispatch(me);
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+void SimTask_create(const char *name, int priority, void *(*entry)(void *))
+{
+    pthread_mutex_lock(&lock);
+    if (task_count == SIM_MAX_TASKS) {
+        fprintf(stderr, "sim: too many tasks\n");
+        abort();
+    }
+    SimTask *t = &tasks[task_count];
+    t->name = name;
+    t->priority = priority;
+    t->entry = entry;
+    t->ready = true;
+    t->wake_us = UINT64_MAX;
+    pthread_cond_init(&t->cond, NULL);
+    void *stack;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (posix_memalign(&stack, 4096, SIM_TASK_STACK) != 0
+            || pthread_attr_setstack(&attr, stack, SIM_TASK_STACK) != 0) {
+        fprintf(stderr, "sim: cannot allocate stack for task %s\n", name);
+        abort();
+    }
+    t->stack = stack;
+    memset(t->stack, SIM_STACK_FILL, SIM_TASK_STACK);
+    if (pthread_create(&t->thread, &attr, task_start, t) != 0) {
+        fprintf(stderr, "sim: cannot create task %s\n", name);
+        abort();
+    }
+    pthread_attr_destroy(&attr);
+    task_count++;
+    pthread_mutex_unlock(&lock);
+}
+
+void SimTask_run(void)
+{
+    pthread_mutex_lock(&lock);
+    int best = 0;
+    for (int i = 1; i < task_count; i++) {
+        if (tasks[i].priority > tasks[best].priority) best = i;
+    }
+    current = best;
+    pthread_cond_signal(&tasks[best].cond);
+    for (;;) pthread_cond_wait(&idle_cond, &lock);     /* Runs end in exit() */
+}
+
+int SimTask_self(void)
+{
+    return self();
+}
+
+uint64_t SimTask_wait(uint64_t wake_us)
+{
+    block_until(wake_us);
+    return now_us;
+}
+
+void SimTask_wake(int task)
+{
+    if (in_isr) {
+        /* The scheduler picks the task once the handler returns */
+        tasks[task].ready = true;
+        tasks[task].wake_us = UINT64_MAX;
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    int me = self();
+    tasks[task].ready = true;
+    tasks[task].wake_us = UINT64_MAX;
+    /* Preempt in favour of a higher-priority task, as the RTOS would */
+    if (tasks[task].priority > tasks[me].priority) dispatch(me);
+    pthread_mutex_unlock(&lock);
+}
+
+size_t SimTask_stackFree(int task)
+{
+    const uint8_t *p = tasks[task].stack;
+    size_t n = 0;
+    while (n < SIM_TASK_STACK && p[n] == SIM_STACK_FILL) n++;
+    return n;
+}
+
+/* ---- Interrupts ---- */
+
+int SimIrq_create(SimIrqFxn fxn, void *arg)
+{
+    if (irq_count == SIM_MAX_IRQS) {
+        fprintf(stderr, "sim: too many interrupts\n");
+        abort();
+    }
+    irqs[irq_count].fxn = fxn;
+    irqs[irq_count].arg = arg;
+    irqs[irq_count].due_us = UINT64_MAX;
+    return irq_count++;
+}
+
+void SimIrq_schedule(int irq, uint64_t at_us)
+{
+    irqs[irq].due_us = at_us;
+}
+
+/* ---- Cortex-M registers ---- */
+
+#define SIM_DWT_CYCCNT  0xE0001004UL
+#define SIM_CPU_MHZ     80
+#define SIM_REGS        4
+
+static struct {
+    unsigned long addr;
+    unsigned long value;
+} regs[SIM_REGS];
+
+static uint64_t cycles_from_us;
+
+void SimReg_resetCycles(void)
+{
+    cycles_from_us = now_us;
+}
+
+/* CYCCNT counts virtual time at the CPU clock since power-on or the
+ * last LPDS exit, so profiling scopes measure the driver waits the
+ * simulation models, not host work */
+volatile unsigned long *SimReg(unsigned long addr)
+{
+    int i;
+    for (i = 0; i < SIM_REGS - 1; i++) {
+        if (regs[i].addr == addr || regs[i].addr == 0) break;
+    }
+    regs[i].addr = addr;
+    if (addr == SIM_DWT_CYCCNT) {
+        regs[i].value = (unsigned long)(uint32_t)((now_us - cycles_from_us) *
+                                                SIM_CPU_MHZ);
+    }
+    return &regs[i].value;
+}
+
+/* ---- libc overrides ---- */
+
+unsigned int sleep(unsigned int seconds)
+{
+    SimClock_idle((uint64_t)seconds * SIM_US_PER_SEC);
+    return 0;
+}
+
+int usleep(useconds_t usec)
+{
+    SimClock_idle(usec);
+    return 0;
+}
+
+int clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+    if (clk_id != CLOCK_MONOTONIC) {
+        return (int)syscall(SYS_clock_gettime, clk_id, tp);
+    }
+    tp->tv_sec = (time_t)(now_us / SIM_US_PER_SEC);
+    tp->tv_nsec = (long)(now_us % SIM_US_PER_SEC) * 1000;
+    return 0;
+}
@@ -0,0 +1,437 @@
+/*
+ * sim_devices.c - Simulated sensors
+ *
+ * Each model derives its reading from a deterministic indoor profile
+ * of virtual time (daily temperature/light cycle, occupancy-driven
+ * eCO2, optional CO event) and encodes it the way the real part does:
+ * the BME280 exposes a register file with datasheet calibration, the
+ * SGP30 answers measure_iaq with CRC-protected words and NACKs until
+ * conversion completes, the MQ-7 drives ADC codes and the microphone
+ * fills ADCBuf capture buffers.
+ */
+
+#include "sim.h"
+#include "Board.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DAY_S       86400.0
+
+static SimScenario_t scenario;
+
+static double seconds(uint64_t now_us)
+{
+    return (double)now_us / (double)SIM_US_PER_SEC;
+}
+
+/* Deterministic noise in [-1, 1) */
+static uint32_t rng_state = 0x12345678;
+
+static double noise(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (double)rng_state / 2147483648.0 - 1.0;
+}
+
+/* ---- Environment profile ---- */
+
+static double env_temperature(double t)
+{
+    return 21.0 + 1.5 * sin(2.0 * M_PI * (t / DAY_S - 0.3));
+}
+
+static double env_humidity(double t)
+{
+    return 45.0 - 5.0 * sin(2.0 * M_PI * (t / DAY_S - 0.3));
+}
+
+static double env_pressure_pa(double t)
+{
+    return 101325.0 + 150.0 * sin(2.0 * M_PI * t / (3.0 * DAY_S));
+}
+
+static double env_lux(double t)
+{
+    double l = 400.0 * sin(2.0 * M_PI * (t / DAY_S - 0.25));
+    return (l > 0.0) ? l : 0.0;
+}
+
+static double env_eco2(double t)
+{
+    return 400.0 + 300.0 * (1.0 + sin(2.0 * M_PI * (t / DAY_S - 0.5))) / 2.0;
+}
+
+/* Diurnal background plus 2 s of activity every 10 s, 10 dB louder
+ * up to 55 dB (where the mic model's peaks reach the ADC rails) */
+static double env_noise_db(double t)
+{
+    double db = 45.0 + 10.0 * sin(2.0 * M_PI * (t / DAY_S - 0.25));
+    if (fmod(t, 10.0) < 2.0) db = fmin(db + 10.0, 55.0);
+    return db;
+}
+
+double SimDevices_coPPM(uint64_t now_us)
+{
+    double ppm = scenario.co_baseline_ppm;
+    if (scenario.co_event_start_us == 0 || now_us < scenario.co_event_start_us) {
+        return ppm;
+    }
+
+    /* Trapezoid: ramp up, hold, ramp down */
+    double t = seconds(now_us - scenario.co_event_start_us);
+    double len = seconds(scenario.co_event_len_us);
+    double ramp = seconds(scenario.co_event_ramp_us);
+    double peak = scenario.co_event_peak_ppm - ppm;
+    if (t >= len)            return ppm;
+    if (ramp <= 0.0)         return ppm + peak;
+    if (t < ramp)            return ppm + peak * t / ramp;
+    if (t < len - ramp)      return ppm + peak;
+    return ppm + peak * (len - t) / ramp;
+}
+
+/* ---- BME280 ---- */
+
+static const struct {
+    uint16_t T1; int16_t T2, T3;
+    uint16_t P1; int16_t P2, P3, P4, P5, P6, P7, P8, P9;
+    uint8_t  H1, H3; int16_t H2, H4, H5; int8_t H6;
+} bme_cal = {
+    27504, 26435, -1000,
+    36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000,
+    75, 0, 362, 313, 50, 30,
+};
+
+static uint8_t bme_regs[256];
+static uint8_t bme_ptr;
+
+static int32_t bme_t_fine(int32_t adc_T)
+{
+    int32_t var1 = ((((adc_T >> 3) - ((int32_t)bme_cal.T1 << 1))) *
+                    ((int32_t)bme_cal.T2)) >> 11;
+    int32_t var2 = (((((adc_T >> 4) - ((int32_t)bme_cal.T1)) *
+                      ((adc_T >> 4) - ((int32_t)bme_cal.T1))) >> 12) *
+                    ((int32_t)bme_cal.T3)) >> 14;
+    return var1 + var2;
+}
+
+static double bme_pressure(int32_t t_fine, int32_t adc_P)
+{
+    int64_t var1 = ((int64_t)t_fine) - 128000;
+    int64_t var2 = var1 * var1 * (int64_t)bme_cal.P6;
+    var2 = var2 + ((var1 * (int64_t)bme_cal.P5) << 17);
+    var2 = var2 + (((int64_t)bme_cal.P4) << 35);
+    var1 = ((var1 * var1 * (int64_t)bme_cal.P3) >> 8) +
+           ((var1 * (int64_t)bme_cal.P2) << 12);
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)bme_cal.P1) >> 33;
+    if (var1 == 0) return 0;
+    int64_t p = 1048576 - adc_P;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)bme_cal.P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)bme_cal.P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)bme_cal.P7) << 4);
+    return (double)p / 256.0;
+}
+
+static double bme_humidity(int32_t t_fine, int32_t adc_H)
+{
+    int32_t v = t_fine - 76800;
+    v = (((((adc_H << 14) - (((int32_t)bme_cal.H4) << 20) -
+            (((int32_t)bme_cal.H5) * v)) + 16384) >> 15) *
+         (((((((v * ((int32_t)bme_cal.H6)) >> 10) *
+              (((v * ((int32_t)bme_cal.H3)) >> 11) + 32768)) >> 10) +
+            2097152) * ((int32_t)bme_cal.H2) + 8192) >> 14));
+    v = v - (((((v >> 15) * (v >> 15)) >> 7) * ((int32_t)bme_cal.H1)) >> 4);
+    v = (v < 0) ? 0 : v;
+    v = (v > 419430400) ? 419430400 : v;
+    return (double)(v >> 12) / 1024.0;
+}
+
+/* Invert the datasheet compensation by bisection (all three are monotonic) */
+static void bme_encode(double temp, double hum, double press_pa,
+                       int32_t *adc_T, int32_t *adc_P, int32_t *adc_H)
+{
+    int32_t lo = 0, hi = (1 << 20) - 1;
+    while (lo < hi) {
+        int32_t mid = (lo + hi) / 2;
+        if ((bme_t_fine(mid) * 5 + 128) / 25600.0 < temp) lo = mid + 1; else hi = mid;
+    }
+    *adc_T = lo;
+    int32_t t_fine = bme_t_fine(lo);
+
+    lo = 0; hi = (1 << 20) - 1;
+    while (lo < hi) {          /* Pressure falls as adc_P rises */
+        int32_t mid = (lo + hi) / 2;
+        if (bme_pressure(t_fine, mid) > press_pa) lo = mid + 1; else hi = mid;
+    }
+    *adc_P = lo;
+
+    lo = 0; hi = 0xFFFF;
+    while (lo < hi) {
+        int32_t mid = (lo + hi) / 2;
+        if (bme_humidity(t_fine, mid) < hum) lo = mid + 1; else hi = mid;
+    }
+    *adc_H = lo;
+}
+
+static void put16le(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void bme_load_calibration(void)
+{
+    uint8_t *r = bme_regs;
+    put16le(&r[0x88], bme_cal.T1);
+    put16le(&r[0x8A], (uint16_t)bme_cal.T2);
+    put16le(&r[0x8C], (uint16_t)bme_cal.T3);
+    put16le(&r[0x8E], bme_cal.P1);
+    put16le(&r[0x90], (uint16_t)bme_cal.P2);
+    put16le(&r[0x92], (uint16_t)bme_cal.P3);
+    put16le(&r[0x94], (uint16_t)bme_cal.P4);
+    put16le(&r[0x96], (uint16_t)bme_cal.P5);
+    put16le(&r[0x98], (uint16_t)bme_cal.P6);
+    put16le(&r[0x9A], (uint16_t)bme_cal.P7);
+    put16le(&r[0x9C], (uint16_t)bme_cal.P8);
+    put16le(&r[0x9E], (uint16_t)bme_cal.P9);
+    r[0xA1] = bme_cal.H1;
+    put16le(&r[0xE1], (uint16_t)bme_cal.H2);
+    r[0xE3] = bme_cal.H3;
+    r[0xE4] = (uint8_t)(bme_cal.H4 >> 4);
+    r[0xE5] = (uint8_t)((bme_cal.H4 & 0x0F) | ((bme_cal.H5 & 0x0F) << 4));
+    r[0xE6] = (uint8_t)(bme_cal.H5 >> 4);
+    r[0xE7] = (uint8_t)bme_cal.H6;
+    r[0xD0] = 0x60;
+}
+
+static void bme_update_data(uint64_t now_us)
+{
+    double t = seconds(now_us);
+    int32_t adc_T, adc_P, adc_H;
+    bme_encode(env_temperature(t), env_humidity(t), env_pressure_pa(t),
+               &adc_T, &adc_P, &adc_H);
+    uint8_t *r = &bme_regs[0xF7];
+    r[0] = (uint8_t)(adc_P >> 12);
+    r[1] = (uint8_t)(adc_P >> 4);
+    r[2] = (uint8_t)(adc_P << 4);
+    r[3] = (uint8_t)(adc_T >> 12);
+    r[4] = (uint8_t)(adc_T >> 4);
+    r[5] = (uint8_t)(adc_T << 4);
+    r[6] = (uint8_t)(adc_H >> 8);
+    r[7] = (uint8_t)adc_H;
+}
+
+static bool bme_write(SimI2CDevice *dev, const uint8_t *buf, size_t len)
+{
+    (void)dev;
+    bme_ptr = buf[0];
+    for (size_t i = 1; i < len; i++) {
+        bme_regs[(uint8_t)(bme_ptr + i - 1)] = buf[i];
+    }
+    return true;
+}
+
+static bool bme_read(SimI2CDevice *dev, uint8_t *buf, size_t len)
+{
+    (void)dev;
+    if (bme_ptr == 0xF7) bme_update_data(SimClock_nowUs());
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = bme_regs[(uint8_t)(bme_ptr + i)];
+    }
+    return true;
+}
+
+static SimI2CDevice bme280 = { "BME280", BME280_I2C_ADDR, bme_write, bme_read };
+
+/* ---- SGP30 ---- */
+
+#define SGP30_MEASURE_US    12000
+#define SGP30_WARMUP_US     (15 * SIM_US_PER_SEC)
+
+static uint64_t sgp_init_us = UINT64_MAX;
+static uint64_t sgp_ready_us = UINT64_MAX;
+static uint64_t sgp_last_measure_us = UINT64_MAX;
+static SimDeviceStats_t dev_stats;
+
+static uint8_t sgp_crc(const uint8_t *data, int len)
+{
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static bool sgp_write(SimI2CDevice *dev, const uint8_t *buf, size_t len)
+{
+    (void)dev;
+    if (len != 2) return false;
+    uint16_t cmd = (uint16_t)(buf[0] << 8 | buf[1]);
+    uint64_t now = SimClock_nowUs();
+    if (cmd == 0x2003) {
+        sgp_init_us = now;
+    } else if (cmd == 0x2008) {
+        /* The baseline algorithm expects measure_iaq every second */
+        if (sgp_last_measure_us != UINT64_MAX &&
+            now - sgp_last_measure_us > dev_stats.sgp30_max_gap_us) {
+            dev_stats.sgp30_max_gap_us = now - sgp_last_measure_us;
+        }
+        sgp_last_measure_us = now;
+        sgp_ready_us = now + SGP30_MEASURE_US;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool sgp_read(SimI2CDevice *dev, uint8_t *buf, size_t len)
+{
+    (void)dev;
+    uint64_t now = SimClock_nowUs();
+    if (len != 6 || now < sgp_ready_us) return false;  /* NACK while measuring */
+    sgp_ready_us = UINT64_MAX;
+
+    uint16_t eco2 = 400, tvoc = 0;
+    if (sgp_init_us != UINT64_MAX && now - sgp_init_us >= SGP30_WARMUP_US) {
+        double e = env_eco2(seconds(now)) + 5.0 * noise();
+        eco2 = (uint16_t)e;
+        tvoc = (uint16_t)((e - 400.0) / 3.0 > 0.0 ? (e - 400.0) / 3.0 : 0.0);
+    }
+    buf[0] = (uint8_t)(eco2 >> 8);
+    buf[1] = (uint8_t)eco2;
+    buf[2] = sgp_crc(&buf[0], 2);
+    buf[3] = (uint8_t)(tvoc >> 8);
+    buf[4] = (uint8_t)tvoc;
+    buf[5] = sgp_crc(&buf[3], 2);
+    return true;
+}
+
+static SimI2CDevice sgp30 = { "SGP30", SGP30_I2C_ADDR, sgp_write, sgp_read };
+
+/* ---- BH1750 ---- */
+
+#define BH1750_HRES_US      120000
+
+static bool     bh_powered;
+static uint64_t bh_first_result_us = UINT64_MAX;
+
+static bool bh_write(SimI2CDevice *dev, const uint8_t *buf, size_t len)
+{
+    (void)dev;
+    if (len != 1) return false;
+    if (buf[0] == 0x01) {
+        bh_powered = true;
+    } else if (buf[0] == 0x10 && bh_powered) {
+        bh_first_result_us = SimClock_nowUs() + BH1750_HRES_US;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool bh_read(SimI2CDevice *dev, uint8_t *buf, size_t len)
+{
+    (void)dev;
+    if (len != 2) return false;
+    uint16_t raw = 0;
+    if (SimClock_nowUs() >= bh_first_result_us) {
+        raw = (uint16_t)(env_lux(seconds(SimClock_nowUs())) * 1.2);
+    }
+    buf[0] = (uint8_t)(raw >> 8);
+    buf[1] = (uint8_t)raw;
+    return true;
+}
+
+static SimI2CDevice bh1750 = { "BH1750", BH1750_I2C_ADDR, bh_write, bh_read };
+
+/* ---- MQ-7 (inverse of the driver's Rs/R0 power curve) ---- */
+
+static uint16_t mq7_sample(uint_least8_t index, uint64_t now_us)
+{
+    (void)index;
+    double ppm = SimDevices_coPPM(now_us);
+    if (ppm < 0.01) ppm = 0.01;
+    double ratio = pow(ppm / 98.322, -1.0 / 1.458);
+    double rs = ratio * 10000.0;
+    double v_sensor = 5.0 * 10000.0 / (10000.0 + rs);
+    double v_adc = v_sensor * (10.0 / 36.0);
+    double code = v_adc / 1.4 * 4095.0 + 0.5 * noise();
+    return (uint16_t)(code < 0.0 ? 0.0 : code);
+}
+
+/* ---- MEMS microphone: 440 Hz tone plus broadband noise ---- */
+
+/* Sampled every 16 us, a 440 Hz tone repeats exactly every 3125
+ * samples (22 cycles), so tone and noise come from tables and a
+ * buffer costs one multiply-add per sample rather than libm calls. */
+#define MIC_PERIOD_US   16
+#define MIC_TONE_LEN    3125
+#define MIC_NOISE_LEN   8192
+#define MIC_FILL_MAX    1024        /* Longest buffer the tables cover */
+
+static float mic_tone[MIC_TONE_LEN + MIC_FILL_MAX];
+static float mic_noise[MIC_NOISE_LEN + MIC_FILL_MAX];
+
+static void mic_tables(void)
+{
+    for (int i = 0; i < MIC_TONE_LEN + MIC_FILL_MAX; i++) {
+        mic_tone[i] = (float)sin(2.0 * M_PI * 440.0 * i * MIC_PERIOD_US / SIM_US_PER_SEC);
+    }
+    for (int i = 0; i < MIC_NOISE_LEN + MIC_FILL_MAX; i++) {
+        mic_noise[i] = (float)noise();
+    }
+}
+
+static void mic_fill(uint_least8_t channel, uint64_t start_us,
+                     uint32_t period_us, uint16_t *codes, size_t n)
+{
+    (void)channel;
+    if (period_us != MIC_PERIOD_US || n > MIC_FILL_MAX) {
+        fprintf(stderr, "sim: unsupported mic capture\n");
+        abort();
+    }
+
+    /* Level is held over a buffer; noise starts at a random offset */
+    double vrms = 0.00631 * pow(10.0, (env_noise_db(seconds(start_us)) - 20.0) / 20.0);
+    const float *tone = &mic_tone[(start_us / MIC_PERIOD_US) % MIC_TONE_LEN];
+    const float *hiss = &mic_noise[(uint32_t)((noise() + 1.0) / 2.0 * MIC_NOISE_LEN)];
+    float mid = (float)(0.7 / 1.4 * 4095.0);
+    float a_tone = (float)(1.2 * vrms / 1.4 * 4095.0);
+    float a_hiss = (float)(0.6 * vrms / 1.4 * 4095.0);
+
+    for (size_t i = 0; i < n; i++) {
+        float code = mid + a_tone * tone[i] + a_hiss * hiss[i];
+        code = code < 0.0f ? 0.0f : code;
+        code = code > 4095.0f ? 4095.0f : code;
+        codes[i] = (uint16_t)(int32_t)code;
+    }
+}
+
+void SimDevices_getStats(SimDeviceStats_t *out)
+{
+    *out = dev_stats;
+}
+
+void SimDevices_attach(const SimScenario_t *sc)
+{
+    scenario = *sc;
+    bme_load_calibration();
+    mic_tables();
+    SimI2C_attach(&bme280);
+    SimI2C_attach(&sgp30);
+    SimI2C_attach(&bh1750);
+    SimADC_attach(Board_ADC_CH2, mq7_sample);
+    SimADCBuf_attach(Board_ADCBUF0_MIC, mic_fill);
+}
@@ -0,0 +1,114 @@
+/*
+ * sim_dpl.c - TI driver porting layer clocks and semaphores on the
+ * sim scheduler
+ *
+ * Each ClockP instance is a simulated interrupt, so its function runs
+ * ahead of every task at the virtual time it expires. SemaphoreP is
+ * binary, with one waiting task at a time.
+ */
+
+#include <ti/drivers/dpl/ClockP.h>
+#include <ti/drivers/dpl/SemaphoreP.h>
+
+#include "sim.h"
+
+#include <stdlib.h>
+
+#define SIM_TICK_US     1000
+
+typedef struct {
+    ClockP_Fxn fxn;
+    uintptr_t  arg;
+    uint32_t   timeout;         /* Ticks from ClockP_start() */
+    int        irq;
+} SimClockP;
+
+typedef struct {
+    unsigned int count;
+    int          waiter;        /* Blocked task, or -1 */
+} SimSemaphoreP;
+
+static void clock_fire(void *arg)
+{
+    SimClockP *c = arg;
+    c->fxn(c->arg);
+}
+
+void ClockP_Params_init(ClockP_Params *params)
+{
+    params->startFlag = false;
+    params->period = 0;
+    params->arg = 0;
+}
+
+ClockP_Handle ClockP_create(ClockP_Fxn clockFxn, uint32_t timeout,
+                            ClockP_Params *params)
+{
+    SimClockP *c = calloc(1, sizeof(*c));
+    if (c == NULL) return NULL;
+    c->fxn = clockFxn;
+    c->arg = (params != NULL) ? params->arg : 0;
+    c->timeout = timeout;
+    c->irq = SimIrq_create(clock_fire, c);
+    if (params != NULL && params->startFlag) ClockP_start(c);
+    return c;
+}
+
+void ClockP_setTimeout(ClockP_Handle handle, uint32_t timeout)
+{
+    ((SimClockP *)handle)->timeout = timeout;
+}
+
+void ClockP_start(ClockP_Handle handle)
+{
+    SimClockP *c = handle;
+    SimIrq_schedule(c->irq, SimClock_nowUs() + (uint64_t)c->timeout * SIM_TICK_US);
+}
+
+void ClockP_stop(ClockP_Handle handle)
+{
+    SimIrq_schedule(((SimClockP *)handle)->irq, UINT64_MAX);
+}
+
+uint32_t ClockP_getSystemTicks(void)
+{
+    return (uint32_t)(SimClock_nowUs() / SIM_TICK_US);
+}
+
+uint32_t ClockP_getSystemTickPeriod(void)
+{
+    return SIM_TICK_US;
+}
+
+SemaphoreP_Handle SemaphoreP_createBinary(unsigned int count)
+{
+    SimSemaphoreP *s = calloc(1, sizeof(*s));
+    if (s == NULL) return NULL;
+    s->count = count ? 1 : 0;
+    s->waiter = -1;
+    return s;
+}
+
+SemaphoreP_Status SemaphoreP_pend(SemaphoreP_Handle handle, uint32_t timeout)
+{
+    SimSemaphoreP *s = handle;
+    uint64_t deadline = (timeout == SemaphoreP_WAIT_FOREVER)
+                        ? UINT64_MAX
+                        : SimClock_nowUs() + (uint64_t)timeout * SIM_TICK_US;
+
+    while (s->count == 0) {
+        if (SimClock_nowUs() >= deadline) return SemaphoreP_TIMEOUT;
+        s->waiter = SimTask_self();
+        SimTask_wait(deadline);
+        s->waiter = -1;
+    }
+    s->count = 0;
+    return SemaphoreP_OK;
+}
+
+void SemaphoreP_post(SemaphoreP_Handle handle)
+{
+    SimSemaphoreP *s = handle;
+    s->count = 1;
+    if (s->waiter >= 0) SimTask_wake(s->waiter);
+}
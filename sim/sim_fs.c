@@ -0,0 +1,296 @@
+/*
+ * sim_fs.c - Simulated SimpleLink serial flash file system
+ *
+ * Files live in memory. As on the NWP, a file opened for writing is
+ * committed only by sl_FsClose (an "A" signature aborts it), and each
+ * file occupies whole 4 KB blocks of its declared maximum size. The
+ * image can be saved and reloaded to carry files across a simulated
+ * reset. NWP system files (SYS_PREFIX) are kept in the image too, but
+ * are left out of the usage figures. The serial flash is reached
+ * through the NWP, so opening or deleting a file fails while it is
+ * stopped.
+ */
+
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#include "sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FS_MAX_FILES        64
+#define FS_MAX_HANDLES      4
+#define FS_NAME_MAX         64
+#define FS_BLOCK            4096
+#define SYS_PREFIX          "/sys/"
+
+#define FS_OPEN_US          1000        /* Open/close command round trip */
+#define FS_COMMIT_US        25000       /* Erase + program on close */
+#define FS_DELETE_US        10000
+#define FS_XFER_US_PER_KB   500         /* SPI transfer to/from the NWP */
+
+typedef struct {
+    bool     used;
+    char     name[FS_NAME_MAX];
+    uint32_t max_size;
+    uint32_t size;
+    uint8_t *data;
+} SimFile;
+
+typedef struct {
+    bool     open;
+    bool     writing;
+    SimFile *file;          /* Committed file (reads) */
+    char     name[FS_NAME_MAX];
+    uint32_t max_size;
+    uint32_t size;
+    uint8_t *data;          /* Uncommitted contents (writes) */
+} SimHandle;
+
+static SimFile files[FS_MAX_FILES];
+static SimHandle handles[FS_MAX_HANDLES];
+static SimFsStats_t stats;
+
+static SimFile *find(const uint8_t *name)
+{
+    for (int i = 0; i < FS_MAX_FILES; i++) {
+        if (files[i].used && strcmp(files[i].name, (const char *)name) == 0) {
+            return &files[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t blocks(uint32_t size)
+{
+    return (size + FS_BLOCK - 1) / FS_BLOCK;
+}
+
+static bool is_system(const SimFile *f)
+{
+    return strncmp(f->name, SYS_PREFIX, strlen(SYS_PREFIX)) == 0;
+}
+
+static void update_usage(void)
+{
+    uint32_t n = 0, b = 0;
+    for (int i = 0; i < FS_MAX_FILES; i++) {
+        if (files[i].used && !is_system(&files[i])) {
+            n++;
+            b += blocks(files[i].max_size);
+        }
+    }
+    stats.files = n;
+    stats.blocks = b;
+    if (n > stats.peak_files) stats.peak_files = n;
+    if (b > stats.peak_blocks) stats.peak_blocks = b;
+}
+
+static void xfer(uint32_t len)
+{
+    SimClock_busy(FS_XFER_US_PER_KB * (uint64_t)len / 1024 + 100);
+}
+
+static void remove_file(SimFile *f)
+{
+    free(f->data);
+    memset(f, 0, sizeof(*f));
+}
+
+int32_t sl_FsOpen(const uint8_t *pFileName, const uint32_t AccessModeAndMaxSize,
+                  uint32_t *pToken)
+{
+    (void)pToken;
+    if (!SimNet_nwpStarted()) return SL_RET_CODE_DEV_NOT_STARTED;
+    SimClock_busy(FS_OPEN_US);
+    if (strlen((const char *)pFileName) >= FS_NAME_MAX) return -1;
+
+    int h = 0;
+    while (h < FS_MAX_HANDLES && handles[h].open) h++;
+    if (h == FS_MAX_HANDLES) return -1;
+
+    SimHandle *hd = &handles[h];
+    SimFile *f = find(pFileName);
+    memset(hd, 0, sizeof(*hd));
+
+    if (AccessModeAndMaxSize & (SL_FS_WRITE | SL_FS_CREATE)) {
+        uint32_t max = (AccessModeAndMaxSize & 0xFFFF) * 256;
+        if (f != NULL && !(AccessModeAndMaxSize & SL_FS_OVERWRITE) &&
+            (AccessModeAndMaxSize & SL_FS_CREATE)) {
+            return -1;
+        }
+        if (f == NULL && !(AccessModeAndMaxSize & SL_FS_CREATE)) {
+            return SL_ERROR_FS_FILE_NOT_EXISTS;
+        }
+        if (f != NULL && max == 0) max = f->max_size;
+        hd->writing = true;
+        hd->max_size = max;
+        hd->data = calloc(1, max ? max : 1);
+        strcpy(hd->name, (const char *)pFileName);
+    } else {
+        if (f == NULL) return SL_ERROR_FS_FILE_NOT_EXISTS;
+        hd->file = f;
+    }
+    hd->open = true;
+    return h;
+}
+
+int16_t sl_FsClose(const int32_t FileHdl, const uint8_t *pCeritificateFileName,
+                   const uint8_t *pSignature, const uint32_t SignatureLen)
+{
+    (void)pCeritificateFileName;
+    if (FileHdl < 0 || FileHdl >= FS_MAX_HANDLES || !handles[FileHdl].open) {
+        return -1;
+    }
+    SimHandle *hd = &handles[FileHdl];
+    hd->open = false;
+    SimClock_busy(FS_OPEN_US);
+    if (!hd->writing) return 0;
+
+    if (pSignature != NULL && SignatureLen == 1 && pSignature[0] == 'A') {
+        free(hd->data);
+        stats.aborts++;
+        return 0;
+    }
+
+    SimFile *f = find((const uint8_t *)hd->name);
+    if (f == NULL) {
+        for (int i = 0; i < FS_MAX_FILES && f == NULL; i++) {
+            if (!files[i].used) f = &files[i];
+        }
+        if (f == NULL) {
+            free(hd->data);
+            return -1;
+        }
+    } else {
+        free(f->data);
+    }
+    f->used = true;
+    strcpy(f->name, hd->name);
+    f->max_size = hd->max_size;
+    f->size = hd->size;
+    f->data = hd->data;
+
+    SimClock_busy(FS_COMMIT_US);
+    stats.commits++;
+    stats.blocks_programmed += blocks(f->max_size);
+    update_usage();
+    return 0;
+}
+
+int32_t sl_FsRead(const int32_t FileHdl, uint32_t Offset, uint8_t *pData,
+                  uint32_t Len)
+{
+    if (FileHdl < 0 || FileHdl >= FS_MAX_HANDLES || !handles[FileHdl].open ||
+        handles[FileHdl].writing) {
+        return -1;
+    }
+    SimFile *f = handles[FileHdl].file;
+    if (Offset >= f->size) return 0;
+    if (Len > f->size - Offset) Len = f->size - Offset;
+    memcpy(pData, f->data + Offset, Len);
+    xfer(Len);
+    stats.bytes_read += Len;
+    return (int32_t)Len;
+}
+
+int32_t sl_FsWrite(const int32_t FileHdl, uint32_t Offset, uint8_t *pData,
+                   uint32_t Len)
+{
+    if (FileHdl < 0 || FileHdl >= FS_MAX_HANDLES || !handles[FileHdl].open ||
+        !handles[FileHdl].writing) {
+        return -1;
+    }
+    SimHandle *hd = &handles[FileHdl];
+    if (Offset > hd->max_size || Len > hd->max_size - Offset) return -1;
+    memcpy(hd->data + Offset, pData, Len);
+    if (Offset + Len > hd->size) hd->size = Offset + Len;
+    xfer(Len);
+    stats.bytes_written += Len;
+    return (int32_t)Len;
+}
+
+int16_t sl_FsDel(const uint8_t *pFileName, const uint32_t Token)
+{
+    (void)Token;
+    if (!SimNet_nwpStarted()) return SL_RET_CODE_DEV_NOT_STARTED;
+    SimFile *f = find(pFileName);
+    if (f == NULL) return SL_ERROR_FS_FILE_NOT_EXISTS;
+    remove_file(f);
+    SimClock_busy(FS_DELETE_US);
+    stats.deletes++;
+    update_usage();
+    return 0;
+}
+
+bool SimFs_getSystem(const char *name, void *buf, size_t len)
+{
+    SimFile *f = find((const uint8_t *)name);
+    if (f == NULL || f->size != len) return false;
+    memcpy(buf, f->data, len);
+    return true;
+}
+
+void SimFs_putSystem(const char *name, const void *buf, size_t len)
+{
+    SimFile *f = find((const uint8_t *)name);
+    for (int i = 0; i < FS_MAX_FILES && f == NULL; i++) {
+        if (!files[i].used) f = &files[i];
+    }
+    if (f == NULL) return;
+    free(f->data);
+    f->used = true;
+    snprintf(f->name, sizeof(f->name), "%s", name);
+    f->max_size = (uint32_t)len;
+    f->size = (uint32_t)len;
+    f->data = malloc(len ? len : 1);
+    memcpy(f->data, buf, len);
+}
+
+void SimFs_getStats(SimFsStats_t *out)
+{
+    *out = stats;
+}
+
+/* Image format: per file, name\n max_size size\n then size raw bytes */
+bool SimFs_load(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) return false;
+
+    char name[FS_NAME_MAX];
+    unsigned max_size, size;
+    int i = 0;
+    while (i < FS_MAX_FILES && fscanf(fp, "%63s %u %u", name, &max_size, &size) == 3 &&
+           fgetc(fp) == '\n' && size <= max_size) {
+        SimFile *f = &files[i++];
+        f->used = true;
+        strcpy(f->name, name);
+        f->max_size = max_size;
+        f->size = size;
+        f->data = calloc(1, max_size ? max_size : 1);
+        if (fread(f->data, 1, size, fp) != size) {
+            remove_file(f);
+            break;
+        }
+    }
+    fclose(fp);
+    update_usage();
+    stats.peak_files = stats.files;
+    stats.peak_blocks = stats.blocks;
+    return true;
+}
+
+bool SimFs_save(const char *path)
+{
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) return false;
+    for (int i = 0; i < FS_MAX_FILES; i++) {
+        SimFile *f = &files[i];
+        if (!f->used) continue;
+        fprintf(fp, "%s %u %u\n", f->name, f->max_size, f->size);
+        fwrite(f->data, 1, f->size, fp);
+    }
+    return fclose(fp) == 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * sim_gpio.c - Simulated GPIO outputs
+ */
+
+#include <ti/drivers/GPIO.h>
+
+#include "sim.h"
+
+#define SIM_GPIO_PINS   8
+
+static unsigned int levels[SIM_GPIO_PINS];
+static SimGPIOWatchFxn watcher;
+
+void SimGPIO_watch(SimGPIOWatchFxn fxn)
+{
+    watcher = fxn;
+}
+
+void GPIO_init(void)
+{
+}
+
+int_fast16_t GPIO_setConfig(uint_least8_t index, GPIO_PinConfig pinConfig)
+{
+    if (index >= SIM_GPIO_PINS) return -1;
+    levels[index] = (pinConfig & GPIO_CFG_OUT_HIGH) ? 1 : 0;
+    return 0;
+}
+
+void GPIO_write(uint_least8_t index, unsigned int value)
+{
+    if (index >= SIM_GPIO_PINS) return;
+    value = value ? 1 : 0;
+    if (levels[index] != value && watcher != NULL) {
+        watcher(index, value, SimClock_nowUs());
+    }
+    levels[index] = value;
+}
+
+unsigned int GPIO_read(uint_least8_t index)
+{
+    return (index < SIM_GPIO_PINS) ? levels[index] : 0;
+}
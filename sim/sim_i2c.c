@@ -0,0 +1,171 @@
+/*
+ * sim_i2c.c - Simulated I2C controller
+ *
+ * Routes I2C_transfer() to the device registered at the target
+ * address. Each transfer takes the time the bytes would occupy the
+ * bus (9 clocks per byte incl. ACK, plus the address byte of each
+ * phase). In blocking mode the caller waits that long; in callback
+ * mode I2C_transfer() returns at once and the device I/O and the
+ * callback happen in a simulated interrupt when the transfer ends.
+ * I2C_cancel() brings that interrupt forward and fails the transfer;
+ * I2C_close() drops it.
+ * The MCU stays out of LPDS while a transfer is on the bus.
+ */
+
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/power/PowerCC32XX.h>
+
+#include "sim.h"
+
+struct I2C_Config_ {
+    I2C_Params       params;
+    bool             open;
+    I2C_Transaction *active;        /* Callback-mode transfer on the bus */
+    bool             cancelled;
+    int              irq;
+};
+
+static struct I2C_Config_ i2c_instance = { .irq = -1 };
+static SimI2CDevice *devices;
+
+void SimI2C_attach(SimI2CDevice *dev)
+{
+    dev->next = devices;
+    devices = dev;
+}
+
+SimI2CDevice *SimI2C_devices(void)
+{
+    return devices;
+}
+
+static SimI2CDevice *find_device(uint8_t addr)
+{
+    for (SimI2CDevice *d = devices; d != NULL; d = d->next) {
+        if (d->addr == addr) return d;
+    }
+    return NULL;
+}
+
+static uint32_t bus_hz(const I2C_Params *p)
+{
+    switch (p->bitRate) {
+    case I2C_400kHz:  return 400000;
+    case I2C_1000kHz: return 1000000;
+    default:          return 100000;
+    }
+}
+
+static uint64_t transfer_us(I2C_Handle handle, const I2C_Transaction *txn)
+{
+    uint32_t bytes = 0;
+    if (txn->writeCount > 0) bytes += 1 + (uint32_t)txn->writeCount;
+    if (txn->readCount > 0)  bytes += 1 + (uint32_t)txn->readCount;
+    return (uint64_t)bytes * 9 * SIM_US_PER_SEC / bus_hz(&handle->params);
+}
+
+/* Device I/O for one transfer, at the time it completes */
+static bool run_transfer(I2C_Transaction *txn)
+{
+    SimI2CDevice *dev = find_device(txn->targetAddress);
+    bool ok = (dev != NULL);
+
+    if (ok && txn->writeCount > 0) {
+        ok = dev->write(dev, (const uint8_t *)txn->writeBuf, txn->writeCount);
+    }
+    if (ok && txn->readCount > 0) {
+        ok = dev->read(dev, (uint8_t *)txn->readBuf, txn->readCount);
+    }
+
+    if (dev != NULL) {
+        dev->transfers++;
+        if (!ok) dev->errors++;
+    }
+    txn->status = ok ? I2C_STATUS_SUCCESS : I2C_STATUS_ADDR_NACK;
+    return ok;
+}
+
+static void transfer_irq(void *arg)
+{
+    I2C_Handle h = arg;
+    I2C_Transaction *txn = h->active;
+    bool ok = false;
+    if (h->cancelled) {
+        txn->status = I2C_STATUS_CANCEL;
+    } else {
+        ok = run_transfer(txn);
+    }
+    h->active = NULL;
+    h->cancelled = false;
+    Power_releaseConstraint(PowerCC32XX_DISALLOW_LPDS);
+    h->params.transferCallbackFxn(h, txn, ok);
+}
+
+void I2C_init(void)
+{
+}
+
+void I2C_Params_init(I2C_Params *params)
+{
+    params->transferMode = I2C_MODE_BLOCKING;
+    params->transferCallbackFxn = NULL;
+    params->bitRate = I2C_100kHz;
+    params->custom = NULL;
+}
+
+I2C_Handle I2C_open(uint_least8_t index, I2C_Params *params)
+{
+    if (index != 0 || i2c_instance.open) return NULL;
+
+    if (params != NULL) {
+        i2c_instance.params = *params;
+    } else {
+        I2C_Params_init(&i2c_instance.params);
+    }
+    if (i2c_instance.params.transferMode == I2C_MODE_CALLBACK) {
+        if (i2c_instance.params.transferCallbackFxn == NULL) return NULL;
+        if (i2c_instance.irq < 0) {
+            i2c_instance.irq = SimIrq_create(transfer_irq, &i2c_instance);
+        }
+    }
+    i2c_instance.open = true;
+    return &i2c_instance;
+}
+
+void I2C_close(I2C_Handle handle)
+{
+    /* A transfer still on the bus is dropped without a callback */
+    if (handle->active != NULL) {
+        SimIrq_schedule(handle->irq, UINT64_MAX);
+        handle->active = NULL;
+        handle->cancelled = false;
+        Power_releaseConstraint(PowerCC32XX_DISALLOW_LPDS);
+    }
+    handle->open = false;
+}
+
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *txn)
+{
+    if (handle->params.transferMode == I2C_MODE_CALLBACK) {
+        /* One transfer at a time, as the driver does without a queue
+         * of chained transactions */
+        if (handle->active != NULL) return false;
+        handle->active = txn;
+        txn->status = I2C_STATUS_INCOMPLETE;
+        Power_setConstraint(PowerCC32XX_DISALLOW_LPDS);
+        SimIrq_schedule(handle->irq, SimClock_nowUs() + transfer_us(handle, txn));
+        return true;
+    }
+
+    Power_setConstraint(PowerCC32XX_DISALLOW_LPDS);
+    SimClock_busy(transfer_us(handle, txn));
+    Power_releaseConstraint(PowerCC32XX_DISALLOW_LPDS);
+    return run_transfer(txn);
+}
+
+void I2C_cancel(I2C_Handle handle)
+{
+    if (handle->active == NULL || handle->cancelled) return;
+    handle->cancelled = true;
+    SimIrq_schedule(handle->irq, SimClock_nowUs());
+}
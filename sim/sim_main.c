@@ -0,0 +1,449 @@
+/*
+ * sim_main.c - Entry point for the host-native simulation build
+ *
+ * Attaches the simulated devices, runs the firmware tasks from
+ * app_tasks.h in virtual time, as main_freertos.c would on the target,
+ * and prints a report when the requested duration has elapsed:
+ *
+ *   env_monitor_sim [-d DURATION] [-c START,PEAK_PPM[,LEN[,RAMP]]]
+ *                   [-o START,LEN] [-w START,LEN] [-f FLASH_IMAGE] [-v]
+ *
+ * Durations accept an s/m/h/d suffix (default seconds), e.g.
+ * "-d 7d -c 30h,150 -o 2d,20m" simulates a week with a CO event at
+ * 30 h peaking at 150 ppm and a 20-minute broker outage at 48 h.
+ * -w is an access point outage instead: the Wi-Fi link itself drops.
+ * CO events last an hour and ramp over 10 minutes by default; a RAMP
+ * of 0 gives a step, the worst case for alarm latency.
+ * -f loads the serial flash contents from FLASH_IMAGE (if it exists)
+ * and saves them back at the end, so a second run acts as a reset.
+ */
+
+#include "sim.h"
+#include "config.h"
+#include "Board.h"
+#include "app_tasks.h"
+#include "boot_time.h"
+#include "co_alarm.h"
+#include "energy.h"
+#include "i2c_bus.h"
+#include "mem_stats.h"
+#include "profile.h"
+#include "report.h"
+#include "sample_rate.h"
+#include "sensor_mic.h"
+#include "sensor_sched.h"
+#include "sample_ring.h"
+#include "flash_queue.h"
+#include "wifi_mqtt.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_ALARMS  64
+
+static struct {
+    uint64_t    duration_us;
+    bool        verbose;
+    const char *flash_image;
+} opts = { 24 * 3600 * SIM_US_PER_SEC, false, NULL };
+
+static struct {
+    uint32_t count;
+    uint64_t first_us;
+    uint64_t last_us;
+    uint64_t min_gap_us;
+    uint64_t max_gap_us;
+    uint64_t last_len;
+} pubs = { 0, 0, 0, UINT64_MAX, 0, 0 };
+
+static struct {
+    uint64_t on_us;
+    uint64_t latency_us;
+    uint64_t alert_us;      /* Out-of-band publish of the alarm */
+    uint64_t off_us;
+} alarms[MAX_ALARMS];
+static int alarm_count;
+
+static struct timespec wall_start;
+
+static bool parse_duration(const char *s, uint64_t *us)
+{
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || v < 0.0) return false;
+    double scale = 1.0;
+    switch (*end) {
+    case 'd': scale = 86400.0; end++; break;
+    case 'h': scale = 3600.0;  end++; break;
+    case 'm': scale = 60.0;    end++; break;
+    case 's': end++; break;
+    default: break;
+    }
+    if (*end != '\0' && *end != ',') return false;
+    *us = (uint64_t)(v * scale * (double)SIM_US_PER_SEC);
+    return true;
+}
+
+static void on_publish(const char *topic, const char *msg, size_t len,
+                       uint64_t now_us)
+{
+    /* Diagnostics run on their own period; keep them out of the
+     * publish cadence */
+    if (strcmp(topic, MQTT_TOPIC_DIAG) != 0) {
+        if (pubs.count > 0) {
+            uint64_t gap = now_us - pubs.last_us;
+            if (gap < pubs.min_gap_us) pubs.min_gap_us = gap;
+            if (gap > pubs.max_gap_us) pubs.max_gap_us = gap;
+        } else {
+            pubs.first_us = now_us;
+        }
+        pubs.count++;
+        pubs.last_us = now_us;
+        pubs.last_len = len;
+    }
+
+    if (strcmp(topic, MQTT_TOPIC_ALERT) == 0 && alarm_count > 0 &&
+        alarms[alarm_count - 1].alert_us == 0 &&
+        len >= 5 && memcmp(msg + len - 5, "true}", 5) == 0) {
+        alarms[alarm_count - 1].alert_us = now_us;
+    }
+
+    if (opts.verbose) {
+        bool text = true;
+        for (size_t i = 0; i < len; i++) {
+            if (!isprint((unsigned char)msg[i])) text = false;
+        }
+        printf("[%10.3f] %s ", (double)now_us / SIM_US_PER_SEC, topic);
+        if (text) {
+            printf("%.*s\n", (int)len, msg);
+        } else {
+            /* Binary frames as hex, ready for pi/envdecode */
+            for (size_t i = 0; i < len; i++) printf("%02x", (unsigned char)msg[i]);
+            printf("\n");
+        }
+    }
+}
+
+/* Walk back to the moment the true CO level crossed the alarm threshold */
+static uint64_t co_crossing_us(uint64_t now_us)
+{
+    const uint64_t step = 10000;
+    uint64_t t = now_us;
+    while (t >= step && SimDevices_coPPM(t - step) >= CO_ALARM_PPM) t -= step;
+    return t;
+}
+
+static void on_gpio(uint_least8_t index, unsigned int value, uint64_t now_us)
+{
+    if (index != Board_GPIO_BUZZER) return;
+
+    if (value && alarm_count < MAX_ALARMS) {
+        alarms[alarm_count].on_us = now_us;
+        alarms[alarm_count].latency_us = now_us - co_crossing_us(now_us);
+        alarms[alarm_count].alert_us = 0;
+        alarms[alarm_count].off_us = 0;
+        alarm_count++;
+    } else if (!value && alarm_count > 0) {
+        alarms[alarm_count - 1].off_us = now_us;
+    }
+    if (opts.verbose) {
+        printf("[%10.3f] buzzer %s (true CO %.1f ppm)\n",
+               (double)now_us / SIM_US_PER_SEC, value ? "ON" : "off",
+               SimDevices_coPPM(now_us));
+    }
+}
+
+static void report(void)
+{
+    struct timespec wall_end;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &wall_end);
+    double wall = (double)(wall_end.tv_sec - wall_start.tv_sec) +
+                  (double)(wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+    double virt = (double)SimClock_nowUs() / SIM_US_PER_SEC;
+
+    SimClockStats_t clk;
+    SimNetStats_t net;
+    SimClock_getStats(&clk);
+    SimNet_getStats(&net);
+
+    printf("\n=== Simulation report ===\n");
+    printf("virtual time      %.1f s (%.2f days) in %.2f s wall (%.0fx)\n",
+           virt, virt / 86400.0, wall, wall > 0.0 ? virt / wall : 0.0);
+    printf("driver wait       %.3f s summed over tasks (%.3f%% of virtual time)\n",
+           (double)clk.busy_us / SIM_US_PER_SEC,
+           virt > 0.0 ? 100.0 * (double)clk.busy_us / SIM_US_PER_SEC / virt : 0.0);
+    printf("wakeups           %u, host cpu/wakeup mean %.2f us, max %.2f us\n",
+           clk.wakeups,
+           clk.wakeups ? (double)clk.host_ns_total / clk.wakeups / 1000.0 : 0.0,
+           (double)clk.host_ns_max / 1000.0);
+
+    printf("interrupts        %u\n", clk.irqs);
+
+    SimPowerStats_t pwr;
+    SimPower_getStats(&pwr);
+    printf("mcu idle          %u LPDS entries, %.2f%% of time in LPDS, %.2f%% in WFI "
+           "(%.2f%% held out of LPDS)\n",
+           pwr.lpds_entries, 100.0 * pwr.lpds_us / SIM_US_PER_SEC / virt,
+           100.0 * pwr.wfi_us / SIM_US_PER_SEC / virt,
+           100.0 * pwr.held_us / SIM_US_PER_SEC / virt);
+
+    static const char *const parts[ENERGY_COMPONENTS] = {
+        "mcu", "nwp", "sgp30", "mq7", "mic"
+    };
+    EnergyStats_t energy;
+    Energy_getStats(&energy);
+    printf("energy            mean %.1f mW, %.1f J, runtime %u h on %u mWh, "
+           "%u LPDS entries\n",
+           energy.mean_uw / 1000.0, energy.energy_mj / 1000.0, energy.runtime_h,
+           ENERGY_BATTERY_MWH, energy.lpds_entries);
+    for (int i = 0; i < ENERGY_COMPONENTS; i++) {
+        const EnergyCompStats_t *c = &energy.comp[i];
+        double total = (double)(c->ms[ENERGY_OFF] + c->ms[ENERGY_SLEEP] + c->ms[ENERGY_AWAKE]);
+        if (total <= 0.0) total = 1.0;
+        printf("  %-6s          awake %6.2f%%, asleep %6.2f%%, off %6.2f%%, %10.1f J\n",
+               parts[i], 100.0 * c->ms[ENERGY_AWAKE] / total,
+               100.0 * c->ms[ENERGY_SLEEP] / total, 100.0 * c->ms[ENERGY_OFF] / total,
+               c->energy_mj / 1000.0);
+    }
+
+    static const char *const phases[BOOT_PHASES] = {
+        "wifi up", "mqtt up", "first sample", "first valid", "first publish"
+    };
+    printf("boot             ");
+    for (int i = 0; i < BOOT_PHASES; i++) {
+        uint32_t ms = BootTime_get((BootPhase_t)i);
+        if (ms == BOOT_NOT_REACHED) {
+            printf(" %s -%s", phases[i], i + 1 < BOOT_PHASES ? "," : "\n");
+        } else {
+            printf(" %s %.3f s%s", phases[i], ms / 1000.0,
+                   i + 1 < BOOT_PHASES ? "," : "\n");
+        }
+    }
+
+    printf("publishes         %u ok, %u failed, %llu bytes (last %llu B)\n",
+           net.publishes, net.publish_failures,
+           (unsigned long long)net.bytes, (unsigned long long)pubs.last_len);
+    if (pubs.count > 1) {
+        printf("publish interval  min %.3f s, mean %.3f s, max %.3f s\n",
+               (double)pubs.min_gap_us / SIM_US_PER_SEC,
+               (double)(pubs.last_us - pubs.first_us) / (pubs.count - 1) / SIM_US_PER_SEC,
+               (double)pubs.max_gap_us / SIM_US_PER_SEC);
+    }
+    printf("mqtt connects     %u ok, %u failed\n",
+           net.connects, net.connect_failures);
+
+    ConnStats_t conn;
+    Conn_getStats(&conn);
+    printf("connection        %u tries, %u failed, %u wifi drops (%u by sim), "
+           "%u mqtt drops, %u nwp restarts, %u dns lookups\n",
+           conn.attempts, conn.failures, conn.wlan_drops, net.wlan_drops,
+           conn.mqtt_drops, conn.nwp_restarts, conn.dns_lookups);
+    printf("  last connect    %s, %s: nwp %u ms, assoc %u ms, ip %u ms, "
+           "dns %u ms, broker %u ms, total %u ms\n",
+           conn.fast_connect ? "profile join" : "explicit join",
+           conn.static_ip ? "static ip" : "dhcp",
+           conn.phases.nwp_ms, conn.phases.assoc_ms, conn.phases.ip_ms,
+           conn.phases.dns_ms, conn.phases.broker_ms, conn.phases.total_ms);
+    if (conn.reconnects > 0) {
+        printf("  reconnects      %u, latency last %.3f s, mean %.3f s, max %.3f s\n",
+               conn.reconnects, conn.latency_last_ms / 1000.0,
+               (double)conn.latency_sum_ms / conn.reconnects / 1000.0,
+               conn.latency_max_ms / 1000.0);
+    }
+    if (conn.wakes > 0) {
+        printf("  radio wakes     %u, last to broker in %u ms\n",
+               conn.wakes, conn.phases.total_ms);
+    }
+
+    ReportStats_t report;
+    Report_getStats(&report);
+    printf("report            %u full, %u partial, %u suppressed samples; "
+           "%u of %u fields sent\n",
+           report.full, report.partial, report.suppressed, report.fields_sent,
+           report.fields_sent + report.fields_suppressed);
+
+    SampleRateStats_t rate;
+    SampleRate_getStats(&rate);
+    printf("sample interval   %u s now, %u s shortest; %u changes faster, %u slower\n",
+           rate.interval_ms / 1000, rate.min_ms / 1000, rate.faster, rate.slower);
+
+    MemStats_t mem;
+    MemStats_get(&mem);
+    printf("memory            heap %u B free, %u B least; host stack used co %zu, "
+           "sensor %zu, mic %zu, net %zu B\n",
+           mem.heap_free, mem.heap_min,
+           SIM_TASK_STACK - (size_t)mem.stack_free[MEM_TASK_CO],
+           SIM_TASK_STACK - (size_t)mem.stack_free[MEM_TASK_SENSOR],
+           SIM_TASK_STACK - (size_t)mem.stack_free[MEM_TASK_MIC],
+           SIM_TASK_STACK - (size_t)mem.stack_free[MEM_TASK_NET]);
+
+    SampleRingStats_t ring;
+    SampleRing_getStats(&ring);
+    printf("sample ring       %u pushed, %u drained, %u overwritten, "
+           "depth %u, high water %u/%u\n",
+           ring.pushed, ring.consumed, ring.overwritten,
+           ring.depth, ring.high_water, SAMPLE_RING_DEPTH);
+
+#if PROFILE_ENABLE
+    printf("profile           runs  min/mean/max us\n");
+    for (int i = 0; i < PROFILE_SCOPES; i++) {
+        ProfileStats_t prof;
+        const char *name;
+        Profile_get((ProfileScope_t)i, &prof, &name);
+        if (prof.count == 0) continue;
+        printf("  %-15s %6u  %u/%u/%u\n", name, prof.count,
+               prof.min / 80, (uint32_t)(prof.sum / prof.count / 80), prof.max / 80);
+    }
+#endif
+
+    FlashQueueStats_t fq;
+    SimFsStats_t fs;
+    FlashQueue_getStats(&fq);
+    SimFs_getStats(&fs);
+    printf("flash queue       %u spilled, %u replayed, %u recovered, %u dropped, "
+           "%u queued in %u segments, %u errors\n",
+           fq.spilled, fq.replayed, fq.recovered, fq.dropped,
+           fq.queued, fq.segments, fq.errors);
+    printf("flash fs          %u files written, %u deleted, %llu B written, "
+           "peak %u blocks (%u KB)\n",
+           fs.commits, fs.deletes, (unsigned long long)fs.bytes_written,
+           fs.peak_blocks, fs.peak_blocks * 4);
+    if (opts.flash_image != NULL && !SimFs_save(opts.flash_image)) {
+        fprintf(stderr, "cannot save flash image %s\n", opts.flash_image);
+    }
+
+    for (SimI2CDevice *d = SimI2C_devices(); d != NULL; d = d->next) {
+        printf("i2c %-8s      %u transfers, %u errors\n",
+               d->name, d->transfers, d->errors);
+    }
+    I2CBusStats_t bus;
+    I2CBus_getStats(&bus);
+    printf("i2c engine        %u transactions, %u errors, %.3f%% bus busy, "
+           "queue max %u, %u cancelled, %u abandoned\n",
+           bus.total.transactions, bus.total.errors,
+           bus.elapsed_us ? 100.0 * (double)bus.total.bus_us / bus.elapsed_us : 0.0,
+           bus.queued_max, bus.cancelled, bus.abandoned);
+    for (const I2CBusDevice *d = I2CBus_devices(); d != NULL; d = d->next) {
+        printf("  %-8s        %u transactions, %u errors, %.3f s on the bus\n",
+               d->name, d->counts.transactions, d->counts.errors,
+               (double)d->counts.bus_us / SIM_US_PER_SEC);
+    }
+    SensorSchedStats_t sched;
+    for (uint8_t i = 0; SensorSched_getStats(i, &sched); i++) {
+        printf("sched %-8s    %u runs, %u skipped, max %u ms late\n",
+               sched.name, sched.runs, sched.skipped, sched.late_max_ms);
+    }
+    SimDeviceStats_t dev;
+    SimDevices_getStats(&dev);
+    printf("sgp30 cadence     max %.3f s between measure_iaq\n",
+           (double)dev.sgp30_max_gap_us / SIM_US_PER_SEC);
+
+    MICStats_t mic;
+    MIC_getStats(&mic);
+    printf("mic capture       %u buffers (%.1f/s), %u windows, %u errors, "
+           "%u overruns\n",
+           mic.buffers, virt > 0.0 ? mic.buffers / virt : 0.0,
+           mic.windows, mic.errors, mic.overruns);
+
+    COAlarmStats_t co;
+    COAlarm_getStats(&co);
+    printf("co alarms         %d; %u readings, max period %u ms, "
+           "filter latency max %u ms\n",
+           alarm_count, co.samples, co.max_period_ms, co.max_latency_ms);
+    for (int i = 0; i < alarm_count; i++) {
+        printf("  on at %.1f s, latency %.3f s after threshold, ",
+               (double)alarms[i].on_us / SIM_US_PER_SEC,
+               (double)alarms[i].latency_us / SIM_US_PER_SEC);
+        if (alarms[i].alert_us) {
+            printf("alert sent +%.3f s, ",
+                   (double)(alarms[i].alert_us - alarms[i].on_us) / SIM_US_PER_SEC);
+        } else {
+            printf("alert not sent, ");
+        }
+        if (alarms[i].off_us) {
+            printf("off at %.1f s\n", (double)alarms[i].off_us / SIM_US_PER_SEC);
+        } else {
+            printf("still active\n");
+        }
+    }
+
+    exit(0);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-d DURATION] [-c START,PEAK_PPM[,LEN[,RAMP]]] [-o START,LEN]\n"
+            "       [-w START,LEN] [-f FLASH_IMAGE] [-v]\n",
+            prog);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    SimScenario_t sc = {0};
+    sc.co_baseline_ppm = 2.0;
+    sc.co_event_len_us = 3600 * SIM_US_PER_SEC;
+    sc.co_event_ramp_us = 600 * SIM_US_PER_SEC;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "-v") == 0) {
+            opts.verbose = true;
+        } else if (strcmp(arg, "-d") == 0 && val) {
+            if (!parse_duration(val, &opts.duration_us)) usage(argv[0]);
+            i++;
+        } else if (strcmp(arg, "-c") == 0 && val) {
+            const char *peak = strchr(val, ',');
+            if (!peak || !parse_duration(val, &sc.co_event_start_us)) usage(argv[0]);
+            sc.co_event_peak_ppm = strtod(peak + 1, NULL);
+            const char *len = strchr(peak + 1, ',');
+            if (len && !parse_duration(len + 1, &sc.co_event_len_us)) usage(argv[0]);
+            const char *ramp = len ? strchr(len + 1, ',') : NULL;
+            if (ramp && !parse_duration(ramp + 1, &sc.co_event_ramp_us)) usage(argv[0]);
+            i++;
+        } else if (strcmp(arg, "-o") == 0 && val) {
+            uint64_t start, len;
+            const char *l = strchr(val, ',');
+            if (!l || !parse_duration(val, &start) || !parse_duration(l + 1, &len)) {
+                usage(argv[0]);
+            }
+            SimNet_setOutage(start, len);
+            i++;
+        } else if (strcmp(arg, "-w") == 0 && val) {
+            uint64_t start, len;
+            const char *l = strchr(val, ',');
+            if (!l || !parse_duration(val, &start) || !parse_duration(l + 1, &len)) {
+                usage(argv[0]);
+            }
+            SimNet_setApOutage(start, len);
+            i++;
+        } else if (strcmp(arg, "-f") == 0 && val) {
+            opts.flash_image = val;
+            i++;
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    if (opts.flash_image != NULL) SimFs_load(opts.flash_image);
+    SimDevices_attach(&sc);
+    SimNet_setSink(on_publish);
+    SimGPIO_watch(on_gpio);
+    SimClock_setLimit(opts.duration_us, report);
+
+    App_init();
+    SimTask_create("co", CO_TASK_PRIORITY, coThread);
+    SimTask_create("sensor", SENSOR_TASK_PRIORITY, sensorThread);
+    SimTask_create("mic", MIC_TASK_PRIORITY, micThread);
+    SimTask_create("net", NET_TASK_PRIORITY, netThread);
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &wall_start);
+    SimTask_run();
+    return 0;
+}
@@ -0,0 +1,483 @@
+/*
+ * sim_net.c - Simulated SimpleLink NWP and MQTT broker
+ *
+ * The NWP associates with the access point and obtains a DHCP lease
+ * after fixed virtual delays, reporting each step through the
+ * SimpleLink event handlers from an interrupt, as the host driver's
+ * event task would. The Wi-Fi profile, connection and power policies
+ * and static address live in an NWP system file, so they survive a simulated
+ * reset (-f); with the auto + fast policy the NWP joins by itself on
+ * start, skipping the scan once it has joined the AP before. During
+ * an access point outage joins fail and an established link is dropped
+ * with a disconnect event, after which an auto-connect NWP tries once
+ * to rejoin by itself. The broker
+ * accepts connections and publishes except during a configured outage
+ * window; an outage also drops any established session, as a broker
+ * restart would. Each MQTT client holds a block of the FreeRTOS heap
+ * from create to delete, standing in for the library's client context.
+ */
+
+#include <ti/drivers/net/wifi/simplelink.h>
+#include <ti/net/mqtt/mqttclient.h>
+#include <FreeRTOS.h>
+
+#include "sim.h"
+
+#include <string.h>
+
+#define NWP_START_US        50000       /* sl_Start: NWP boot */
+#define WLAN_ASSOC_US       1500000     /* Scan + auth + association */
+#define WLAN_FAST_ASSOC_US  300000      /* Fast connect: known AP, no scan */
+#define DHCP_LEASE_US       1000000     /* DHCP DORA after association */
+#define NWP_CFG_WRITE_US    25000       /* Profile/policy/netcfg to NWP flash */
+#define DNS_LOOKUP_US       30000
+#define MQTT_CONNECT_US     20000       /* TCP handshake + CONNECT/CONNACK */
+#define MQTT_PUBLISH_US     3000        /* QoS0 send through the NWP */
+#define MQTT_TIMEOUT_US     3000000     /* Connect attempt against a dead broker */
+#define MQTT_CLIENT_HEAP    512         /* Client context, stand-in size */
+
+static bool     nwp_started;
+static uint64_t ip_ready_us = UINT64_MAX;
+
+/* Link progress; each step is one firing of link_irq */
+typedef enum { LINK_IDLE, LINK_ASSOC, LINK_DHCP, LINK_UP } SimLink;
+static SimLink  link;
+static int      link_irq = -1;
+
+#define NWP_CFG_FILE        "/sys/sim_nwp_cfg"
+
+typedef struct {
+    uint8_t  policy;            /* SL_WLAN_POLICY_CONNECTION bits */
+    uint8_t  pm;                /* SL_WLAN_POLICY_PM option */
+    uint8_t  profile;           /* A profile is stored */
+    uint8_t  known_ap;          /* Joined before: fast connect possible */
+    uint8_t  static_ip;
+    uint8_t  ssid_len;
+    char     ssid[32];
+    SlNetCfgIpV4Args_t ip;      /* Static address */
+} SimNwpCfg;
+
+static SimNwpCfg cfg;
+static bool      cfg_loaded;
+
+static uint64_t outage_start = UINT64_MAX;
+static uint64_t outage_end = UINT64_MAX;
+static uint64_t ap_outage_start = UINT64_MAX;
+static uint64_t ap_outage_end = UINT64_MAX;
+static SimMQTTSinkFxn sink;
+static SimNetStats_t stats;
+
+typedef struct {
+    bool     created;
+    bool     connected;
+    uint64_t connected_at;
+    void    *context;           /* Heap block while created */
+} SimMQTTClient;
+
+static SimMQTTClient client;
+
+void SimNet_setOutage(uint64_t start_us, uint64_t len_us)
+{
+    outage_start = start_us;
+    outage_end = start_us + len_us;
+}
+
+void SimNet_setApOutage(uint64_t start_us, uint64_t len_us)
+{
+    ap_outage_start = start_us;
+    ap_outage_end = start_us + len_us;
+}
+
+void SimNet_setSink(SimMQTTSinkFxn fxn)
+{
+    sink = fxn;
+}
+
+bool SimNet_nwpStarted(void)
+{
+    return nwp_started;
+}
+
+void SimNet_getStats(SimNetStats_t *out)
+{
+    *out = stats;
+}
+
+static bool broker_up(uint64_t now)
+{
+    return now < outage_start || now >= outage_end;
+}
+
+/* A session survives only if no outage began after it was established */
+static bool session_alive(uint64_t now)
+{
+    if (!client.connected) return false;
+    if (outage_start != UINT64_MAX &&
+        client.connected_at < outage_start && now >= outage_start) {
+        client.connected = false;
+    }
+    return client.connected;
+}
+
+static bool ap_up(uint64_t now)
+{
+    return now < ap_outage_start || now >= ap_outage_end;
+}
+
+static void wlan_event(uint32_t id)
+{
+    SlWlanEvent_t ev = { .Id = id };
+    SimpleLinkWlanEventHandler(&ev);
+}
+
+static void link_step(void *arg);
+
+static void save_cfg(void)
+{
+    SimFs_putSystem(NWP_CFG_FILE, &cfg, sizeof(cfg));
+}
+
+static bool auto_connect(void)
+{
+    return (cfg.policy & SL_WLAN_CONNECTION_POLICY(1, 0, 0, 0)) && cfg.profile;
+}
+
+static void begin_assoc(uint64_t delay_us)
+{
+    if (link_irq < 0) link_irq = SimIrq_create(link_step, NULL);
+    link = LINK_ASSOC;
+    SimIrq_schedule(link_irq, SimClock_nowUs() + delay_us);
+}
+
+/* Join from the stored profile, as the NWP does by itself */
+static void begin_auto_assoc(void)
+{
+    bool fast = cfg.known_ap && (cfg.policy & SL_WLAN_CONNECTION_POLICY(0, 1, 0, 0));
+    begin_assoc(fast ? WLAN_FAST_ASSOC_US : WLAN_ASSOC_US);
+}
+
+static void link_step(void *arg)
+{
+    (void)arg;
+    uint64_t now = SimClock_nowUs();
+
+    switch (link) {
+    case LINK_ASSOC:
+        if (!ap_up(now)) {
+            link = LINK_IDLE;
+            wlan_event(SL_WLAN_EVENT_DISCONNECT);   /* AP not found */
+            break;
+        }
+        if (!cfg.known_ap) {
+            cfg.known_ap = 1;
+            save_cfg();
+        }
+        link = LINK_DHCP;
+        wlan_event(SL_WLAN_EVENT_CONNECT);
+        if (!cfg.static_ip) {
+            SimIrq_schedule(link_irq, now + DHCP_LEASE_US);
+            break;
+        }
+        /* Static address: up at once */
+        /* fall through */
+    case LINK_DHCP: {
+        link = LINK_UP;
+        ip_ready_us = now;
+        if (ap_outage_start > now) SimIrq_schedule(link_irq, ap_outage_start);
+        SlNetAppEvent_t ev = { .Id = SL_NETAPP_EVENT_IPV4_ACQUIRED };
+        ev.Data.IpAcquiredV4.Ip = cfg.static_ip ? cfg.ip.Ip : 0xC0A80132;  /* 192.168.1.50 */
+        ev.Data.IpAcquiredV4.Gateway = 0xC0A80101;
+        ev.Data.IpAcquiredV4.Dns = 0xC0A80101;
+        SimpleLinkNetAppEventHandler(&ev);
+        break;
+    }
+    case LINK_UP:
+        /* The AP went away under an established link */
+        link = LINK_IDLE;
+        ip_ready_us = UINT64_MAX;
+        client.connected = false;
+        stats.wlan_drops++;
+        if (auto_connect()) begin_auto_assoc();
+        wlan_event(SL_WLAN_EVENT_DISCONNECT);
+        break;
+    default:
+        break;
+    }
+}
+
+static void link_reset(void)
+{
+    link = LINK_IDLE;
+    ip_ready_us = UINT64_MAX;
+    if (link_irq >= 0) SimIrq_schedule(link_irq, UINT64_MAX);
+}
+
+/* ---- SimpleLink ---- */
+
+int16_t sl_Start(const void *pIfHdl, signed char *pDevName, const void *pInitCallBack)
+{
+    (void)pIfHdl;
+    (void)pDevName;
+    (void)pInitCallBack;
+    SimClock_busy(NWP_START_US);
+    nwp_started = true;
+    if (!cfg_loaded) {
+        SimFs_getSystem(NWP_CFG_FILE, &cfg, sizeof(cfg));
+        cfg_loaded = true;
+    }
+    if (auto_connect()) begin_auto_assoc();
+    return ROLE_STA;
+}
+
+int16_t sl_Stop(const uint16_t Timeout)
+{
+    (void)Timeout;
+    nwp_started = false;
+    link_reset();
+    client.connected = false;
+    return 0;
+}
+
+int16_t sl_WlanSetMode(const uint8_t Mode)
+{
+    (void)Mode;
+    return 0;
+}
+
+int16_t sl_WlanConnect(const signed char *pName, const int16_t NameLen,
+                       const uint8_t *pMacAddr,
+                       const SlWlanSecParams_t *pSecParams,
+                       const SlWlanSecParamsExt_t *pSecExtParams)
+{
+    (void)pName;
+    (void)NameLen;
+    (void)pMacAddr;
+    (void)pSecParams;
+    (void)pSecExtParams;
+    if (!nwp_started) return -1;
+    link_reset();
+    begin_assoc(WLAN_ASSOC_US);
+    return 0;
+}
+
+int16_t sl_WlanDisconnect(void)
+{
+    link_reset();
+    return 0;
+}
+
+int16_t sl_NetCfgGet(const uint16_t ConfigId, uint16_t *pConfigOpt,
+                     uint16_t *pConfigLen, uint8_t *pValues)
+{
+    if (ConfigId != SL_NETCFG_IPV4_STA_ADDR_MODE ||
+        *pConfigLen < sizeof(SlNetCfgIpV4Args_t)) {
+        return -1;
+    }
+
+    SlNetCfgIpV4Args_t ip = {0};
+    if (cfg.static_ip) {
+        ip = cfg.ip;
+    } else if (nwp_started && link == LINK_UP) {
+        ip.Ip = 0xC0A80132;          /* 192.168.1.50 */
+        ip.IpMask = 0xFFFFFF00;
+        ip.IpGateway = 0xC0A80101;
+        ip.IpDnsServer = 0xC0A80101;
+    }
+    *pConfigOpt = cfg.static_ip ? 0 : 1;    /* DHCP on */
+    *pConfigLen = sizeof(ip);
+    memcpy(pValues, &ip, sizeof(ip));
+    return 0;
+}
+
+int16_t sl_NetCfgSet(const uint16_t ConfigId, const uint16_t ConfigOpt,
+                     const uint16_t ConfigLen, const uint8_t *pValues)
+{
+    if (ConfigId != SL_NETCFG_IPV4_STA_ADDR_MODE) return -1;
+    if (ConfigOpt == SL_NETCFG_ADDR_STATIC) {
+        if (ConfigLen < sizeof(cfg.ip)) return -1;
+        memcpy(&cfg.ip, pValues, sizeof(cfg.ip));
+        cfg.static_ip = 1;
+    } else {
+        cfg.static_ip = 0;
+    }
+    SimClock_busy(NWP_CFG_WRITE_US);
+    save_cfg();
+    return 0;
+}
+
+int16_t sl_WlanProfileAdd(const signed char *pName, const int16_t NameLen,
+                          const uint8_t *pMacAddr,
+                          const SlWlanSecParams_t *pSecParams,
+                          const SlWlanSecParamsExt_t *pSecExtParams,
+                          const uint32_t Priority, const uint32_t Options)
+{
+    (void)pMacAddr;
+    (void)pSecParams;
+    (void)pSecExtParams;
+    (void)Priority;
+    (void)Options;
+    if (cfg.profile || NameLen < 0 || NameLen > (int16_t)sizeof(cfg.ssid)) return -1;
+    cfg.profile = 1;
+    cfg.known_ap = 0;
+    cfg.ssid_len = (uint8_t)NameLen;
+    memcpy(cfg.ssid, pName, (size_t)NameLen);
+    SimClock_busy(NWP_CFG_WRITE_US);
+    save_cfg();
+    return 0;
+}
+
+int16_t sl_WlanProfileGet(const int16_t Index, signed char *pName,
+                          int16_t *pNameLen, uint8_t *pMacAddr,
+                          SlWlanSecParams_t *pSecParams,
+                          SlWlanGetSecParamsExt_t *pSecExtParams,
+                          uint32_t *pPriority)
+{
+    (void)pMacAddr;
+    (void)pSecExtParams;
+    if (Index != 0 || !cfg.profile) return -1;
+    memcpy(pName, cfg.ssid, cfg.ssid_len);
+    *pNameLen = cfg.ssid_len;
+    pSecParams->Type = SL_WLAN_SEC_TYPE_WPA_WPA2;
+    pSecParams->Key = NULL;          /* Keys are never returned */
+    pSecParams->KeyLen = 0;
+    *pPriority = 0;
+    return 0;
+}
+
+int16_t sl_WlanProfileDel(const int16_t Index)
+{
+    if (Index != 0 && Index != SL_WLAN_DEL_ALL_PROFILES) return -1;
+    if (cfg.profile) {
+        cfg.profile = 0;
+        cfg.known_ap = 0;
+        SimClock_busy(NWP_CFG_WRITE_US);
+        save_cfg();
+    }
+    return 0;
+}
+
+int16_t sl_WlanPolicySet(const uint8_t Type, const uint8_t Policy,
+                         uint8_t *pVal, const uint8_t ValLen)
+{
+    (void)pVal;
+    (void)ValLen;
+    if (Type == SL_WLAN_POLICY_CONNECTION) {
+        cfg.policy = Policy;
+    } else if (Type == SL_WLAN_POLICY_PM) {
+        cfg.pm = Policy;
+    } else {
+        return -1;
+    }
+    SimClock_busy(NWP_CFG_WRITE_US);
+    save_cfg();
+    return 0;
+}
+
+int16_t sl_WlanPolicyGet(const uint8_t Type, uint8_t *pPolicy,
+                         uint8_t *pVal, uint8_t *pValLen)
+{
+    (void)pVal;
+    if (Type == SL_WLAN_POLICY_CONNECTION) {
+        *pPolicy = cfg.policy;
+    } else if (Type == SL_WLAN_POLICY_PM) {
+        *pPolicy = cfg.pm;
+    } else {
+        return -1;
+    }
+    *pValLen = 0;
+    return 0;
+}
+
+int16_t sl_NetAppDnsGetHostByName(signed char *pHostName,
+                                  const uint16_t NameLen,
+                                  uint32_t *OutIpAddr, const uint8_t Family)
+{
+    (void)pHostName;
+    (void)NameLen;
+    if (Family != SL_AF_INET || !nwp_started || link != LINK_UP) return -1;
+    SimClock_busy(DNS_LOOKUP_US);
+    *OutIpAddr = 0xC0A80164;         /* 192.168.1.100, the broker */
+    return 0;
+}
+
+/* ---- MQTT client ---- */
+
+MQTTClient_Handle MQTTClient_create(MQTTClient_EventCB defaultCallback,
+                                    MQTTClient_Params *attrib)
+{
+    (void)defaultCallback;
+    (void)attrib;
+    if (client.created) return NULL;
+    void *context = pvPortMalloc(MQTT_CLIENT_HEAP);
+    if (context == NULL) return NULL;
+    memset(&client, 0, sizeof(client));
+    client.created = true;
+    client.context = context;
+    return &client;
+}
+
+int16_t MQTTClient_delete(MQTTClient_Handle handle)
+{
+    SimMQTTClient *c = handle;
+    vPortFree(c->context);
+    c->context = NULL;
+    c->created = false;
+    c->connected = false;
+    return 0;
+}
+
+int16_t MQTTClient_connect(MQTTClient_Handle handle)
+{
+    SimMQTTClient *c = handle;
+    uint64_t now = SimClock_nowUs();
+
+    if (!nwp_started || now < ip_ready_us || !broker_up(now)) {
+        SimClock_busy(MQTT_TIMEOUT_US);
+        stats.connect_failures++;
+        return -1;
+    }
+    SimClock_busy(MQTT_CONNECT_US);
+    c->connected = true;
+    c->connected_at = SimClock_nowUs();
+    stats.connects++;
+    return 0;
+}
+
+int16_t MQTTClient_disconnect(MQTTClient_Handle handle)
+{
+    SimMQTTClient *c = handle;
+    c->connected = false;
+    return 0;
+}
+
+int16_t MQTTClient_set(MQTTClient_Handle handle, MQTTClient_Option option,
+                       void *value, uint32_t valueLength)
+{
+    (void)handle;
+    (void)option;
+    (void)value;
+    (void)valueLength;
+    return 0;
+}
+
+int16_t MQTTClient_publish(MQTTClient_Handle handle, char *topic,
+                           uint16_t topicLen, char *msg, uint16_t msgLen,
+                           uint32_t flags)
+{
+    SimMQTTClient *c = handle;
+    (void)topicLen;
+    (void)flags;
+
+    SimClock_busy(MQTT_PUBLISH_US);
+    uint64_t now = SimClock_nowUs();
+    if (!session_alive(now) || !broker_up(now)) {
+        c->connected = false;
+        stats.publish_failures++;
+        return -1;
+    }
+
+    stats.publishes++;
+    stats.bytes += msgLen;
+    if (sink != NULL) sink(topic, msg, msgLen, now);
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * sim_power.c - Simulated CC32xx Power driver and LPDS sleep policy
+ *
+ * The simulated drivers hold PowerCC32XX_DISALLOW_LPDS while their
+ * hardware is busy, as the TI drivers do. When the scheduler finds
+ * every task blocked it asks here how the MCU spends the gap: with
+ * POWER_LPDS set, no constraint held and the gap longer than
+ * POWER_LPDS_LATENCY_US, it sleeps in LPDS until the latency before
+ * the wake-up and spends the rest waking; otherwise it waits in WFI.
+ * The notifications run like interrupt handlers, at the virtual times
+ * the MCU enters and leaves LPDS.
+ *
+ * The slow clock counter is the virtual clock at 32.768 kHz.
+ */
+
+#include <ti/drivers/Power.h>
+#include <ti/drivers/power/PowerCC32XX.h>
+#include <ti/devices/cc32xx/inc/hw_types.h>
+#include <ti/devices/cc32xx/driverlib/prcm.h>
+
+#include "sim.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static Power_NotifyObj *notify_list;
+static uint32_t lpds_holds;         /* PowerCC32XX_DISALLOW_LPDS count */
+static uint64_t lpds_from_us;
+static SimPowerStats_t stats;
+
+static void notify(uint_fast16_t event)
+{
+    for (Power_NotifyObj *n = notify_list; n != NULL; n = n->next) {
+        if (n->eventTypes & event) n->notifyFxn(event, 0, n->clientArg);
+    }
+}
+
+uint64_t SimPower_sleep(uint64_t wake_us)
+{
+    uint64_t now = SimClock_nowUs();
+    uint64_t gap = wake_us - now;
+    bool long_gap = gap > POWER_LPDS_LATENCY_US;
+
+    if (!POWER_LPDS || lpds_holds > 0 || !long_gap) {
+        stats.wfi_us += gap;
+        if (long_gap && lpds_holds > 0) stats.held_us += gap;
+        return 0;
+    }
+
+    stats.lpds_entries++;
+    stats.wfi_us += POWER_LPDS_LATENCY_US;
+    lpds_from_us = now;
+    notify(PowerCC32XX_ENTERING_LPDS);
+    return wake_us - POWER_LPDS_LATENCY_US;
+}
+
+void SimPower_wake(void)
+{
+    stats.lpds_us += SimClock_nowUs() - lpds_from_us;
+    SimReg_resetCycles();
+    notify(PowerCC32XX_AWAKE_LPDS);
+}
+
+void SimPower_getStats(SimPowerStats_t *out)
+{
+    *out = stats;
+}
+
+/* ---- Power driver ---- */
+
+void Power_init(void)
+{
+}
+
+int_fast16_t Power_registerNotify(Power_NotifyObj *notifyObj,
+                                  uint_fast16_t eventTypes,
+                                  Power_NotifyFxn notifyFxn,
+                                  uintptr_t clientArg)
+{
+    if (notifyObj == NULL || notifyFxn == NULL) return Power_EFAIL;
+    notifyObj->eventTypes = eventTypes;
+    notifyObj->notifyFxn = notifyFxn;
+    notifyObj->clientArg = clientArg;
+    notifyObj->next = notify_list;
+    notify_list = notifyObj;
+    return Power_SOK;
+}
+
+void Power_unregisterNotify(Power_NotifyObj *notifyObj)
+{
+    for (Power_NotifyObj **p = &notify_list; *p != NULL; p = &(*p)->next) {
+        if (*p == notifyObj) {
+            *p = notifyObj->next;
+            return;
+        }
+    }
+}
+
+int_fast16_t Power_setConstraint(uint_fast16_t constraintId)
+{
+    if (constraintId != PowerCC32XX_DISALLOW_LPDS) return Power_EFAIL;
+    lpds_holds++;
+    return Power_SOK;
+}
+
+int_fast16_t Power_releaseConstraint(uint_fast16_t constraintId)
+{
+    if (constraintId != PowerCC32XX_DISALLOW_LPDS) return Power_EFAIL;
+    if (lpds_holds == 0) {
+        fprintf(stderr, "sim: LPDS constraint released more often than set\n");
+        abort();
+    }
+    lpds_holds--;
+    return Power_SOK;
+}
+
+/* ---- driverlib ---- */
+
+unsigned long long PRCMSlowClkCtrGet(void)
+{
+    return SimClock_nowUs() * 32768ULL / SIM_US_PER_SEC;
+}
@@ -0,0 +1,202 @@
+/*
+ * sim_rtos.c - FreeRTOS heap, queue and task API on the sim task
+ * scheduler
+ */
+
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <task.h>
+
+#include "sim.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct QueueDefinition {
+    uint8_t    *storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint32_t    receivers;      /* Bitmask of tasks blocked in receive */
+    uint32_t    senders;        /* Bitmask of tasks blocked in send */
+};
+
+static uint64_t deadline_us(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) return UINT64_MAX;
+    return SimClock_nowUs() + (uint64_t)ticks * SIM_US_PER_SEC / configTICK_RATE_HZ;
+}
+
+/* Make every task in *mask ready; they re-check the queue themselves */
+static void wake_all(uint32_t *mask)
+{
+    uint32_t m = *mask;
+    *mask = 0;
+    for (int i = 0; m != 0; i++, m >>= 1) {
+        if (m & 1U) SimTask_wake(i);
+    }
+}
+
+/* Like heap_4 on the target, every block carries an 8-byte header and
+ * is rounded up to 8 bytes; blocks come from the host heap, but only
+ * configTOTAL_HEAP_SIZE bytes of them at a time */
+#define HEAP_ALIGN          8U
+#define HEAP_HEADER         8U
+#define HOST_HEADER         16U     /* Keeps host alignment */
+
+static size_t heap_free = configTOTAL_HEAP_SIZE;
+static size_t heap_min = configTOTAL_HEAP_SIZE;
+
+void *pvPortMalloc(size_t size)
+{
+    size_t block = (size + HEAP_HEADER + HEAP_ALIGN - 1) & ~(size_t)(HEAP_ALIGN - 1);
+    if (size == 0 || block > heap_free) return NULL;
+    uint8_t *p = malloc(HOST_HEADER + size);
+    if (p == NULL) return NULL;
+    memcpy(p, &block, sizeof(block));
+    heap_free -= block;
+    if (heap_free < heap_min) heap_min = heap_free;
+    return p + HOST_HEADER;
+}
+
+void vPortFree(void *pv)
+{
+    if (pv == NULL) return;
+    uint8_t *p = (uint8_t *)pv - HOST_HEADER;
+    size_t block;
+    memcpy(&block, p, sizeof(block));
+    heap_free += block;
+    free(p);
+}
+
+size_t xPortGetFreeHeapSize(void)
+{
+    return heap_free;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void)
+{
+    return heap_min;
+}
+
+/* ---- Queues ---- */
+
+typedef char static_queue_fits[sizeof(StaticQueue_t) >= sizeof(struct QueueDefinition) ? 1 : -1];
+
+static QueueHandle_t queue_init(QueueHandle_t q, UBaseType_t length,
+                                UBaseType_t item_size, uint8_t *storage)
+{
+    memset(q, 0, sizeof(*q));
+    q->storage = storage;
+    q->length = length;
+    q->item_size = item_size;
+    return q;
+}
+
+/* One heap block for the queue and its storage, as the kernel does */
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    uint8_t *p = pvPortMalloc(sizeof(struct QueueDefinition) + uxQueueLength * uxItemSize);
+    if (p == NULL) return NULL;
+    return queue_init((QueueHandle_t)p, uxQueueLength, uxItemSize,
+                      p + sizeof(struct QueueDefinition));
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t uxQueueLength, UBaseType_t uxItemSize,
+                                 uint8_t *pucQueueStorageBuffer,
+                                 StaticQueue_t *pxStaticQueue)
+{
+    return queue_init((QueueHandle_t)pxStaticQueue, uxQueueLength, uxItemSize,
+                      pucQueueStorageBuffer);
+}
+
+static BaseType_t send(QueueHandle_t q, const void *item, TickType_t ticks,
+                       bool front)
+{
+    uint64_t deadline = deadline_us(ticks);
+    while (q->count == q->length) {
+        if (SimClock_nowUs() >= deadline) return errQUEUE_FULL;
+        q->senders |= 1U << SimTask_self();
+        SimTask_wait(deadline);
+        q->senders &= ~(1U << SimTask_self());
+    }
+
+    UBaseType_t slot;
+    if (front) {
+        q->head = (q->head + q->length - 1) % q->length;
+        slot = q->head;
+    } else {
+        slot = (q->head + q->count) % q->length;
+    }
+    memcpy(q->storage + slot * q->item_size, item, q->item_size);
+    q->count++;
+    wake_all(&q->receivers);
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    return send(q, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    return send(q, item, ticks, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *buf, TickType_t ticks)
+{
+    uint64_t deadline = deadline_us(ticks);
+    while (q->count == 0) {
+        if (SimClock_nowUs() >= deadline) return errQUEUE_EMPTY;
+        q->receivers |= 1U << SimTask_self();
+        SimTask_wait(deadline);
+        q->receivers &= ~(1U << SimTask_self());
+    }
+
+    memcpy(buf, q->storage + q->head * q->item_size, q->item_size);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    wake_all(&q->senders);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    return q->count;
+}
+
+/* ---- Tasks ---- */
+
+#define SIM_US_PER_TICK     (SIM_US_PER_SEC / configTICK_RATE_HZ)
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(SimClock_nowUs() / SIM_US_PER_TICK);
+}
+
+void vTaskDelayUntil(TickType_t *prev, TickType_t increment)
+{
+    TickType_t wake = *prev + increment;
+    *prev = wake;
+
+    /* Wake on the tick boundary, as the kernel does; a wake time that
+     * has passed (including across wrap-around) does not block */
+    int32_t ticks = (int32_t)(wake - xTaskGetTickCount());
+    if (ticks <= 0) return;
+    uint64_t wake_us = (SimClock_nowUs() / SIM_US_PER_TICK + (uint64_t)ticks) * SIM_US_PER_TICK;
+    SimClock_idle(wake_us - SimClock_nowUs());
+}
+
+/* Handles are task indices plus one, so none is NULL */
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)(uintptr_t)(SimTask_self() + 1);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    int index = task == NULL ? SimTask_self() : (int)(uintptr_t)task - 1;
+    return (UBaseType_t)(SimTask_stackFree(index) / sizeof(StackType_t));
+}